@@ -6,72 +6,107 @@
 #include <TDirectory.h>
 #include <TKey.h>
 #include <TLeaf.h>
+#include <TH2.h>
+#include <TH3.h>
+#include <TProfile.h>
 #include <TROOT.h>
 #include <TString.h>
 #include <TSystem.h>
+#include <algorithm>
+#include <cctype>
 #include <cstdlib>
 #include <ctime>
 #include <dlfcn.h>
 #include <filesystem>
 #include <fstream>
+#include <future>
+#include <limits>
 #include <nlohmann/json.hpp>
+#include <numeric>
 #include <regex>
 #include <sstream>
-#include <sys/stat.h>
 using namespace logger;
+using cascade::analysis_detail::FileIdentity;
+using cascade::analysis_detail::IsWord;
+using cascade::analysis_detail::LambdaTarget;
+using cascade::analysis_detail::RNTUPLE_CLASS;
+using cascade::analysis_detail::RewriteWords;
 using cascade::analysis_detail::SafeColumnName;
 using cascade::analysis_detail::ValidateHistogramBins;
 
 namespace
 {
+// TTree::Branch's own default, used when the output settings leave the basket size unset.
+constexpr int DEFAULT_BASKET_SIZE = 32000;
+
 std::string EscapeRegex(const std::string &text)
 {
     static const std::regex special(R"([-[\]{}()*+?.,\^$|#\s])");
     return std::regex_replace(text, special, R"(\$&)");
 }
 
-void DeleteBranchPointer(const std::string &type, void *pointer)
+std::optional<BranchValueType> ParseBranchType(const std::string &type)
 {
-    if (type == "Double_t" || type == "double")
+    if (type == "Double_t" || type == "double") return BranchValueType::Double;
+    if (type == "Float_t" || type == "float") return BranchValueType::Float;
+    if (type == "Int_t" || type == "int") return BranchValueType::Int;
+    if (type == "UInt_t" || type == "unsigned int") return BranchValueType::UInt;
+    if (type == "Long64_t" || type == "long long") return BranchValueType::Long64;
+    if (type == "ULong64_t" || type == "unsigned long long") return BranchValueType::ULong64;
+    if (type == "Bool_t" || type == "bool") return BranchValueType::Bool;
+    return std::nullopt;
+}
+
+void DeleteBranchPointer(BranchValueType type, void *pointer)
+{
+    switch (type)
+    {
+    case BranchValueType::Double:
         delete static_cast<double *>(pointer);
-    else if (type == "Float_t" || type == "float")
+        break;
+    case BranchValueType::Float:
         delete static_cast<float *>(pointer);
-    else if (type == "Int_t" || type == "int")
+        break;
+    case BranchValueType::Int:
         delete static_cast<int *>(pointer);
-    else if (type == "UInt_t" || type == "unsigned int")
+        break;
+    case BranchValueType::UInt:
         delete static_cast<unsigned int *>(pointer);
-    else if (type == "Long64_t" || type == "long long")
+        break;
+    case BranchValueType::Long64:
         delete static_cast<Long64_t *>(pointer);
-    else if (type == "ULong64_t" || type == "unsigned long long")
+        break;
+    case BranchValueType::ULong64:
         delete static_cast<ULong64_t *>(pointer);
-    else if (type == "Bool_t" || type == "bool")
+        break;
+    case BranchValueType::Bool:
         delete static_cast<bool *>(pointer);
+        break;
+    }
 }
 
-void *AllocateBranchPointer(const std::string &type)
+void *AllocateBranchPointer(BranchValueType type)
 {
-    if (type == "Double_t" || type == "double") return new double{};
-    if (type == "Float_t" || type == "float") return new float{};
-    if (type == "Int_t" || type == "int") return new int{};
-    if (type == "UInt_t" || type == "unsigned int") return new unsigned int{};
-    if (type == "Long64_t" || type == "long long") return new Long64_t{};
-    if (type == "ULong64_t" || type == "unsigned long long") return new ULong64_t{};
-    if (type == "Bool_t" || type == "bool") return new bool{};
+    switch (type)
+    {
+    case BranchValueType::Double:
+        return new double{};
+    case BranchValueType::Float:
+        return new float{};
+    case BranchValueType::Int:
+        return new int{};
+    case BranchValueType::UInt:
+        return new unsigned int{};
+    case BranchValueType::Long64:
+        return new Long64_t{};
+    case BranchValueType::ULong64:
+        return new ULong64_t{};
+    case BranchValueType::Bool:
+        return new bool{};
+    }
     return nullptr;
 }
 
-double ReadBranchPointer(const std::string &type, const void *pointer)
-{
-    if (type == "Double_t" || type == "double") return *static_cast<const double *>(pointer);
-    if (type == "Float_t" || type == "float") return *static_cast<const float *>(pointer);
-    if (type == "Int_t" || type == "int") return *static_cast<const int *>(pointer);
-    if (type == "UInt_t" || type == "unsigned int") return *static_cast<const unsigned int *>(pointer);
-    if (type == "Long64_t" || type == "long long") return static_cast<double>(*static_cast<const Long64_t *>(pointer));
-    if (type == "ULong64_t" || type == "unsigned long long") return static_cast<double>(*static_cast<const ULong64_t *>(pointer));
-    if (type == "Bool_t" || type == "bool") return *static_cast<const bool *>(pointer) ? 1.0 : 0.0;
-    throw std::runtime_error("AnalysisManager: unsupported branch type: " + type);
-}
-
 std::string CanonicalBranchType(const std::string &type)
 {
     if (type == "Double_t" || type == "double") return "double";
@@ -164,23 +199,28 @@ ConfigValidationResult AnalysisManager::PreflightInputConfig(const std::string &
         return result;
     }
     const YAML::Node files = input["files"];
-    const YAML::Node treeNode = input["tree"];
+    // input.ntuple names an RNTuple in place of input.tree.
+    const bool ntuple = static_cast<bool>(input["ntuple"]);
+    const std::string nameKey = ntuple ? "input.ntuple" : "input.tree";
+    const YAML::Node treeNode = input[ntuple ? "ntuple" : "tree"];
     if (!files || !files.IsSequence() || files.size() == 0) result.Errors.push_back("input.files must be a non-empty sequence");
-    if (!treeNode || !treeNode.IsScalar()) result.Errors.push_back("input.tree must be a non-empty string");
+    if (ntuple && input["tree"]) result.Errors.push_back("input.tree and input.ntuple cannot both be set");
+    if (!treeNode || !treeNode.IsScalar()) result.Errors.push_back(nameKey + " must be a non-empty string");
 
     const YAML::Node branches = config["branches"];
     if (!branches || !branches.IsMap()) result.Errors.push_back("branches must be a map");
+    if (config["output"]) OutputSettings::FromYaml(config["output"], result.Errors);
     if (!result.Valid()) return result;
 
     std::string treeName;
     try
     {
         treeName = treeNode.as<std::string>();
-        if (treeName.empty()) result.Errors.push_back("input.tree must be a non-empty string");
+        if (treeName.empty()) result.Errors.push_back(nameKey + " must be a non-empty string");
     }
     catch (const std::exception &)
     {
-        result.Errors.push_back("input.tree must be a string");
+        result.Errors.push_back(nameKey + " must be a string");
     }
 
     struct RequestedBranch
@@ -250,6 +290,14 @@ ConfigValidationResult AnalysisManager::PreflightInputConfig(const std::string &
             result.Errors.push_back("cannot open input file: " + filename);
             continue;
         }
+        // RNTuple fields are checked by RDataFrame when the dataframe is built.
+        if (ntuple)
+        {
+            const TKey *key = file->GetKey(treeName.c_str());
+            if (!key || std::string(key->GetClassName()) != RNTUPLE_CLASS)
+                result.Errors.push_back("ntuple '" + treeName + "' is missing from " + filename);
+            continue;
+        }
         TTree *tree = nullptr;
         file->GetObject(treeName.c_str(), tree);
         if (!tree)
@@ -283,6 +331,7 @@ ConfigValidationResult AnalysisManager::PreflightCutConfig(const std::string &ya
     const YAML::Node config = LoadConfigForValidation(yamlPath, result);
     if (!config) return result;
     ValidateSchemaVersion(config, result);
+    PreflightVariations_(config, result);
     const YAML::Node cuts = config["cuts"];
     if (!cuts || !cuts.IsMap())
     {
@@ -305,17 +354,14 @@ ConfigValidationResult AnalysisManager::PreflightCutConfig(const std::string &ya
                 result.Errors.push_back("cuts." + name + " cannot be empty");
                 continue;
             }
-            if (expression.rfind("--lambda:", 0) == 0)
+            if (const auto target = LambdaTarget(expression))
             {
-                result.Errors.push_back("cuts." + name + " cannot deserialize a lambda filter");
+                if (!FindRdfLambda_(*target, RdfLambda::Kind::Filter))
+                    result.Errors.push_back("cuts." + name + " names an unregistered lambda filter: " + *target);
                 continue;
             }
-            if (m_CurrentTree)
-            {
-                TTreeFormula formula(("cascade_preflight_cut_" + SafeColumnName(name)).c_str(), ExpandAliases_(expression).c_str(),
-                                     m_CurrentTree);
-                if (formula.GetNdim() <= 0) result.Errors.push_back("cuts." + name + " is not a valid tree expression");
-            }
+            if (m_CurrentTree && !PreflightExpression_(ExpandAliases_(expression)))
+                result.Errors.push_back("cuts." + name + " is not a valid tree expression");
         }
         catch (const std::exception &error)
         {
@@ -331,12 +377,24 @@ ConfigValidationResult AnalysisManager::PreflightHistogramConfig(const std::stri
     const YAML::Node config = LoadConfigForValidation(yamlPath, result);
     if (!config) return result;
     ValidateSchemaVersion(config, result);
+    PreflightVariations_(config, result);
     const YAML::Node histograms = config["histograms"];
     if (!histograms || !histograms.IsMap())
     {
         result.Errors.push_back("histograms must be a map");
         return result;
     }
+    if (const YAML::Node buffer = config["fill_buffer"])
+    {
+        try
+        {
+            if (!buffer.IsScalar() || buffer.as<long long>() < 0) result.Errors.push_back("fill_buffer must be a non-negative integer");
+        }
+        catch (const std::exception &)
+        {
+            result.Errors.push_back("fill_buffer must be a non-negative integer");
+        }
+    }
     for (const auto &entry : histograms)
     {
         try
@@ -348,33 +406,11 @@ ConfigValidationResult AnalysisManager::PreflightHistogramConfig(const std::stri
                 result.Errors.push_back("histogram entries must be named maps");
                 continue;
             }
-            if (!info["expr"] || !info["expr"].IsScalar())
-            {
-                result.Errors.push_back("histograms." + name + ".expr must be a non-empty string");
-                continue;
-            }
-            const std::string expression = info["expr"].as<std::string>();
-            if (expression.empty()) result.Errors.push_back("histograms." + name + ".expr cannot be empty");
-            const YAML::Node bins = info["bins"];
-            if (!bins || !bins.IsSequence() || bins.size() != 3)
-                result.Errors.push_back("histograms." + name + ".bins must contain [nbins, xmin, xmax]");
-            else
-            {
-                try
-                {
-                    ValidateHistogramBins({bins[0].as<double>(), bins[1].as<double>(), bins[2].as<double>()}, name);
-                }
-                catch (const std::exception &error)
-                {
-                    result.Errors.push_back(error.what());
-                }
-            }
-            if (m_CurrentTree && !expression.empty())
-            {
-                TTreeFormula formula(("cascade_preflight_hist_" + SafeColumnName(name)).c_str(), ExpandAliases_(expression).c_str(),
-                                     m_CurrentTree);
-                if (formula.GetNdim() <= 0) result.Errors.push_back("histograms." + name + ".expr is not a valid tree expression");
-            }
+            const auto spec = HistogramSpec::FromYaml(info, name, result.Errors);
+            if (!spec || !m_CurrentTree) continue;
+            for (std::size_t axis = 0; axis < spec->Axes.size(); ++axis)
+                if (!PreflightExpression_(ExpandAliases_(spec->Axes[axis].Expression)))
+                    result.Errors.push_back("histograms." + name + (axis == 0 ? "" : axis == 1 ? ".y" : ".z") + ".expr is not a valid tree expression");
         }
         catch (const std::exception &error)
         {
@@ -384,10 +420,107 @@ ConfigValidationResult AnalysisManager::PreflightHistogramConfig(const std::stri
     return result;
 }
 
+ConfigPreflightResult AnalysisManager::PreflightConfigs(const std::string &inputYaml, const std::string &cutYaml,
+                                                      const std::string &histogramYaml) const
+{
+    // Input preflight opens the ROOT files while the other files may build formulas over a tree.
+    ROOT::EnableThreadSafety();
+    const auto launch = [](const AnalysisManager &manager, const std::string &path,
+                           ConfigValidationResult (AnalysisManager::*preflight)(const std::string &) const)
+    {
+        return std::async(std::launch::async, [&manager, path, preflight]
+                          { return path.empty() ? ConfigValidationResult{} : (manager.*preflight)(path); });
+    };
+    auto input = launch(*this, inputYaml, &AnalysisManager::PreflightInputConfig);
+    // Expressions are checked against the schema of the given input. When this manager already reads that input, its tree is
+    // used so that enabling the cuts and booking the histograms reuse the preflighted expressions.
+    const std::unique_ptr<AnalysisManager> schema = PreflightSchema_(inputYaml);
+    const AnalysisManager &target = schema ? *schema : *this;
+    auto cuts = launch(target, cutYaml, &AnalysisManager::PreflightCutConfig);
+    auto histograms = launch(target, histogramYaml, &AnalysisManager::PreflightHistogramConfig);
+    ConfigPreflightResult result;
+    result.Input = input.get();
+    result.Cuts = cuts.get();
+    result.Histograms = histograms.get();
+    return result;
+}
+
+std::unique_ptr<AnalysisManager> AnalysisManager::PreflightSchema_(const std::string &inputYaml) const
+{
+    if (inputYaml.empty()) return nullptr;
+    auto schema = std::make_unique<AnalysisManager>();
+    try
+    {
+        schema->ReadInputConfig_(inputYaml);
+        const auto sameBranches = [this, &schema]()
+        {
+            return std::equal(m_BranchMap.begin(), m_BranchMap.end(), schema->m_BranchMap.begin(), schema->m_BranchMap.end(),
+                              [](const auto &ours, const auto &theirs) { return ours.first == theirs.first && ours.second.RealName == theirs.second.RealName; });
+        };
+        if (m_CurrentTree && schema->m_InputFiles == m_InputFiles && schema->m_InTreeName == m_InTreeName && sameBranches()) return nullptr;
+        schema->BuildChain();
+    }
+    catch (const std::exception &)
+    {
+        // The input preflight reports what is wrong with the configuration; expressions are then checked for structure only.
+        schema->ReleaseCurrentTree_();
+    }
+    // Lambda cuts are resolved by name, whatever the input.
+    if (m_LambdaManager) schema->m_LambdaManager = std::make_unique<LambdaManager>(*m_LambdaManager);
+    return schema;
+}
+
+bool AnalysisManager::PreflightExpression_(const std::string &expandedExpr) const
+{
+    {
+        std::lock_guard<std::mutex> lock(m_PreflightMutex);
+        const auto cached = m_PreflightedExpressions.find(expandedExpr);
+        if (cached != m_PreflightedExpressions.end()) return cached->second.Valid;
+    }
+    // Expressions in the compiled subset are valid without asking ROOT to parse them.
+    PreflightedExpression checked;
+    checked.Compiled = TryCompile_(expandedExpr);
+    std::lock_guard<std::mutex> lock(m_PreflightMutex);
+    if (!checked.Compiled.IsValid())
+    {
+        // Formulas register their leaves with the shared tree, so they are built one at a time.
+        const std::string name = "cascade_preflight_" + std::to_string(m_PreflightedExpressions.size());
+        checked.Formula = std::make_unique<TTreeFormula>(name.c_str(), expandedExpr.c_str(), m_CurrentTree);
+    }
+    checked.Valid = checked.Compiled.IsValid() || checked.Formula->GetNdim() > 0;
+    return m_PreflightedExpressions.emplace(expandedExpr, std::move(checked)).first->second.Valid;
+}
+
+std::optional<AnalysisManager::PreflightedExpression> AnalysisManager::TakePreflighted_(const std::string &expandedExpr) const
+{
+    std::lock_guard<std::mutex> lock(m_PreflightMutex);
+    const auto cached = m_PreflightedExpressions.find(expandedExpr);
+    if (cached == m_PreflightedExpressions.end()) return std::nullopt;
+    ++m_PreflightReuses;
+    PreflightedExpression taken;
+    taken.Valid = cached->second.Valid;
+    taken.Compiled = cached->second.Compiled;
+    // A formula has one owner; later users of the same expression build their own.
+    if (cached->second.Formula)
+    {
+        taken.Formula = std::move(cached->second.Formula);
+        m_PreflightedExpressions.erase(cached);
+    }
+    return taken;
+}
+
 void AnalysisManager::LoadInputConfig(const std::string &yamlPath)
 {
     PreflightInputConfig(yamlPath).ThrowIfInvalid(yamlPath);
     ReleaseCurrentTree_();
+    ReadInputConfig_(yamlPath);
+    for (const auto &file : m_InputFiles)
+        LOG_INFO("AnalysisManager", "File " << file << " has been loaded.");
+    LOG_INFO("AnalysisManager", "Configuration file for tree " << m_InTreeName << " with yaml " << yamlPath << " has been loaded.");
+}
+
+void AnalysisManager::ReadInputConfig_(const std::string &yamlPath)
+{
     m_InputFiles.clear();
     m_BranchMap.clear();
     YAML::Node config = YAML::LoadFile(yamlPath);
@@ -395,11 +528,14 @@ void AnalysisManager::LoadInputConfig(const std::string &yamlPath)
     if (input)
     {
         for (auto f : input["files"])
-        {
             m_InputFiles.push_back(f.as<std::string>());
-            LOG_INFO("AnalysisManager", "File " << f.as<std::string>() << " has been loaded.");
-        }
-        m_InTreeName = input["tree"].as<std::string>();
+        m_InputFormat = input["ntuple"] ? DataFormat::RNTuple : DataFormat::TTree;
+        m_InTreeName = input[m_InputFormat == DataFormat::RNTuple ? "ntuple" : "tree"].as<std::string>();
+    }
+    if (config["output"])
+    {
+        std::vector<std::string> errors;
+        SetOutputSettings(*OutputSettings::FromYaml(config["output"], errors));
     }
 
     auto node = config["branches"];
@@ -412,7 +548,7 @@ void AnalysisManager::LoadInputConfig(const std::string &yamlPath)
         if (info["type"]) binfo.Type = info["type"].as<std::string>();
         m_BranchMap[alias] = binfo;
     }
-    LOG_INFO("AnalysisManager", "Configuration file for tree " << m_InTreeName << " with yaml " << yamlPath << " has been loaded.");
+    BuildAliasTable_();
 }
 
 void AnalysisManager::LoadCutConfig(const std::string &yamlPath)
@@ -420,30 +556,45 @@ void AnalysisManager::LoadCutConfig(const std::string &yamlPath)
     if (m_UseRdf && !m_AppliedRdfCuts.empty())
         throw std::runtime_error("AnalysisManager: cannot replace cut configuration after RDF filters were applied.");
     PreflightCutConfig(yamlPath).ThrowIfInvalid(yamlPath);
-    for (auto &[_, formula] : m_CutFormulas)
-        delete formula;
-    m_CutFormulas.clear();
+    m_EnabledCuts.clear();
+    m_VariedSelections.clear();
+    ResetCutOrder_();
+    ResetCutflow_();
     m_RawCutExpr.clear();
+    m_CutSequence.clear();
     m_AppliedRdfCuts.clear();
-    YAML::Node cutsNode = YAML::LoadFile(yamlPath)["cuts"];
+    // Cut-level variations come with the cut set. A dataframe cannot drop a registered variation, so RDF keeps them.
+    if (!m_UseRdf)
+        for (auto variation = m_Variations.begin(); variation != m_Variations.end();)
+            variation = variation->second.AffectsCuts ? m_Variations.erase(variation) : std::next(variation);
+    const YAML::Node config = YAML::LoadFile(yamlPath);
+    YAML::Node cutsNode = config["cuts"];
     for (auto it : cutsNode)
     {
         std::string name = it.first.as<std::string>();
         std::string rawExpr = it.second.as<std::string>();
         m_RawCutExpr[name] = rawExpr;
+        AddToCutSequence_(name);
         LOG_INFO("AnalysisManager", "Registered cut '" << name << "' from " << yamlPath);
     }
+    LoadVariations_(config, true);
+    SyncVariedHistograms_();
     LOG_INFO("AnalysisManager", "Cut named " << yamlPath << " has been loaded.");
 }
 
 TChain *AnalysisManager::BuildChain()
 {
+    if (m_InputFormat == DataFormat::RNTuple) throw std::runtime_error("AnalysisManager: RNTuple input is read through RDF only: " + m_InTreeName);
     ReleaseCurrentTree_();
     m_CurrentTreeOwner = std::make_shared<TChain>(m_InTreeName.c_str());
     m_CurrentTree = m_CurrentTreeOwner.get();
+    // With known entry counts TChain::Add does not open the files.
+    const auto indexedEntries = IndexChainFiles_();
     int count = 0;
-    for (auto &file : m_InputFiles)
-        count += m_CurrentTree->Add(file.c_str());
+    for (std::size_t file = 0; file < m_InputFiles.size(); ++file)
+        count += indexedEntries ? m_CurrentTree->Add(m_InputFiles[file].c_str(), (*indexedEntries)[file])
+                                : m_CurrentTree->Add(m_InputFiles[file].c_str());
+    if (indexedEntries) m_EntryCount = std::accumulate(indexedEntries->begin(), indexedEntries->end(), Long64_t{0});
 
     if (count < 1)
     {
@@ -468,17 +619,19 @@ TChain *AnalysisManager::BuildChain()
             info.Type = type;
         }
 
-        void *pointer = AllocateBranchPointer(type);
-        if (!pointer)
+        const auto valueType = ParseBranchType(type);
+        if (!valueType)
         {
             throw std::runtime_error("AnalysisManager: unsupported branch type for '" + alias + "': " + type);
         }
+        void *pointer = AllocateBranchPointer(*valueType);
         if (m_CurrentTree->SetBranchAddress(realName.c_str(), pointer) < 0)
         {
-            DeleteBranchPointer(type, pointer);
+            DeleteBranchPointer(*valueType, pointer);
             throw std::runtime_error("AnalysisManager: failed to attach branch '" + realName + "' for alias '" + alias + "'.");
         }
         m_BranchData[alias] = pointer;
+        m_BranchHandles[alias] = ValueHandle(pointer, *valueType);
     }
     LOG_INFO("AnalysisManager", "Tree " << m_CurrentTree->GetName() << " is initialized.");
 
@@ -492,6 +645,7 @@ void AnalysisManager::RegisterTree(const std::string &name)
     {
         TTree *tree = new TTree(name.c_str(), name.c_str());
         tree->SetDirectory(nullptr);
+        if (m_OutputSettings.AutoFlush) tree->SetAutoFlush(*m_OutputSettings.AutoFlush);
         m_TreeMap[name] = tree;
         m_TreeOwnership[name] = ResourceOwnership::Owned;
         LOG_INFO("AnalysisManager", "Following tree is added to the lists : " << name);
@@ -519,19 +673,6 @@ void AnalysisManager::RegisterTree(TTree *tree, ResourceOwnership ownership)
         throw std::runtime_error("AnalysisManager: tree already exists: " + name);
     }
 }
-void AnalysisManager::WriteTrees(const std::string &outfile)
-{
-    TFile file(outfile.c_str(), "recreate");
-    if (file.IsZombie()) throw std::runtime_error("AnalysisManager: cannot create tree output file: " + outfile);
-    file.cd();
-    for (const auto &[_, tree] : m_TreeMap)
-    {
-        if (tree->Write(tree->GetName(), TObject::kOverwrite) < 0)
-            throw std::runtime_error("AnalysisManager: failed to write tree: " + std::string(tree->GetName()));
-    }
-    file.Close();
-    LOG_INFO("AnalysisManager", "Trees are saved in " << outfile);
-}
 void AnalysisManager::LoadHistogramConfig(const std::string &yamlPath, const std::string &prefix)
 {
     PreflightHistogramConfig(yamlPath).ThrowIfInvalid(yamlPath);
@@ -539,51 +680,31 @@ void AnalysisManager::LoadHistogramConfig(const std::string &yamlPath, const std
     auto hists = root["histograms"];
     if (!hists) return;
 
+    ResetFillPlan_();
+    if (root["fill_buffer"]) SetFillBufferSize(root["fill_buffer"].as<std::size_t>());
+    LoadVariations_(root, false);
     for (auto it : hists)
     {
-        std::string alias = it.first.as<std::string>();
-        std::string expr = it.second["expr"].as<std::string>();
-        auto bins = it.second["bins"];
-
-        if (bins.size() == 3)
-        {
-            int nbins = bins[0].as<int>();
-            double xmin = bins[1].as<double>();
-            double xmax = bins[2].as<double>();
-            const std::vector<double> binInfo{double(nbins), xmin, xmax};
-            ValidateHistogramBins(binInfo, alias);
-            auto formulaAlias = m_HistFormulas.find(alias);
-            if (formulaAlias != m_HistFormulas.end())
-            {
-                auto formula = formulaAlias->second.find(prefix);
-                if (formula != formulaAlias->second.end())
-                {
-                    delete formula->second;
-                    formulaAlias->second.erase(formula);
-                }
-            }
-            if (m_HistData.count(alias) && m_HistData.at(alias).count(prefix) &&
-                m_HistOwnership[alias][prefix] == ResourceOwnership::Owned)
-                delete m_HistData[alias][prefix];
-            m_HistMap[alias][prefix] = binInfo;
-            m_HistData[alias][prefix] = static_cast<TH1 *>(new TH1D(("hist_" + alias + "_" + prefix).c_str(), expr.c_str(), nbins, xmin, xmax));
-            m_HistData[alias][prefix]->SetDirectory(nullptr);
-            m_HistOwnership[alias][prefix] = ResourceOwnership::Owned;
-            m_HistExpressions[alias][prefix] = expr;
-        }
-        else
-        {
-            throw std::invalid_argument("AnalysisManager: invalid bin format for histogram '" + alias + "'.");
-        }
+        const std::string alias = it.first.as<std::string>();
+        std::vector<std::string> errors;
+        const auto spec = HistogramSpec::FromYaml(it.second, alias, errors);
+        if (!spec) throw std::invalid_argument("AnalysisManager: invalid histogram '" + alias + "': " + errors.front());
+        if (m_HistData.count(alias) && m_HistData.at(alias).count(prefix) && m_HistOwnership[alias][prefix] == ResourceOwnership::Owned)
+            delete m_HistData[alias][prefix];
+        m_HistData[alias][prefix] = spec->Create("hist_" + alias + "_" + prefix, spec->Title()).release();
+        m_HistOwnership[alias][prefix] = ResourceOwnership::Owned;
+        m_HistSpecs[alias][prefix] = *spec;
     }
+    SyncVariedHistograms_();
 }
 
 void AnalysisManager::LoadHistogramTemplateFile(const std::string &histfile)
 {
     LoadHists_(histfile);
+    ResetFillPlan_();
     for (auto &[name, inmap] : m_LoadedHistMap)
         for (auto &[prefix, binfo] : inmap)
-            m_HistMap[name][prefix] = binfo;
+            m_HistSpecs[name][prefix] = HistogramSpec::FromBins(name, binfo);
     for (auto &[name, inmap] : m_LoadedHistData)
     {
         for (auto &[prefix, hist] : inmap)
@@ -591,20 +712,15 @@ void AnalysisManager::LoadHistogramTemplateFile(const std::string &histfile)
             if (m_HistData.count(name) && m_HistData.at(name).count(prefix) &&
                 m_HistOwnership[name][prefix] == ResourceOwnership::Owned)
                 delete m_HistData[name][prefix];
-            if (m_HistFormulas.count(name) && m_HistFormulas.at(name).count(prefix))
-            {
-                delete m_HistFormulas[name][prefix];
-                m_HistFormulas[name].erase(prefix);
-            }
             TString chName = hist->GetName();
             chName = chName.Remove(0, 7);
             m_HistData[name][prefix] = static_cast<TH1 *>(hist->Clone(chName));
             m_HistData[name][prefix]->Reset();
             m_HistData[name][prefix]->SetDirectory(nullptr);
             m_HistOwnership[name][prefix] = ResourceOwnership::Owned;
-            m_HistExpressions[name][prefix] = name;
         }
     }
+    SyncVariedHistograms_();
 }
 void AnalysisManager::LoadHists_(const std::string &histfile)
 {
@@ -666,10 +782,13 @@ void AnalysisManager::EnableCuts(const std::vector<std::string> &selected)
     for (const auto &[name, expr] : m_RawCutExpr)
     {
         if (!selected.empty() && std::find(selected.begin(), selected.end(), name) == selected.end()) continue;
-        if (m_CutFormulas.count(name)) delete m_CutFormulas[name];
-        m_CutFormulas[name] = new TTreeFormula(name.c_str(), ExpandAliases_(expr).c_str(), m_CurrentTree);
+        m_EnabledCuts[name] = MakeEnabledCut_(name, expr);
         LOG_INFO("AnalysisManager", "Cut activated: " << name << " => " << expr);
     }
+    ResetCutOrder_();
+    ResetCutflow_();
+    BuildVariedSelections_();
+    ApplyInputReadPlan_();
 }
 
 void AnalysisManager::EnableAllCuts()
@@ -678,17 +797,101 @@ void AnalysisManager::EnableAllCuts()
         throw std::runtime_error("AnalysisManager: classic cuts require an initialized non-RDF tree.");
     for (const auto &[name, expr] : m_RawCutExpr)
     {
-        if (m_CutFormulas.count(name)) delete m_CutFormulas[name];
-        m_CutFormulas[name] = new TTreeFormula(name.c_str(), ExpandAliases_(expr).c_str(), m_CurrentTree);
+        m_EnabledCuts[name] = MakeEnabledCut_(name, expr);
     }
+    ResetCutOrder_();
+    ResetCutflow_();
+    BuildVariedSelections_();
+    ApplyInputReadPlan_();
     LOG_INFO("AnalysisManager", "All Cuts are activated!");
 }
 
+AnalysisManager::EnabledCut AnalysisManager::MakeEnabledCut_(const std::string &name, const std::string &expr) const
+{
+    if (LambdaTarget(expr)) throw std::runtime_error("AnalysisManager: lambda cut requires RDF: " + name);
+    EnabledCut cut;
+    const std::string expanded = ExpandAliases_(expr);
+    if (auto preflighted = TakePreflighted_(expanded))
+    {
+        cut.Compiled = std::move(preflighted->Compiled);
+        cut.Formula = std::move(preflighted->Formula);
+        return cut;
+    }
+    cut.Compiled = TryCompile_(expanded);
+    if (!cut.Compiled.IsValid()) cut.Formula = std::make_unique<TTreeFormula>(name.c_str(), expanded.c_str(), m_CurrentTree);
+    return cut;
+}
+
+CompiledExpression AnalysisManager::TryCompile_(const std::string &expandedExpr) const
+{
+    // Names are matched after alias expansion, so only configured branches bound by BuildChain can be compiled.
+    const auto resolve = [this](const std::string &name) -> std::optional<ValueHandle>
+    {
+        for (const auto &[alias, info] : m_BranchMap)
+            if (info.RealName == name && m_BranchHandles.count(alias)) return m_BranchHandles.at(alias);
+        return std::nullopt;
+    };
+    try
+    {
+        return CompiledExpression::Compile(expandedExpr, resolve);
+    }
+    catch (const std::invalid_argument &error)
+    {
+        LOG_DEBUG("AnalysisManager", error.what() << "; using TTreeFormula.");
+        return {};
+    }
+}
+
+void AnalysisManager::BuildAliasTable_()
+{
+    m_AliasExpansions.clear();
+    m_AliasRegexFallback = false;
+    std::unordered_map<std::string, std::size_t> rank;
+    for (const auto &[alias, info] : m_BranchMap)
+    {
+        // '$' in a real name is a regex_replace format sequence, so such names keep the regex semantics as well.
+        if (!IsWord(alias) || info.RealName.find('$') != std::string::npos)
+        {
+            m_AliasRegexFallback = true;
+            m_AliasExpansions.clear();
+            LOG_DEBUG("AnalysisManager", "Alias '" << alias << "' is rewritten with regular expressions.");
+            return;
+        }
+        rank.emplace(alias, rank.size());
+    }
+    // A real name is only rewritten by aliases sorted after its own, whose expansions are already final.
+    for (auto it = m_BranchMap.rbegin(); it != m_BranchMap.rend(); ++it)
+    {
+        const std::size_t own = rank.at(it->first);
+        m_AliasExpansions.emplace(it->first, RewriteWords(it->second.RealName,
+                                                          [&](const std::string &word) -> const std::string *
+                                                          {
+                                                              const auto later = rank.find(word);
+                                                              if (later == rank.end() || later->second <= own) return nullptr;
+                                                              return &m_AliasExpansions.at(word);
+                                                          }));
+    }
+}
+
 std::string AnalysisManager::ExpandAliases_(const std::string &expr) const
 {
+    static const std::set<std::string> none;
+    return ExpandAliases_(expr, none);
+}
+
+std::string AnalysisManager::ExpandAliases_(const std::string &expr, const std::set<std::string> &kept) const
+{
+    if (!m_AliasRegexFallback)
+        return RewriteWords(expr,
+                            [this, &kept](const std::string &word) -> const std::string *
+                            {
+                                const auto expansion = m_AliasExpansions.find(word);
+                                return expansion == m_AliasExpansions.end() || kept.count(word) ? nullptr : &expansion->second;
+                            });
     std::string result = expr;
     for (const auto &[alias, binfo] : m_BranchMap)
     {
+        if (kept.count(alias)) continue;
         std::regex pattern("\\b" + EscapeRegex(alias) + "\\b");
         result = std::regex_replace(result, pattern, binfo.RealName);
     }
@@ -699,63 +902,351 @@ void AnalysisManager::RegisterCut(const std::string &name, const std::string &ex
 {
     if (m_UseRdf && m_AppliedRdfCuts.count(name))
         throw std::runtime_error("AnalysisManager: cannot replace an RDF cut after it was applied: " + name);
-    auto formula = m_CutFormulas.find(name);
-    if (formula != m_CutFormulas.end())
+    if (m_EnabledCuts.erase(name))
     {
-        delete formula->second;
-        m_CutFormulas.erase(formula);
+        ResetCutOrder_();
+        ResetCutflow_();
+        BuildVariedSelections_();
     }
+    AddToCutSequence_(name);
     m_RawCutExpr[name] = expr;
+    SyncVariedHistograms_();
     LOG_INFO("AnalysisManager", "Cut added: " << name << " -> " << expr);
 }
 
+void AnalysisManager::AddToCutSequence_(const std::string &name)
+{
+    if (std::find(m_CutSequence.begin(), m_CutSequence.end(), name) == m_CutSequence.end()) m_CutSequence.push_back(name);
+}
+
 bool AnalysisManager::PassesCut(const std::string &name) const
 {
-    auto it = m_CutFormulas.find(name);
-    if (it == m_CutFormulas.end()) throw std::runtime_error("AnalysisManager: cut is not enabled: " + name);
-    return it->second->EvalInstance();
+    auto it = m_EnabledCuts.find(name);
+    if (it == m_EnabledCuts.end()) throw std::runtime_error("AnalysisManager: cut is not enabled: " + name);
+    return it->second.Passes();
 }
 
-bool AnalysisManager::PassesCuts(const std::vector<std::string> &names)
+bool AnalysisManager::PassesCuts(const std::vector<std::string> &names) { return PassesNamedCuts_(names); }
+
+bool AnalysisManager::PassesCuts(std::initializer_list<std::string> names) { return PassesNamedCuts_(names); }
+
+template <typename Names> bool AnalysisManager::PassesNamedCuts_(const Names &names)
 {
-    for (const auto &name : names)
-        if (!PassesCut(name)) return false;
+    if (m_CutLearningEvents == 0)
+    {
+        for (const auto &name : names)
+            if (!PassesCut(name)) return false;
+        return true;
+    }
+    if (m_CutOrder.empty())
+    {
+        const Long64_t entry = CutObservationEntry_();
+        bool passed = true;
+        for (const auto &name : names)
+        {
+            const auto cut = m_EnabledCuts.find(name);
+            if (cut == m_EnabledCuts.end()) throw std::runtime_error("AnalysisManager: cut is not enabled: " + name);
+            passed = ObserveCut_(cut->second, entry) && passed;
+        }
+        CountObservedEvent_(entry);
+        return passed;
+    }
+    if (!std::equal(names.begin(), names.end(), m_CutQueryNames.begin(), m_CutQueryNames.end()))
+    {
+        m_CutQueryNames.assign(names.begin(), names.end());
+        m_CutQueryOrder.clear();
+        for (const auto &name : names)
+        {
+            const auto cut = m_EnabledCuts.find(name);
+            if (cut == m_EnabledCuts.end())
+            {
+                m_CutQueryNames.clear();
+                throw std::runtime_error("AnalysisManager: cut is not enabled: " + name);
+            }
+            m_CutQueryOrder.push_back(&cut->second);
+        }
+        std::stable_sort(m_CutQueryOrder.begin(), m_CutQueryOrder.end(),
+                         [](const EnabledCut *lhs, const EnabledCut *rhs) { return lhs->Rank < rhs->Rank; });
+    }
+    for (const EnabledCut *cut : m_CutQueryOrder)
+        if (!cut->Passes()) return false;
     return true;
 }
 
-bool AnalysisManager::PassesCuts(std::initializer_list<std::string> names)
+bool AnalysisManager::PassesAllCuts() { return PassesAllCuts(1.0); }
+
+bool AnalysisManager::PassesAllCuts(double weight)
 {
-    for (const auto &name : names)
-        if (!PassesCut(name)) return false;
+    // The cutflow needs every cut's decision, so it replaces short-circuiting and adaptive ordering while enabled.
+    if (m_CutflowEnabled) return CountCutflow_(weight);
+    if (m_CutLearningEvents > 0 && !m_CutOrder.empty())
+    {
+        for (const EnabledCut *cut : m_CutOrder)
+            if (!cut->Passes()) return false;
+        return true;
+    }
+    if (m_CutLearningEvents > 0)
+    {
+        const Long64_t entry = CutObservationEntry_();
+        bool passed = true;
+        for (auto &[_, cut] : m_EnabledCuts)
+            passed = ObserveCut_(cut, entry) && passed;
+        CountObservedEvent_(entry);
+        return passed;
+    }
+    for (const auto &[_, cut] : m_EnabledCuts)
+        if (!cut.Passes()) return false;
     return true;
 }
 
-bool AnalysisManager::PassesAllCuts()
+void AnalysisManager::EnableAdaptiveCutOrder(Long64_t learningEvents)
 {
-    for (const auto &[name, _] : m_CutFormulas)
-        if (!PassesCut(name)) return false;
-    return true;
+    if (learningEvents <= 0) throw std::invalid_argument("AnalysisManager: adaptive cut ordering needs a positive learning window.");
+    m_CutLearningEvents = learningEvents;
+    ResetCutOrder_();
+}
+
+void AnalysisManager::DisableAdaptiveCutOrder()
+{
+    m_CutLearningEvents = 0;
+    ResetCutOrder_();
+}
+
+Long64_t AnalysisManager::CutObservationEntry_() const { return m_CurrentTree ? m_CurrentTree->GetReadEntry() : -1; }
+
+bool AnalysisManager::ObserveCut_(EnabledCut &cut, Long64_t entry)
+{
+    if (cut.ObservedEntry == entry) return cut.Passes();
+    cut.ObservedEntry = entry;
+    const auto start = std::chrono::steady_clock::now();
+    const bool passed = cut.Passes();
+    cut.CostNs += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    ++cut.EvaluationCount;
+    cut.PassCount += passed;
+    return passed;
 }
 
-double AnalysisManager::GetValue(const std::string &alias) const
+void AnalysisManager::CountObservedEvent_(Long64_t entry)
 {
-    auto it = m_BranchData.find(alias);
-    if (it == m_BranchData.end())
+    if (entry == m_CutObservedEntry) return;
+    m_CutObservedEntry = entry;
+    if (++m_CutObservedEvents >= m_CutLearningEvents) LearnCutOrder_();
+}
+
+void AnalysisManager::LearnCutOrder_()
+{
+    // For independent filters the expected cost is minimal when they run in increasing cost / (1 - pass rate) order.
+    // Cuts that never rejected, or were never evaluated, go last in registration order.
+    const auto score = [](const EnabledCut &cut)
+    {
+        if (cut.EvaluationCount == 0) return std::numeric_limits<double>::infinity();
+        const double rejection = 1.0 - static_cast<double>(cut.PassCount) / static_cast<double>(cut.EvaluationCount);
+        const double cost = std::max(1.0, static_cast<double>(cut.CostNs) / static_cast<double>(cut.EvaluationCount));
+        return rejection > 0.0 ? cost / rejection : std::numeric_limits<double>::max();
+    };
+    std::vector<std::pair<std::string, EnabledCut *>> ordered;
+    for (auto &[name, cut] : m_EnabledCuts)
+        ordered.emplace_back(name, &cut);
+    std::stable_sort(ordered.begin(), ordered.end(),
+                     [&score](const auto &lhs, const auto &rhs) { return score(*lhs.second) < score(*rhs.second); });
+    m_CutOrder.clear();
+    m_CutQueryNames.clear();
+    m_CutQueryOrder.clear();
+    std::ostringstream summary;
+    for (auto &[name, cut] : ordered)
     {
-        return GetNewVar_(alias);
+        cut->Rank = m_CutOrder.size();
+        m_CutOrder.push_back(cut);
+        summary << (cut->Rank ? ", " : "") << name;
     }
-    else
+    LOG_INFO("AnalysisManager", "Adaptive cut order after " << m_CutObservedEvents << " events: " << summary.str());
+}
+
+void AnalysisManager::ResetCutOrder_()
+{
+    m_CutObservedEvents = 0;
+    m_CutObservedEntry = -1;
+    m_CutOrder.clear();
+    m_CutQueryNames.clear();
+    m_CutQueryOrder.clear();
+    for (auto &[_, cut] : m_EnabledCuts)
     {
-        return ReadBranchPointer(m_BranchMap.at(alias).Type, m_BranchData.at(alias));
+        cut.EvaluationCount = 0;
+        cut.PassCount = 0;
+        cut.CostNs = 0;
+        cut.Rank = std::numeric_limits<std::size_t>::max();
+        cut.ObservedEntry = -1;
     }
 }
 
-double AnalysisManager::GetNewVar_(const std::string &alias) const
+void AnalysisManager::MergeCutStatistics_(const AnalysisManager &worker)
 {
-    auto it = m_NewBranchData.find(alias);
-    if (it == m_NewBranchData.end())
-        throw std::runtime_error("AnalysisManager: variable is not registered: " + alias);
-    return *m_NewBranchData.at(alias);
+    if (m_CutLearningEvents == 0 || !m_CutOrder.empty()) return;
+    for (auto &[name, cut] : m_EnabledCuts)
+    {
+        const auto other = worker.m_EnabledCuts.find(name);
+        if (other == worker.m_EnabledCuts.end()) continue;
+        cut.EvaluationCount += other->second.EvaluationCount;
+        cut.PassCount += other->second.PassCount;
+        cut.CostNs += other->second.CostNs;
+    }
+    m_CutObservedEvents += worker.m_CutObservedEvents;
+}
+
+std::vector<CutStatistics> AnalysisManager::GetCutStatistics() const
+{
+    std::vector<CutStatistics> statistics;
+    for (const auto &[name, cut] : m_EnabledCuts)
+    {
+        CutStatistics entry;
+        entry.Name = name;
+        entry.Evaluations = cut.EvaluationCount;
+        entry.Passes = cut.PassCount;
+        entry.MeanCostNs = cut.EvaluationCount ? static_cast<double>(cut.CostNs) / static_cast<double>(cut.EvaluationCount) : 0.0;
+        statistics.push_back(std::move(entry));
+    }
+    if (!m_CutOrder.empty())
+        std::stable_sort(statistics.begin(), statistics.end(), [this](const CutStatistics &lhs, const CutStatistics &rhs)
+                         { return m_EnabledCuts.at(lhs.Name).Rank < m_EnabledCuts.at(rhs.Name).Rank; });
+    return statistics;
+}
+
+std::string AnalysisManager::RunStatistics() const
+{
+    nlohmann::json statistics = nlohmann::json::object();
+    if (m_CutLearningEvents > 0)
+    {
+        nlohmann::json cuts = nlohmann::json::array();
+        for (const auto &cut : GetCutStatistics())
+            cuts.push_back({{"name", cut.Name},
+                            {"evaluations", cut.Evaluations},
+                            {"passes", cut.Passes},
+                            {"pass_rate", cut.PassRate()},
+                            {"mean_cost_ns", cut.MeanCostNs}});
+        statistics["adaptive_cut_order"] = {{"learning_events", m_CutLearningEvents},
+                                            {"observed_events", m_CutObservedEvents},
+                                            {"learned", !m_CutOrder.empty()},
+                                            {"cuts", cuts}};
+    }
+    if (m_PreflightReuses > 0) statistics["preflight"] = {{"reused_expressions", m_PreflightReuses}};
+    if (m_InputReadPlan)
+    {
+        const InputReadStatistics reads = GetInputReadStatistics();
+        statistics["input_reads"] = {{"active_branches", reads.ActiveBranches},
+                                     {"total_branches", reads.TotalBranches},
+                                     {"cache_size", reads.CacheSize},
+                                     {"bytes_read", reads.BytesRead},
+                                     {"cache_hit_ratio", reads.CacheHitRatio()}};
+    }
+    return statistics.dump();
+}
+
+Long64_t AnalysisManager::SelectEntries(Long64_t first, Long64_t count, std::vector<Long64_t> &selected, std::size_t blockSize)
+{
+    return SelectEntries_(first, count, selected, blockSize, false);
+}
+
+Long64_t AnalysisManager::SelectEntries_(Long64_t first, Long64_t count, std::vector<Long64_t> &selected, std::size_t blockSize, bool varied)
+{
+    if (!m_CurrentTree) throw std::runtime_error("AnalysisManager: no input tree is initialized.");
+    if (first < 0 || count < 0 || first + count > GetEntryCount())
+        throw std::out_of_range("AnalysisManager: selected entry range is outside the input range.");
+    if (blockSize == 0) throw std::invalid_argument("AnalysisManager: selection block size must be positive.");
+
+    // Each selection lists the cut instances an entry has to pass. An entry is kept when it passes any selection, and
+    // instances shared between selections are evaluated once.
+    std::vector<const EnabledCut *> cuts;
+    std::vector<std::vector<std::size_t>> selections(1);
+    const auto addCut = [&cuts](const EnabledCut *cut)
+    {
+        const auto index = static_cast<std::size_t>(std::find(cuts.begin(), cuts.end(), cut) - cuts.begin());
+        if (index == cuts.size()) cuts.push_back(cut);
+        return index;
+    };
+    for (const auto &[_, cut] : m_EnabledCuts)
+        selections.front().push_back(addCut(&cut));
+    if (varied)
+        for (const VariedSelection &selection : m_VariedSelections)
+        {
+            auto &members = selections.emplace_back();
+            for (const auto &[name, cut] : m_EnabledCuts)
+            {
+                const auto variedCut = selection.Cuts.find(name);
+                members.push_back(addCut(variedCut == selection.Cuts.end() ? &cut : &variedCut->second));
+            }
+        }
+
+    // Compiled cuts read their inputs from per-block columns filled while the entries are loaded; formula fallbacks
+    // have to run on the loaded entry.
+    std::vector<ValueHandle> inputs;
+    std::vector<std::vector<std::size_t>> cutColumns(cuts.size());
+    std::vector<std::size_t> compiled;
+    std::vector<std::size_t> formulas;
+    for (std::size_t cut = 0; cut < cuts.size(); ++cut)
+    {
+        if (cuts[cut]->Formula)
+        {
+            formulas.push_back(cut);
+            continue;
+        }
+        compiled.push_back(cut);
+        for (const ValueHandle &input : cuts[cut]->Compiled.Inputs())
+        {
+            const auto existing =
+                std::find_if(inputs.begin(), inputs.end(), [&](const ValueHandle &known) { return known.Data() == input.Data(); });
+            cutColumns[cut].push_back(static_cast<std::size_t>(existing - inputs.begin()));
+            if (existing == inputs.end()) inputs.push_back(input);
+        }
+    }
+
+    std::vector<std::vector<double>> values(inputs.size(), std::vector<double>(blockSize));
+    std::vector<std::vector<char>> passes(cuts.size(), std::vector<char>(blockSize));
+    std::vector<double> results(blockSize);
+    std::vector<const double *> columns;
+    Long64_t passed = 0;
+    for (Long64_t start = first; start < first + count; start += static_cast<Long64_t>(blockSize))
+    {
+        const auto size = static_cast<std::size_t>(std::min<Long64_t>(static_cast<Long64_t>(blockSize), first + count - start));
+        for (std::size_t index = 0; index < size; ++index)
+        {
+            LoadEvent(start + static_cast<Long64_t>(index));
+            for (std::size_t input = 0; input < inputs.size(); ++input)
+                values[input][index] = inputs[input].Get();
+            for (const std::size_t cut : formulas)
+                passes[cut][index] = cuts[cut]->Passes();
+        }
+        for (const std::size_t cut : compiled)
+        {
+            columns.clear();
+            for (const std::size_t column : cutColumns[cut])
+                columns.push_back(values[column].data());
+            cuts[cut]->Compiled.EvaluateBlock(columns, size, results.data());
+            for (std::size_t index = 0; index < size; ++index)
+                passes[cut][index] = results[index] != 0.0;
+        }
+        for (std::size_t index = 0; index < size; ++index)
+        {
+            const auto passesSelection = [&](const std::vector<std::size_t> &members)
+            { return std::all_of(members.begin(), members.end(), [&](std::size_t cut) { return passes[cut][index] != 0; }); };
+            if (std::any_of(selections.begin(), selections.end(), passesSelection))
+            {
+                selected.push_back(start + static_cast<Long64_t>(index));
+                ++passed;
+            }
+        }
+    }
+    return passed;
+}
+
+double AnalysisManager::GetValue(const std::string &alias) const { return GetValueHandle(alias).Get(); }
+
+ValueHandle AnalysisManager::GetValueHandle(const std::string &alias) const
+{
+    const auto branch = m_BranchHandles.find(alias);
+    if (branch != m_BranchHandles.end()) return branch->second;
+    const auto variable = m_NewBranchData.find(alias);
+    if (variable == m_NewBranchData.end()) throw std::runtime_error("AnalysisManager: variable is not registered: " + alias);
+    return ValueHandle(variable->second, BranchValueType::Double);
 }
 
 std::string AnalysisManager::GetCutExpression(const std::string &name) const
@@ -774,11 +1265,25 @@ void AnalysisManager::WriteCutConfig(const std::string &yamlPath) const
     out << YAML::Key << "cuts" << YAML::Value << YAML::BeginMap;
     for (const auto &[name, expr] : m_RawCutExpr)
     {
-        if (expr.rfind("--lambda:", 0) == 0)
+        // Only library filters can be restored by name; a runtime callable has no registered name to write.
+        if (const auto target = LambdaTarget(expr); target && !FindRdfLambda_(*target, RdfLambda::Kind::Filter))
             throw std::runtime_error("AnalysisManager: lambda cut cannot be serialized: " + name);
         out << YAML::Key << name << YAML::Value << expr;
     }
-    out << YAML::EndMap << YAML::EndMap;
+    out << YAML::EndMap;
+    if (std::any_of(m_Variations.begin(), m_Variations.end(), [](const auto &variation) { return variation.second.AffectsCuts; }))
+    {
+        out << YAML::Key << "variations" << YAML::Value << YAML::BeginMap;
+        for (const auto &[name, variation] : m_Variations)
+        {
+            if (!variation.AffectsCuts) continue;
+            out << YAML::Key << name << YAML::Value << YAML::BeginMap;
+            variation.EmitYaml(out);
+            out << YAML::EndMap;
+        }
+        out << YAML::EndMap;
+    }
+    out << YAML::EndMap;
     std::ofstream fout(yamlPath);
     if (!fout) throw std::runtime_error("AnalysisManager: unable to open cut output file: " + yamlPath);
 
@@ -840,6 +1345,7 @@ double *AnalysisManager::RegisterVariable(const std::string &name, std::string a
         throw std::runtime_error("AnalysisManager: variable already exists: " + alias);
 
     double *ptr = new double;
+    ResetFillPlan_();
     m_NewBranchMap[alias] = {name, "Double_t"};
     m_NewBranchData[alias] = ptr;
     LOG_INFO("AnalysisManager", "New variable added: " << alias << " mapped to " << name);
@@ -879,7 +1385,7 @@ bool AnalysisManager::AttachBranch(TTree *tree, const std::string &alias, TreeOp
     }
 
     double *value = m_NewBranchData.at(alias);
-    TBranch *branch = tree->Branch(name.c_str(), value, (name + "/D").c_str());
+    TBranch *branch = tree->Branch(name.c_str(), value, (name + "/D").c_str(), m_OutputSettings.BasketSize.value_or(DEFAULT_BASKET_SIZE));
     if (!branch)
     {
         LOG_ERROR("AnalysisManager", "Failed to attach branch '" << name << "' to tree '" << tree->GetName() << "'.");
@@ -902,16 +1408,24 @@ bool AnalysisManager::AttachBranch(const std::string &treeName, const std::strin
 void AnalysisManager::BookHistogram(const std::string &alias, std::vector<double> binfo, const std::string &prefix)
 {
     ValidateHistogramBins(binfo, alias);
+    BookHistogram(alias, HistogramSpec::FromBins(alias, binfo), prefix);
+}
+
+void AnalysisManager::BookHistogram(const std::string &alias, HistogramSpec spec, const std::string &prefix)
+{
+    if (!spec.Axes.empty() && spec.Axes.front().Expression.empty()) spec.Axes.front().Expression = alias;
+    spec.Validate(alias);
     std::string fullname = "hist_" + alias + "_" + prefix;
     if (m_HistData.count(alias) && m_HistData.at(alias).count(prefix))
         throw std::runtime_error("AnalysisManager: histogram already exists: " + fullname);
 
     LOG_INFO("AnalysisManager", "Histogram " << fullname << " is added");
-    m_HistData[alias][prefix] = static_cast<TH1 *>(new TH1D(fullname.c_str(), "", int(binfo[0]), binfo[1], binfo[2]));
-    m_HistData[alias][prefix]->SetDirectory(nullptr);
-    m_HistMap[alias][prefix] = std::move(binfo);
+    // Programmatic 1D bookings keep their untitled histograms.
+    m_HistData[alias][prefix] = spec.Create(fullname, spec.Kind == HistogramKind::TH1D ? "" : spec.Title()).release();
+    m_HistSpecs[alias][prefix] = std::move(spec);
     m_HistOwnership[alias][prefix] = ResourceOwnership::Owned;
-    m_HistExpressions[alias][prefix] = alias;
+    ResetFillPlan_();
+    SyncVariedHistograms_();
 }
 
 void AnalysisManager::RegisterHistogram(const std::string &alias, TH1 *hist, const std::string &prefix, ResourceOwnership ownership)
@@ -927,48 +1441,154 @@ void AnalysisManager::RegisterHistogram(const std::string &alias, TH1 *hist, con
     double nbins = hist->GetNbinsX();
     double xmin = hist->GetBinLowEdge(1);
     double xmax = hist->GetBinLowEdge(hist->GetNbinsX()) + hist->GetBinWidth(hist->GetNbinsX());
-    m_HistMap[alias][prefix] = {nbins, xmin, xmax};
+    m_HistSpecs[alias][prefix] = HistogramSpec::FromBins(alias, {nbins, xmin, xmax});
     m_HistOwnership[alias][prefix] = ownership;
-    m_HistExpressions[alias][prefix] = alias;
+    ResetFillPlan_();
+    SyncVariedHistograms_();
 }
 
 void AnalysisManager::FillHistograms(double weight)
 {
     if (!m_CurrentTree) throw std::runtime_error("AnalysisManager: cannot fill histograms before a tree is initialized.");
+    if (!m_FillPlanReady) BuildFillPlan_();
+    FillPlan_(weight, nullptr);
+}
+
+void AnalysisManager::FillPlan_(double weight, const std::vector<char> *selectionPasses)
+{
+    if (m_FillBufferSize == 0)
+    {
+        for (const auto &fill : m_FillPlan)
+            if (!selectionPasses || (*selectionPasses)[fill.Selection])
+                fill.Fill(fill.Value.Evaluate(), fill.Weight.IsSet() ? weight * fill.Weight.Evaluate() : weight);
+        return;
+    }
+    for (auto &fill : m_FillPlan)
+    {
+        if (selectionPasses && !(*selectionPasses)[fill.Selection]) continue;
+        const double value = fill.Value.Evaluate();
+        const double fillWeight = fill.Weight.IsSet() ? weight * fill.Weight.Evaluate() : weight;
+        if (!fill.Buffered)
+        {
+            fill.Fill(value, fillWeight);
+            continue;
+        }
+        fill.BufferedValues.push_back(value);
+        fill.BufferedWeights.push_back(fillWeight);
+    }
+    if (++m_BufferedEvents >= m_FillBufferSize) FlushHistograms();
+}
+
+void AnalysisManager::HistogramFill::Fill(double value, double weight) const
+{
+    switch (Kind)
+    {
+    case HistogramKind::TH2D:
+        static_cast<TH2 *>(Histogram)->Fill(value, Y.Evaluate(), weight);
+        break;
+    case HistogramKind::TH3D:
+        static_cast<TH3 *>(Histogram)->Fill(value, Y.Evaluate(), Z.Evaluate(), weight);
+        break;
+    case HistogramKind::TProfile:
+        static_cast<TProfile *>(Histogram)->Fill(value, Y.Evaluate(), weight);
+        break;
+    default:
+        Histogram->Fill(value, weight);
+    }
+}
+
+void AnalysisManager::SetFillBufferSize(std::size_t entries)
+{
+    if (entries > static_cast<std::size_t>(std::numeric_limits<int>::max()))
+        throw std::invalid_argument("AnalysisManager: fill buffer size exceeds the TH1::FillN limit.");
+    FlushHistograms();
+    m_FillBufferSize = entries;
+    ResetFillPlan_();
+}
+
+void AnalysisManager::FlushHistograms()
+{
+    // TH1::FillN applies the same per-entry updates as TH1::Fill in the same order, so buffered contents and statistics
+    // are bit-identical to unbuffered filling.
+    for (auto &fill : m_FillPlan)
+    {
+        if (fill.BufferedValues.empty()) continue;
+        fill.Histogram->FillN(static_cast<int>(fill.BufferedValues.size()), fill.BufferedValues.data(), fill.BufferedWeights.data());
+        fill.BufferedValues.clear();
+        fill.BufferedWeights.clear();
+    }
+    m_BufferedEvents = 0;
+}
+
+void AnalysisManager::BuildFillPlan_()
+{
+    ApplyInputReadPlan_();
+    std::vector<HistogramFill> plan;
     for (const auto &[alias, inmap] : m_HistData)
     {
         for (const auto &[prefix, hist] : inmap)
         {
-            const std::string expression =
-                m_HistExpressions.count(alias) && m_HistExpressions.at(alias).count(prefix) ? m_HistExpressions.at(alias).at(prefix) : alias;
-            double value = 0.0;
-            if (m_BranchData.count(expression) || m_NewBranchData.count(expression))
-            {
-                value = GetValue(expression);
-            }
-            else
+            const HistogramSpec &spec = m_HistSpecs.at(alias).at(prefix);
+            HistogramFill fill;
+            fill.Histogram = hist;
+            fill.Kind = spec.Kind;
+            for (std::size_t index = 0; index < m_VariedSelections.size() && !spec.Variation.empty(); ++index)
+                if (m_VariedSelections[index].Variation == spec.Variation) fill.Selection = index + 1;
+            // Profiles reject the two-array FillN overload and higher dimensions interpret it differently.
+            fill.Buffered = m_FillBufferSize > 0 && hist->GetDimension() == 1 && !hist->InheritsFrom(TProfile::Class());
+            if (fill.Buffered)
             {
-                auto &formula = m_HistFormulas[alias][prefix];
-                if (!formula)
-                {
-                    const std::string formulaName = "cascade_hist_formula_" + SafeColumnName(alias + "_" + prefix);
-                    formula = new TTreeFormula(formulaName.c_str(), ExpandAliases_(expression).c_str(), m_CurrentTree);
-                    if (formula->GetNdim() <= 0)
-                    {
-                        delete formula;
-                        formula = nullptr;
-                        throw std::runtime_error("AnalysisManager: invalid histogram expression for '" + alias + "': " + expression);
-                    }
-                }
-                value = formula->EvalInstance();
+                fill.BufferedValues.reserve(m_FillBufferSize);
+                fill.BufferedWeights.reserve(m_FillBufferSize);
             }
-            hist->Fill(value, weight);
+            const std::string formulaName = SafeColumnName(alias + "_" + prefix);
+            fill.Value = ResolveFillSource_(spec.Axes.at(0).Expression, "cascade_hist_formula_" + formulaName, alias);
+            if (spec.Axes.size() > 1) fill.Y = ResolveFillSource_(spec.Axes[1].Expression, "cascade_hist_y_" + formulaName, alias);
+            if (spec.Axes.size() > 2) fill.Z = ResolveFillSource_(spec.Axes[2].Expression, "cascade_hist_z_" + formulaName, alias);
+            const auto variation = spec.Variation.empty() ? m_Variations.end() : m_Variations.find(spec.Variation);
+            if (variation != m_Variations.end() && !variation->second.Weight.empty())
+                fill.Weight = ResolveFillSource_(variation->second.Weight, "cascade_hist_weight_" + formulaName, alias);
+            plan.push_back(std::move(fill));
         }
     }
+    m_FillPlan = std::move(plan);
+    m_FillPlanReady = true;
+    LOG_DEBUG("AnalysisManager", "Histogram fill plan compiled with " << m_FillPlan.size() << " entries");
+}
+
+AnalysisManager::FillSource AnalysisManager::ResolveFillSource_(const std::string &expression, const std::string &formulaName,
+                                                                const std::string &alias) const
+{
+    FillSource source;
+    if (const auto branch = m_BranchHandles.find(expression); branch != m_BranchHandles.end())
+        source.Handle = branch->second;
+    else if (const auto variable = m_NewBranchData.find(expression); variable != m_NewBranchData.end())
+        source.Handle = ValueHandle(variable->second, BranchValueType::Double);
+    else
+    {
+        const std::string expanded = ExpandAliases_(expression);
+        auto preflighted = TakePreflighted_(expanded);
+        source.Compiled = preflighted ? std::move(preflighted->Compiled) : TryCompile_(expanded);
+        if (source.Compiled.IsValid()) return source;
+        source.Formula = preflighted && preflighted->Formula
+                             ? std::move(preflighted->Formula)
+                             : std::make_unique<TTreeFormula>(formulaName.c_str(), expanded.c_str(), m_CurrentTree);
+        if (source.Formula->GetNdim() <= 0)
+            throw std::runtime_error("AnalysisManager: invalid histogram expression for '" + alias + "': " + expression);
+    }
+    return source;
+}
+
+void AnalysisManager::ResetFillPlan_()
+{
+    FlushHistograms();
+    m_FillPlan.clear();
+    m_FillPlanReady = false;
 }
 
 void AnalysisManager::WriteHistograms(const std::string &outfile)
 {
+    FlushHistograms();
     TFile file(outfile.c_str(), "recreate");
     if (file.IsZombie()) throw std::runtime_error("AnalysisManager: cannot create histogram output file: " + outfile);
     file.cd();
@@ -987,21 +1607,31 @@ void AnalysisManager::WriteHistogramConfig(const std::string &yamlOut)
     YAML::Emitter out;
     out << YAML::BeginMap;
     out << YAML::Key << "schema_version" << YAML::Value << CONFIG_SCHEMA_VERSION;
+    if (m_FillBufferSize > 0) out << YAML::Key << "fill_buffer" << YAML::Value << m_FillBufferSize;
+    const bool histogramVariations =
+        std::any_of(m_Variations.begin(), m_Variations.end(), [](const auto &variation) { return !variation.second.AffectsCuts; });
+    if (histogramVariations)
+    {
+        out << YAML::Key << "variations" << YAML::Value << YAML::BeginMap;
+        for (const auto &[name, variation] : m_Variations)
+        {
+            if (variation.AffectsCuts) continue;
+            out << YAML::Key << name << YAML::Value << YAML::BeginMap;
+            variation.EmitYaml(out);
+            out << YAML::EndMap;
+        }
+        out << YAML::EndMap;
+    }
 
     out << YAML::Key << "histograms" << YAML::Value << YAML::BeginMap;
 
-    for (const auto &[name, inmap] : m_HistMap)
+    // Varied histograms are derived again from the variations when the config is loaded.
+    for (const auto &[name, inmap] : m_HistSpecs)
     {
+        const auto nominal = std::find_if(inmap.begin(), inmap.end(), [](const auto &entry) { return entry.second.Variation.empty(); });
+        if (nominal == inmap.end()) continue;
         out << YAML::Key << name << YAML::Value << YAML::BeginMap;
-        const std::string &prefix = inmap.begin()->first;
-        const std::string expression =
-            m_HistExpressions.count(name) && m_HistExpressions.at(name).count(prefix) ? m_HistExpressions.at(name).at(prefix) : name;
-        out << YAML::Key << "expr" << YAML::Value << expression;
-        auto firstIt = inmap.begin();
-        out << YAML::Key << "bins" << YAML::Value << YAML::Flow << YAML::BeginSeq;
-        for (auto b : firstIt->second)
-            out << b;
-        out << YAML::EndSeq;
+        nominal->second.EmitYaml(out);
         out << YAML::EndMap;
     }
     out << YAML::EndMap;
@@ -1020,17 +1650,28 @@ void AnalysisManager::LoadEvent(Long64_t i)
     if (!m_CurrentTree) throw std::runtime_error("AnalysisManager: no input tree is initialized.");
     const Long64_t entries = GetEntryCount();
     if (i < 0 || i >= entries) throw std::out_of_range("AnalysisManager: event index is outside the input range.");
-    if (i == 0) m_StartTime = std::chrono::steady_clock::now();
+    if (i == 0)
+    {
+        m_StartTime = std::chrono::steady_clock::now();
+        StartInputReadStatistics_();
+    }
 
-    m_CurrentTree->GetEntry(i);
+    ReadInputEntry_(i);
 
     if (i % 500 == 0 || i == entries - 1) UpdateProgress_((double)(i + 1) / entries);
+    if (i == entries - 1) ReportInputReads_();
 }
 
 Long64_t AnalysisManager::GetEntryCount()
 {
-    if (!m_CurrentTree) throw std::runtime_error("AnalysisManager: no input tree is initialized.");
-    return m_CurrentTree->GetEntries();
+    // LoadEvent asks on every event, and an unindexed TChain opens every file the first time. RNTuple inputs have no tree
+    // and record their count when the dataframe is built.
+    if (m_EntryCount < 0)
+    {
+        if (!m_CurrentTree) throw std::runtime_error("AnalysisManager: no input tree is initialized.");
+        m_EntryCount = m_CurrentTree->GetEntries();
+    }
+    return m_EntryCount;
 }
 
 std::ofstream AnalysisManager::OpenOutputFile(const std::string &filename, const std::string &mode) const
@@ -1087,24 +1728,7 @@ std::string AnalysisManager::SnapshotState() const
     for (const auto &file : m_InputFiles)
     {
         nlohmann::json input = {{"path", file}};
-        struct stat metadata{};
-        if (stat(file.c_str(), &metadata) == 0 && S_ISREG(metadata.st_mode))
-        {
-            input["device"] = static_cast<std::uintmax_t>(metadata.st_dev);
-            input["inode"] = static_cast<std::uintmax_t>(metadata.st_ino);
-            input["size"] = static_cast<std::uintmax_t>(metadata.st_size);
-#if defined(__APPLE__)
-            input["mtime_seconds"] = metadata.st_mtimespec.tv_sec;
-            input["mtime_nanoseconds"] = metadata.st_mtimespec.tv_nsec;
-            input["ctime_seconds"] = metadata.st_ctimespec.tv_sec;
-            input["ctime_nanoseconds"] = metadata.st_ctimespec.tv_nsec;
-#else
-            input["mtime_seconds"] = metadata.st_mtim.tv_sec;
-            input["mtime_nanoseconds"] = metadata.st_mtim.tv_nsec;
-            input["ctime_seconds"] = metadata.st_ctim.tv_sec;
-            input["ctime_nanoseconds"] = metadata.st_ctim.tv_nsec;
-#endif
-        }
+        if (const auto identity = FileIdentity(file)) input.update(*identity);
         inputs.push_back(std::move(input));
     }
 
@@ -1113,21 +1737,48 @@ std::string AnalysisManager::SnapshotState() const
         cuts[name] = expression;
 
     nlohmann::json histograms = nlohmann::json::array();
-    for (const auto &[alias, prefixes] : m_HistMap)
-        for (const auto &[prefix, bins] : prefixes)
+    // Uniform 1D entries keep their original shape so existing snapshots stay comparable.
+    const auto binning = [](const HistogramAxis &axis)
+    {
+        return axis.Edges.empty() ? nlohmann::json{static_cast<double>(axis.Bins), axis.Min, axis.Max} : nlohmann::json(axis.Edges);
+    };
+    for (const auto &[alias, prefixes] : m_HistSpecs)
+        for (const auto &[prefix, spec] : prefixes)
         {
-            std::string expression;
-            if (m_HistExpressions.count(alias) && m_HistExpressions.at(alias).count(prefix))
-                expression = m_HistExpressions.at(alias).at(prefix);
-            histograms.push_back({{"alias", alias}, {"prefix", prefix}, {"expression", expression}, {"bins", bins}});
+            const HistogramAxis &x = spec.Axes.at(0);
+            nlohmann::json histogram = {{"alias", alias}, {"prefix", prefix}, {"expression", x.Expression}};
+            histogram[x.Edges.empty() ? "bins" : "edges"] = binning(x);
+            if (!spec.Variation.empty()) histogram["variation"] = spec.Variation;
+            if (spec.Kind != HistogramKind::TH1D)
+            {
+                histogram["type"] = spec.Kind == HistogramKind::TH2D ? "TH2D" : spec.Kind == HistogramKind::TH3D ? "TH3D" : "TProfile";
+                nlohmann::json axes = nlohmann::json::array();
+                for (std::size_t axis = 1; axis < spec.Axes.size(); ++axis)
+                {
+                    nlohmann::json entry = {{"expression", spec.Axes[axis].Expression}};
+                    if (spec.Kind != HistogramKind::TProfile) entry[spec.Axes[axis].Edges.empty() ? "bins" : "edges"] = binning(spec.Axes[axis]);
+                    axes.push_back(std::move(entry));
+                }
+                histogram["axes"] = std::move(axes);
+            }
+            histograms.push_back(std::move(histogram));
         }
-    return nlohmann::json{{"schema_version", 2},
-                          {"tree", m_InTreeName},
-                          {"rdf", m_UseRdf},
-                          {"inputs", std::move(inputs)},
-                          {"cuts", std::move(cuts)},
-                          {"histograms", std::move(histograms)}}
-        .dump();
+    nlohmann::json state = {{"schema_version", 2},
+                            {"tree", m_InTreeName},
+                            {"rdf", m_UseRdf},
+                            {"inputs", std::move(inputs)},
+                            {"cuts", std::move(cuts)},
+                            {"histograms", std::move(histograms)}};
+    // Recorded only for RNTuple inputs, and variations only when declared, so existing snapshots keep their hashes.
+    if (m_InputFormat == DataFormat::RNTuple) state["format"] = "rntuple";
+    if (!m_Variations.empty())
+    {
+        nlohmann::json variations = nlohmann::json::object();
+        for (const auto &[name, variation] : m_Variations)
+            variations[name] = {{"columns", variation.Columns}, {"weight", variation.Weight}, {"cuts", variation.AffectsCuts}};
+        state["variations"] = std::move(variations);
+    }
+    return state.dump();
 }
 
 void AnalysisManager::WriteMetadata(const std::string &filename, const std::string &hash, const std::string &baseName, const std::string &paramJson)
@@ -1157,6 +1808,20 @@ void AnalysisManager::PrintCutSummary()
     for (const auto &[name, expr] : m_RawCutExpr)
         LOG_INFO("AnalysisManager", name << " : " << expr);
     LOG_INFO("AnalysisManager", "-------------REGISTERED CUTS----------------");
+    // An RDF cutflow is only printed once its event loop has run; printing never triggers one.
+    if (!m_CutflowEnabled || (m_UseRdf && !m_RdfCutflowEntries->IsReady())) return;
+    if (m_UseRdf && m_RdfCutflowNode && !(m_RdfCutflowReport && m_RdfCutflowReport->IsReady())) return;
+    const Cutflow cutflow = GetCutflow();
+    LOG_INFO("AnalysisManager", "-------------CUTFLOW------------------------");
+    LOG_INFO("AnalysisManager", "all : " << cutflow.Total << " (weight " << cutflow.TotalWeight << ")");
+    for (const auto &stage : cutflow.Stages)
+    {
+        const double efficiency = cutflow.Total > 0 ? static_cast<double>(stage.Passed) / static_cast<double>(cutflow.Total) : 0.0;
+        LOG_INFO("AnalysisManager", stage.Name << " : " << stage.Passed << " (weight " << stage.PassedWeight << ", efficiency "
+                                               << efficiency << ")"
+                                               << (stage.Individual ? ", alone " + std::to_string(*stage.Individual) : std::string()));
+    }
+    LOG_INFO("AnalysisManager", "-------------CUTFLOW------------------------");
 }
 
 void AnalysisManager::PrintConfigSummary()
@@ -1186,10 +1851,10 @@ void AnalysisManager::PrintHistogramSummary()
             LOG_INFO("AnalysisManager", "loaded_hist_" << alias << "_" << prefix << " : " << "[" << int(bins[0]) << "," << bins[1] << "," << bins[2] << "]");
     }
 
-    for (const auto &[alias, hists] : m_HistMap)
+    for (const auto &[alias, hists] : m_HistSpecs)
     {
-        for (const auto &[prefix, bins] : hists)
-            LOG_INFO("AnalysisManager", "hist_" << alias << "_" << prefix << " : " << "[" << int(bins[0]) << "," << bins[1] << "," << bins[2] << "]");
+        for (const auto &[prefix, spec] : hists)
+            LOG_INFO("AnalysisManager", "hist_" << alias << "_" << prefix << " : " << spec.Describe());
     }
     if (m_UseRdf)
     {
@@ -1214,27 +1879,43 @@ AnalysisManager::AnalysisManager()
 
 void AnalysisManager::ReleaseCurrentTree_()
 {
-    for (auto &[_, formula] : m_CutFormulas)
-        delete formula;
-    m_CutFormulas.clear();
-    for (auto &[_, formulas] : m_HistFormulas)
-        for (auto &[__, formula] : formulas)
-            delete formula;
-    m_HistFormulas.clear();
+    m_EnabledCuts.clear();
+    m_VariedSelections.clear();
+    ResetCutOrder_();
+    ResetCutflow_();
+    ResetFillPlan_();
+    m_InputReadPlan.reset();
+    m_ActiveBranches.clear();
+    m_InputFileEnd = -1;
+    m_TotalBranches = 0;
+    // RDF cutflow results belong to the dataframe released here.
+    if (m_UseRdf) DisableCutflow();
 
     for (auto &[alias, pointer] : m_BranchData)
     {
-        const auto info = m_BranchMap.find(alias);
-        if (info != m_BranchMap.end()) DeleteBranchPointer(info->second.Type, pointer);
+        const auto handle = m_BranchHandles.find(alias);
+        if (handle != m_BranchHandles.end()) DeleteBranchPointer(handle->second.Type(), pointer);
     }
     m_BranchData.clear();
+    m_BranchHandles.clear();
+    m_PreflightedExpressions.clear();
+    m_PreflightReuses = 0;
     m_RdfNode.reset();
     m_RdfRaw.reset();
     m_LambdaManager.reset();
     m_UseRdf = false;
+    m_RdfVariationWeight = false;
+    m_RdfVariedAliases.clear();
+    m_HistRdfVariations.clear();
+    m_RdfRegions.clear();
+    m_RdfColumns = {};
     m_AppliedRdfCuts.clear();
     m_CurrentTreeOwner.reset();
     m_CurrentTree = nullptr;
+    m_EntryCount = -1;
+    m_ChainClusters.clear();
+    m_SelectedEntries.clear();
+    m_SelectedEntriesKey.clear();
     m_Progress.store(0.0);
 }
 
@@ -1250,13 +1931,12 @@ AnalysisManager::~AnalysisManager()
     for (auto &[_, ptr] : m_NewBranchData)
         delete ptr;
     m_NewBranchData.clear();
-    m_HistMap.clear();
+    m_HistSpecs.clear();
     for (auto &[alias, hists] : m_HistData)
         for (auto &[prefix, h] : hists)
             if (m_HistOwnership[alias][prefix] == ResourceOwnership::Owned) delete h;
     m_HistData.clear();
     m_HistOwnership.clear();
-    m_HistExpressions.clear();
     m_LoadedHistMap.clear();
     for (auto &[_, hists] : m_LoadedHistData)
         for (auto &[_, h] : hists)
@@ -1264,5 +1944,6 @@ AnalysisManager::~AnalysisManager()
     m_LoadedHistData.clear();
     m_HistRdf.clear();
     m_RawCutExpr.clear();
+    m_CutSequence.clear();
     m_InputFiles.clear();
 }
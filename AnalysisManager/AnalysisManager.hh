@@ -1,4 +1,6 @@
 #pragma once
+#include "BranchValue.hh"
+#include "CompiledExpression.hh"
 #include "LambdaManager.hh"
 #include "Logger.hh"
 #include <ROOT/RDataFrame.hxx>
@@ -9,12 +11,15 @@
 #include <TTreeFormula.h>
 #include <atomic>
 #include <chrono>
+#include <functional>
+#include <limits>
 #include <map>
 #include <memory>
 #include <mutex>
 #include <optional>
 #include <set>
 #include <string>
+#include <unordered_map>
 #include <vector>
 #include <yaml-cpp/yaml.h>
 
@@ -29,6 +34,13 @@ enum Om
 
 }
 
+// On-disk layout of an input dataset or RDF snapshot. RNTuple needs ROOT 6.36 or newer and is read through RDF only.
+enum class DataFormat
+{
+    TTree,
+    RNTuple
+};
+
 enum class ResourceOwnership
 {
     Borrowed,
@@ -43,6 +55,134 @@ struct ConfigValidationResult
     void ThrowIfInvalid(const std::string &configPath) const;
 };
 
+struct ConfigPreflightResult
+{
+    ConfigValidationResult Input;
+    ConfigValidationResult Cuts;
+    ConfigValidationResult Histograms;
+
+    bool Valid() const { return Input.Valid() && Cuts.Valid() && Histograms.Valid(); }
+};
+
+struct CutStatistics
+{
+    std::string Name;
+    Long64_t Evaluations = 0;
+    Long64_t Passes = 0;
+    double MeanCostNs = 0.0;
+
+    double PassRate() const { return Evaluations > 0 ? static_cast<double>(Passes) / static_cast<double>(Evaluations) : 1.0; }
+};
+
+struct InputReadStatistics
+{
+    std::size_t ActiveBranches = 0;
+    std::size_t TotalBranches = 0;
+    Long64_t CacheSize = 0;
+    // File bytes read from the input files since the loop started, and the part of it requested through TTreeCache.
+    Long64_t BytesRead = 0;
+    Long64_t CacheBytesRead = 0;
+    Long64_t UncachedBytesRead = 0;
+
+    double CacheHitRatio() const
+    {
+        const Long64_t requested = CacheBytesRead + UncachedBytesRead;
+        return requested > 0 ? static_cast<double>(CacheBytesRead) / static_cast<double>(requested) : 0.0;
+    }
+};
+
+enum class HistogramKind
+{
+    TH1D,
+    TH2D,
+    TH3D,
+    TProfile
+};
+
+// One histogram axis: the expression filled along it and either Bins uniform bins over [Min, Max) or explicit Edges.
+struct HistogramAxis
+{
+    std::string Expression;
+    int Bins = 0;
+    double Min = 0.0;
+    double Max = 0.0;
+    std::vector<double> Edges;
+
+    int BinCount() const { return Edges.empty() ? Bins : static_cast<int>(Edges.size()) - 1; }
+    std::vector<double> BinEdges() const;
+};
+
+// Axes holds x, y, and z in order. A TProfile has a binned x axis and a y axis whose expression is averaged per x bin,
+// so its y axis carries no binning.
+struct HistogramSpec
+{
+    HistogramKind Kind = HistogramKind::TH1D;
+    std::vector<HistogramAxis> Axes;
+    // Set on histograms the manager derives from a nominal one for a systematic variation.
+    std::string Variation;
+
+    static HistogramSpec FromBins(const std::string &expression, const std::vector<double> &binfo);
+    // Parses one entry of the histogram YAML schema, appending "histograms.<name>..." messages to errors on failure.
+    static std::optional<HistogramSpec> FromYaml(const YAML::Node &entry, const std::string &name, std::vector<std::string> &errors);
+    void Validate(const std::string &name) const;
+    std::unique_ptr<TH1> Create(const std::string &name, const std::string &title) const;
+    std::string Title() const;
+    std::string Describe() const;
+    void EmitYaml(YAML::Emitter &out) const;
+    bool operator==(const HistogramSpec &other) const;
+};
+
+// A systematic variation reads each alias in Columns through its replacement expression and multiplies fill weights by
+// Weight. Variations declared with the cuts also re-evaluate the selection; histogram-level ones only change the fills.
+struct SystematicVariation
+{
+    std::string Name;
+    std::map<std::string, std::string> Columns;
+    std::string Weight;
+    bool AffectsCuts = false;
+
+    // Parses one entry of the "variations" YAML section, appending "variations.<name>..." messages to errors on failure.
+    static std::optional<SystematicVariation> FromYaml(const YAML::Node &entry, const std::string &name, std::vector<std::string> &errors);
+    // Rewrites whole-word varied aliases in expression to their parenthesized replacements.
+    std::string Apply(const std::string &expression) const;
+    void EmitYaml(YAML::Emitter &out) const;
+    bool operator==(const SystematicVariation &other) const;
+};
+
+// Compression and clustering for RDF snapshots and the trees WriteTrees writes; unset fields keep ROOT's defaults.
+// Algorithm is "zlib", "lzma", "lz4" or "zstd". AutoFlush follows TTree::SetAutoFlush: positive values count entries
+// per cluster, negative values bytes. Trees take AutoFlush when registered and BasketSize when a branch is attached.
+struct OutputSettings
+{
+    std::string Algorithm;
+    std::optional<int> Level;
+    std::optional<Long64_t> AutoFlush;
+    std::optional<int> BasketSize;
+
+    // Parses the "output" section of an input config, appending "output..." messages to errors on failure.
+    static std::optional<OutputSettings> FromYaml(const YAML::Node &node, std::vector<std::string> &errors);
+    // ROOT's algorithm * 100 + level encoding; a level alone uses ROOT's global algorithm. Unset without either field.
+    std::optional<int> CompressionSettings() const;
+    void Apply(ROOT::RDF::RSnapshotOptions &options) const;
+};
+
+struct CutflowStage
+{
+    std::string Name;
+    Long64_t Passed = 0;
+    double PassedWeight = 0.0;
+    // Events passing this cut on its own. Only the classic path evaluates every cut on every event, so RDF leaves it unset.
+    std::optional<Long64_t> Individual;
+    std::optional<double> IndividualWeight;
+};
+
+struct Cutflow
+{
+    Long64_t Total = 0;
+    double TotalWeight = 0.0;
+    std::vector<CutflowStage> Stages;
+};
+
 class AnalysisManager
 {
   public:
@@ -54,8 +194,16 @@ class AnalysisManager
     ConfigValidationResult PreflightInputConfig(const std::string &yamlPath) const;
     ConfigValidationResult PreflightCutConfig(const std::string &yamlPath) const;
     ConfigValidationResult PreflightHistogramConfig(const std::string &yamlPath) const;
+    // Validates the three files concurrently; an empty path is skipped. Expressions are checked against the current
+    // tree, and the parsed forms are reused when the cuts are enabled and the histogram fill plan is built.
+    ConfigPreflightResult PreflightConfigs(const std::string &inputYaml, const std::string &cutYaml, const std::string &histogramYaml) const;
     void LoadInputConfig(const std::string &yamlPath);
     TChain *BuildChain();
+    // Per-file entry counts and cluster boundaries let BuildChain add files without opening them. Records are keyed by
+    // tree name and file identity under CacheManager::CacheDir()/chain_index by default; an empty directory disables it.
+    void SetChainIndexDirectory(const std::string &directory);
+    // Rewrites whole-word branch aliases in expr to tree branch names, as cuts and histogram expressions are rewritten.
+    inline std::string ExpandAliases(const std::string &expr) const { return ExpandAliases_(expr); }
     static void WriteInputConfig(TTree *tree, const std::string &yamlOut, const std::vector<std::string> &filenames);
     void RegisterTree(const std::string &name);
     void RegisterTree(TTree *tree, ResourceOwnership ownership = ResourceOwnership::Borrowed);
@@ -63,9 +211,26 @@ class AnalysisManager
     bool AttachBranch(TTree *tree, const std::string &alias, TreeOpt::Om option);
     bool AttachBranch(const std::string &treeName, const std::string &alias, TreeOpt::Om option);
     double GetValue(const std::string &alias) const;
+    ValueHandle GetValueHandle(const std::string &alias) const;
+    template <typename T> BranchHandle<T> GetBranchHandle(const std::string &alias) const
+    {
+        const ValueHandle handle = GetValueHandle(alias);
+        if (handle.Type() != BranchValueTypeOf<T>())
+            throw std::runtime_error("AnalysisManager: branch handle type does not match the attached type of '" + alias + "'.");
+        return BranchHandle<T>(static_cast<const T *>(handle.Data()));
+    }
     void LoadEvent(Long64_t);
     Long64_t GetEntryCount();
-    void WriteTrees(const std::string &outfile);
+    // Deactivates input branches that no configured alias, cut, or histogram expression reads and caches the rest in a
+    // TTreeCache (cacheBytes = 0 sizes it for one cluster of the active branches). Re-applied as cuts and histograms are
+    // enabled. Branches read outside the manager must be listed in keepBranches.
+    void OptimizeInputReads(Long64_t cacheBytes = 0, bool asyncPrefetch = true, const std::vector<std::string> &keepBranches = {});
+    InputReadStatistics GetInputReadStatistics() const;
+    // Compresses with settings when given, otherwise with the manager's output settings.
+    void WriteTrees(const std::string &outfile, const std::optional<OutputSettings> &settings = std::nullopt);
+    // Applies to snapshots and tree output from now on; LoadInputConfig sets it from the config's output section.
+    void SetOutputSettings(const OutputSettings &settings);
+    inline const OutputSettings &GetOutputSettings() const { return m_OutputSettings; }
 
     void LoadCutConfig(const std::string &yamlPath);
     void RegisterCut(const std::string &name, const std::string &expr);
@@ -75,21 +240,66 @@ class AnalysisManager
     bool PassesCuts(const std::vector<std::string> &names);
     bool PassesCuts(std::initializer_list<std::string> names);
     bool PassesAllCuts();
+    bool PassesAllCuts(double weight);
+    Long64_t SelectEntries(Long64_t first, Long64_t count, std::vector<Long64_t> &selected, std::size_t blockSize = 256);
+    // Entries passing every enabled cut, nominally or under a cut-level variation. The list is stored under
+    // CacheManager::CacheDir()/selections by default, keyed by the expanded nominal and varied cuts and the input file
+    // identities, and read back instead of re-evaluating the cuts.
+    const std::vector<Long64_t> &GetSelectedEntries();
+    void SetSelectionCacheDirectory(const std::string &directory);
+    void EnableAdaptiveCutOrder(Long64_t learningEvents = 1000);
+    void DisableAdaptiveCutOrder();
+    inline bool IsCutOrderLearned() const { return !m_CutOrder.empty(); }
+    std::vector<CutStatistics> GetCutStatistics() const;
+    std::string RunStatistics() const;
+    // Classic: PassesAllCuts() counts every enabled cut in registration order. RDF: stages come from Report() on the
+    // filters applied after this call, and rdfWeight, if given, is summed per stage in the same event loop.
+    void EnableCutflow(const std::string &rdfWeight = "");
+    void DisableCutflow();
+    inline bool IsCutflowEnabled() const { return m_CutflowEnabled; }
+    Cutflow GetCutflow() const;
+    void WriteCutflow(const std::string &outfile) const;
     void WriteCutConfig(const std::string &yamlPath) const;
     std::string GetCutExpression(const std::string &name) const;
     std::vector<std::string> ListInputFiles() const;
+    DataFormat GetInputFormat() const { return m_InputFormat; }
     std::map<std::string, std::string> ListCutExpressions() const;
+    // Every histogram the variation affects gets a copy named hist_<alias>_<prefix>_<variation> (hist_<alias>_<variation>
+    // without a prefix) that is filled from the varied expressions in the same pass. Redeclaring an identical variation
+    // is a no-op; changing one that a dataframe has already registered is an error.
+    void DeclareVariation(SystematicVariation variation);
+    std::vector<std::string> ListVariations() const;
     std::string SnapshotState() const;
 
     void LoadHistogramConfig(const std::string &yamlPath, const std::string &prefix = "");
     void LoadHistogramTemplateFile(const std::string &histfile);
     void BookHistogram(const std::string &alias, std::vector<double> binfo, const std::string &prefix = "");
+    // Books any HistogramSpec; an empty x expression fills the alias itself.
+    void BookHistogram(const std::string &alias, HistogramSpec spec, const std::string &prefix = "");
     void RegisterHistogram(const std::string &alias, TH1 *hist, const std::string &prefix = "",
                            ResourceOwnership ownership = ResourceOwnership::Borrowed);
     void FillHistograms(double weight);
+    // Applies the enabled cuts per variation: nominal histograms fill when PassesAllCuts(weight) does, histograms of a
+    // cut-level variation when the cuts pass with its varied aliases. Use it instead of gating FillHistograms yourself.
+    void FillSelectedHistograms(double weight);
+    void SetFillBufferSize(std::size_t entries);
+    inline std::size_t GetFillBufferSize() const { return m_FillBufferSize; }
+    void FlushHistograms();
     void WriteHistogramConfig(const std::string &yamlOut);
     void WriteHistograms(const std::string &outfile);
 
+    // Runs callback(worker, entry) for every entry after loading it into the worker. With more than one thread each
+    // worker owns its own chain, cut formulas, derived variables, and histogram clones; the clones are added to this
+    // manager's histograms in worker order once all workers finish. nThreads 0 uses the running DAG node's thread grant,
+    // or every hardware thread outside a DAG. Returns the number of processed entries.
+    using EventLoopCallback = std::function<void(AnalysisManager &worker, Long64_t entry)>;
+    Long64_t RunEventLoop(const EventLoopCallback &callback, unsigned int nThreads = 0, const std::function<bool()> &shouldStop = {});
+    // RunEventLoop over GetSelectedEntries() only.
+    Long64_t RunSelectedEventLoop(const EventLoopCallback &callback, unsigned int nThreads = 0, const std::function<bool()> &shouldStop = {});
+    double *GetVariablePointer(const std::string &alias) const;
+
+    // An input config with input.ntuple instead of input.tree reads an RNTuple. InitRdfFromFile detects the format from
+    // the object stored under treename.
     void InitRdfFromConfig(const std::string &yamlPath);
     void InitRdfFromFile(const std::string &treename, const std::string &rootfile);
 
@@ -97,7 +307,10 @@ class AnalysisManager
     {
         if (!m_UseRdf) throw std::runtime_error("RDF not initialized");
         m_RdfNode = m_RdfNode->Define(name, std::forward<F>(func), vars);
+        if (m_RdfColumns.Columns) m_RdfColumns.Columns->insert(name);
     }
+    // expr is either a string expression compiled by the interpreter or "--lambda:<name>", which defines the column with
+    // a define registered in the LambdaManager or the process-wide LambdaManager::Library().
     void DefineRdfVariable(const std::string &name, const std::string &expr);
 
     template <typename F> void ApplyRdfFilter(const std::string &name, F &&func, std::vector<std::string> vars, const std::string &expr)
@@ -111,21 +324,39 @@ class AnalysisManager
             m_RdfNode = m_RdfNode->Filter(std::forward<F>(func), vars, name);
             LOG_INFO("AnalysisManager", "Lambda filter is applied and registered. name : " << name << " and expr : --lambda:" << expr);
             m_RawCutExpr[name] = "--lambda:" + expr;
+            AddToCutSequence_(name);
             m_AppliedRdfCuts.insert(name);
+            BookRdfCutflowStage_(name);
         }
     }
     void ApplyRdfFilter(const std::string &name);
     void ApplyRdfFilter(const std::string &name, const std::string &expr);
     void ApplyRdfFilters(const std::vector<std::string> &names);
     void ApplyAllRdfFilters();
-    void WriteRdfSnapshot(const std::string &treeName, const std::string &fileName, TreeOpt::Om option);
-    void BookRdfHistogram1D(const std::string &alias, const std::string &prefix, std::vector<double> binfo,
-                            const std::string &expression = "");
+    void WriteRdfSnapshot(const std::string &treeName, const std::string &fileName, TreeOpt::Om option, DataFormat format = DataFormat::TTree,
+                          const std::optional<OutputSettings> &settings = std::nullopt);
+    void BookRdfHistogram1D(const std::string &alias, const std::string &prefix, std::vector<double> binfo, const std::string &expression = "");
+    void BookRdfHistogram(const std::string &alias, const std::string &prefix, HistogramSpec spec);
+    // Branches one filtered node per region off the current node, applying the region's registered cuts in order. Every
+    // RDF histogram, booked before or after, is also booked in each region. WriteRdfHistograms runs the inclusive and
+    // region histograms in one event loop and writes each region's histograms to a directory named after the region.
+    void DefineRegions(const std::map<std::string, std::vector<std::string>> &regions);
+    std::vector<std::string> ListRegions() const;
     void WriteRdfHistograms(const std::string &outfile);
     void BookRdfHistogramsFromConfig(const std::string &yamlPath, const std::string &prefix = "");
     void BookRdfHistogramsFromFile(const std::string &histfile);
+    // Sizes ROOT's implicit-MT pool to nThreads, or with 0 to the threads the running DAG node was granted (all hardware
+    // threads outside a DAG). ROOT nodes run one at a time, so each can resize the process-wide pool to its own grant.
+    void EnableMT(unsigned int nThreads = 0);
     inline void DisableMT() { ROOT::DisableImplicitMT(); }
     LambdaManager *GetLambdaManager();
+    // Enables the compiled expression cache under directory, e.g. CacheManager::CacheDir() + "/rdf_expressions"; an
+    // empty directory disables it. Libraries cached there for this ROOT version are loaded now, and string Define and
+    // Filter expressions found in them skip the interpreter.
+    void SetRdfExpressionCacheDirectory(const std::string &directory);
+    // Compiles the string expressions interpreted since the cache was enabled into one library for later runs. Returns
+    // the number of compiled expressions; a failed compile is logged and leaves the expressions interpreted.
+    std::size_t SaveRdfExpressionCache();
     std::ofstream OpenOutputFile(const std::string &filename, const std::string &mode = "recreate") const;
 
     std::unique_ptr<AnalysisManager> Fork();
@@ -162,35 +393,270 @@ class AnalysisManager
 
     std::map<std::string, BranchInfo> m_BranchMap;
     std::map<std::string, void *> m_BranchData;
+    std::map<std::string, ValueHandle> m_BranchHandles;
     std::map<std::string, BranchInfo> m_NewBranchMap;
     std::map<std::string, double *> m_NewBranchData;
 
-    std::map<std::string, std::map<std::string, std::vector<double>>> m_HistMap;
+    std::map<std::string, std::map<std::string, HistogramSpec>> m_HistSpecs;
     std::map<std::string, std::map<std::string, TH1 *>> m_HistData;
     std::map<std::string, std::map<std::string, ResourceOwnership>> m_HistOwnership;
-    std::map<std::string, std::map<std::string, std::string>> m_HistExpressions;
-    std::map<std::string, std::map<std::string, TTreeFormula *>> m_HistFormulas;
     std::map<std::string, std::map<std::string, std::vector<double>>> m_LoadedHistMap;
     std::map<std::string, std::map<std::string, TH1 *>> m_LoadedHistData;
     std::map<std::string, std::map<std::string, ROOT::RDF::RResultPtr<TH1>>> m_HistRdf;
 
     std::map<std::string, std::string> m_RawCutExpr;
+    // Cut names in first-registration order, each listed once; the cutflow stages follow it.
+    std::vector<std::string> m_CutSequence;
     std::set<std::string> m_AppliedRdfCuts;
-    std::map<std::string, TTreeFormula *> m_CutFormulas;
+    void AddToCutSequence_(const std::string &name);
+
+    // Enabled classic cuts run as compiled bytecode over the branch buffers when the expression fits the compiled
+    // subset, otherwise through a TTreeFormula.
+    struct EnabledCut
+    {
+        CompiledExpression Compiled;
+        std::unique_ptr<TTreeFormula> Formula;
+        Long64_t EvaluationCount = 0;
+        Long64_t PassCount = 0;
+        long long CostNs = 0;
+        std::size_t Rank = std::numeric_limits<std::size_t>::max();
+        // Tree entry this cut was last observed on, so a second query in the same event is not counted again.
+        Long64_t ObservedEntry = -1;
+
+        bool Passes() const { return Formula ? Formula->EvalInstance() != 0.0 : Compiled.Evaluate() != 0.0; }
+    };
+    std::map<std::string, EnabledCut> m_EnabledCuts;
+
+    // Adaptive ordering: every cut is timed over the first m_CutLearningEvents decisions, then PassesAllCuts and
+    // PassesCuts short-circuit in increasing cost / rejection-rate order. Cuts are pure, so results do not change.
+    // Decisions are counted per tree entry, however many cut queries an event makes. Event-loop workers learn from their
+    // own ranges and RunEventLoop adds their statistics to this manager, which then learns from the totals.
+    Long64_t m_CutLearningEvents = 0;
+    Long64_t m_CutObservedEvents = 0;
+    Long64_t m_CutObservedEntry = -1;
+    std::vector<EnabledCut *> m_CutOrder;
+    std::vector<std::string> m_CutQueryNames;
+    std::vector<EnabledCut *> m_CutQueryOrder;
+    template <typename Names> bool PassesNamedCuts_(const Names &names);
+    Long64_t CutObservationEntry_() const;
+    bool ObserveCut_(EnabledCut &cut, Long64_t entry);
+    void CountObservedEvent_(Long64_t entry);
+    void LearnCutOrder_();
+    void ResetCutOrder_();
+    void MergeCutStatistics_(const AnalysisManager &worker);
+
+    // Cutflow counters are plain members: event-loop workers each count their own range and RunEventLoop adds them to
+    // this manager after the join, so the hot loop never touches shared state.
+    struct CutflowCounter
+    {
+        std::string Name;
+        const EnabledCut *Cut = nullptr;
+        Long64_t Individual = 0;
+        Long64_t Passed = 0;
+        double IndividualWeight = 0.0;
+        double PassedWeight = 0.0;
+    };
+    bool m_CutflowEnabled = false;
+    Long64_t m_CutflowTotal = 0;
+    double m_CutflowTotalWeight = 0.0;
+    std::vector<CutflowCounter> m_CutflowCounters;
+    std::string m_RdfCutflowWeight;
+    std::optional<ROOT::RDF::RResultPtr<ULong64_t>> m_RdfCutflowEntries;
+    std::optional<ROOT::RDF::RResultPtr<double>> m_RdfCutflowEntriesWeight;
+    // Report() covers the named filters upstream of the node it is booked on. The node after the last filter is kept,
+    // and the report is booked on it once, by the next event loop or the first cutflow read, whichever comes first.
+    mutable std::optional<ROOT::RDF::RNode> m_RdfCutflowNode;
+    mutable std::optional<ROOT::RDF::RResultPtr<ROOT::RDF::RCutFlowReport>> m_RdfCutflowReport;
+    std::map<std::string, ROOT::RDF::RResultPtr<double>> m_RdfCutflowWeights;
+    bool CountCutflow_(double weight);
+    void MergeCutflow_(const AnalysisManager &worker);
+    void ResetCutflow_();
+    void BookRdfCutflowStage_(const std::string &name);
+    void BookRdfCutflowReport_() const;
+
+    // Flattened per-event histogram work, rebuilt on the first FillHistograms() after booking or chain changes.
+    struct FillSource
+    {
+        ValueHandle Handle;
+        CompiledExpression Compiled;
+        std::unique_ptr<TTreeFormula> Formula;
+
+        bool IsSet() const { return Formula || Compiled.IsValid() || Handle.IsValid(); }
+        double Evaluate() const
+        {
+            if (Formula) return Formula->EvalInstance();
+            return Compiled.IsValid() ? Compiled.Evaluate() : Handle.Get();
+        }
+    };
+    struct HistogramFill
+    {
+        TH1 *Histogram = nullptr;
+        HistogramKind Kind = HistogramKind::TH1D;
+        FillSource Value;
+        FillSource Y;
+        FillSource Z;
+        FillSource Weight;
+        // 0 fills with the nominal selection, i > 0 with m_VariedSelections[i - 1].
+        std::size_t Selection = 0;
+        bool Buffered = false;
+        std::vector<double> BufferedValues;
+        std::vector<double> BufferedWeights;
+
+        void Fill(double value, double weight) const;
+    };
+    std::vector<HistogramFill> m_FillPlan;
+    bool m_FillPlanReady = false;
+    std::size_t m_FillBufferSize = 0;
+    std::size_t m_BufferedEvents = 0;
+    void FillPlan_(double weight, const std::vector<char> *selectionPasses);
+
+    // Varied histograms are ordinary m_HistData entries whose spec carries the variation name and the rewritten
+    // expressions, so workers, merging, and output treat them like any other histogram.
+    std::map<std::string, SystematicVariation> m_Variations;
+    // Enabled cuts re-evaluated under a cut-level variation; cuts that read no varied alias use the nominal instance.
+    struct VariedSelection
+    {
+        std::string Variation;
+        std::map<std::string, EnabledCut> Cuts;
+    };
+    std::vector<VariedSelection> m_VariedSelections;
+    std::vector<char> m_SelectionPasses;
+    bool m_RdfVariationWeight = false;
+    // Aliases varied by an RDF Vary. The variation is registered on the alias column, so RDF expressions keep these unexpanded.
+    std::set<std::string> m_RdfVariedAliases;
+    // Reads the varied copies of one booked RDF histogram, keyed "<variation>:0", after the event loop.
+    using VariedRdfResults = std::function<std::vector<std::pair<std::string, TH1 *>>()>;
+    std::map<std::string, std::map<std::string, VariedRdfResults>> m_HistRdfVariations;
+    void LoadVariations_(const YAML::Node &config, bool affectsCuts);
+    void PreflightVariations_(const YAML::Node &config, ConfigValidationResult &result) const;
+    bool VariationAffects_(const SystematicVariation &variation, const HistogramSpec &spec) const;
+    void SyncVariedHistograms_();
+    void BuildVariedSelections_();
+    bool PassesVariedSelection_(const VariedSelection &selection) const;
+    void ApplyRdfVariation_(const SystematicVariation &variation);
+
+    struct InputReadPlan
+    {
+        Long64_t CacheBytes = 0;
+        bool AsyncPrefetch = true;
+        std::vector<std::string> KeepBranches;
+    };
+    std::optional<InputReadPlan> m_InputReadPlan;
+    std::set<std::string> m_ActiveBranches;
+    std::size_t m_TotalBranches = 0;
+    // Bytes read from this chain's files and through their caches. The open file's counters are taken when it is entered and
+    // booked when the loop leaves it, so files the chain has closed still count.
+    struct InputFileReads
+    {
+        Long64_t Bytes = 0;
+        Long64_t CacheBytes = 0;
+        Long64_t UncachedBytes = 0;
+    };
+    InputFileReads m_InputReadsDone;
+    InputFileReads m_InputReadsAtEntry;
+    Long64_t m_InputFileFirst = 0;
+    Long64_t m_InputFileEnd = -1;
+    void ApplyInputReadPlan_();
+    InputFileReads CurrentFileReads_() const;
+    void EnterInputFile_();
+    void LeaveInputFile_();
+    void ReadInputEntry_(Long64_t entry);
+    void StartInputReadStatistics_();
+    void ReportInputReads_() const;
 
     std::vector<std::string> m_InputFiles;
     std::string m_InTreeName;
+    DataFormat m_InputFormat = DataFormat::TTree;
+    OutputSettings m_OutputSettings;
     TChain *m_CurrentTree = nullptr;
     std::shared_ptr<TChain> m_CurrentTreeOwner;
+    std::optional<std::string> m_ChainIndexDirectory;
+    Long64_t m_EntryCount = -1;
+    std::vector<std::pair<Long64_t, Long64_t>> m_ChainClusters;
+    std::optional<std::vector<Long64_t>> IndexChainFiles_();
+    // Alias rewriting: each alias maps to its real name with every alias sorted after it already applied, which is what
+    // replacing the aliases one after another in map order produces. Aliases that are not plain words use the regex path.
+    std::unordered_map<std::string, std::string> m_AliasExpansions;
+    bool m_AliasRegexFallback = false;
+    void ReadInputConfig_(const std::string &yamlPath);
+    void BuildAliasTable_();
     std::string ExpandAliases_(const std::string &expr) const;
-    double GetNewVar_(const std::string &alias) const;
+    std::string ExpandAliases_(const std::string &expr, const std::set<std::string> &kept) const;
+    CompiledExpression TryCompile_(const std::string &expandedExpr) const;
+    // Expressions preflighted against the current tree, keyed by expanded text. Enabling a cut or building the fill plan
+    // copies the compiled form or takes over the validated TTreeFormula instead of parsing the expression again.
+    struct PreflightedExpression
+    {
+        CompiledExpression Compiled;
+        std::unique_ptr<TTreeFormula> Formula;
+        bool Valid = false;
+    };
+    mutable std::mutex m_PreflightMutex;
+    mutable std::map<std::string, PreflightedExpression> m_PreflightedExpressions;
+    mutable std::size_t m_PreflightReuses = 0;
+    std::unique_ptr<AnalysisManager> PreflightSchema_(const std::string &inputYaml) const;
+    bool PreflightExpression_(const std::string &expandedExpr) const;
+    std::optional<PreflightedExpression> TakePreflighted_(const std::string &expandedExpr) const;
+    EnabledCut MakeEnabledCut_(const std::string &name, const std::string &expr) const;
     void LoadHists_(const std::string &histfile);
+    void BuildFillPlan_();
+    void ResetFillPlan_();
+    FillSource ResolveFillSource_(const std::string &expression, const std::string &formulaName, const std::string &alias) const;
     void ReleaseCurrentTree_();
+    std::unique_ptr<AnalysisManager> CloneForWorker_() const;
+    Long64_t RunEventLoop_(const EventLoopCallback &callback, unsigned int nThreads, const std::function<bool()> &shouldStop,
+                           const std::vector<Long64_t> *selection);
+
+    std::optional<std::string> m_SelectionCacheDirectory;
+    std::vector<Long64_t> m_SelectedEntries;
+    std::string m_SelectedEntriesKey;
+    std::optional<std::string> SelectionKey_() const;
+    // SelectEntries, optionally keeping the entries that pass only one of m_VariedSelections.
+    Long64_t SelectEntries_(Long64_t first, Long64_t count, std::vector<Long64_t> &selected, std::size_t blockSize, bool varied);
 
     std::unique_ptr<ROOT::RDataFrame> m_RdfRaw = nullptr;
     std::optional<ROOT::RDF::RNode> m_RdfNode;
+    // Columns of one RDF node lineage and the internal columns defined on it for expanded histogram expressions. Columns
+    // only accumulate along a lineage, so the set is extended by bookings and re-queried only after other defines.
+    struct RdfColumnRegistry
+    {
+        std::optional<std::set<std::string>> Columns;
+        std::map<std::string, std::string> Expressions;
+    };
+    RdfColumnRegistry m_RdfColumns;
+    struct RdfRegion
+    {
+        std::vector<std::string> Cuts;
+        ROOT::RDF::RNode Node;
+        RdfColumnRegistry Columns;
+        std::map<std::string, std::map<std::string, ROOT::RDF::RResultPtr<TH1>>> Histograms;
+        std::map<std::string, std::map<std::string, VariedRdfResults>> Variations;
+    };
+    std::map<std::string, RdfRegion> m_RdfRegions;
+    // Builds m_RdfRaw over the RNTuple m_InTreeName in m_InputFiles and records its entry count.
+    void InitRdfFromRNTuple_();
+    ROOT::RDF::RNode FilterRdfNode_(ROOT::RDF::RNode node, RdfColumnRegistry &registry, const std::string &name);
+    // The column names of node's lineage, listed once and kept up to date as the manager defines columns.
+    const std::set<std::string> &RdfColumnNames_(ROOT::RDF::RNode &node, RdfColumnRegistry &registry) const;
+    // Looks a compiled lambda up in this manager's LambdaManager first, then in LambdaManager::Library().
+    const RdfLambda *FindRdfLambda_(const std::string &name, RdfLambda::Kind kind) const;
+    ROOT::RDF::RResultPtr<TH1> BookRdfHistogram_(ROOT::RDF::RNode &node, RdfColumnRegistry &registry, const std::string &alias,
+                                                 const std::string &prefix, const HistogramSpec &spec, VariedRdfResults &varied);
     bool m_UseRdf = false;
     std::unique_ptr<LambdaManager> m_LambdaManager = nullptr;
+    // String expressions interpreted since the expression cache was set, keyed like the compiled entries.
+    struct RdfExpressionMiss
+    {
+        bool Filter = false;
+        std::string Expression;
+        std::vector<std::pair<std::string, std::string>> Columns;
+    };
+    std::string m_RdfExpressionCacheDirectory;
+    std::map<std::string, RdfExpressionMiss> m_RdfExpressionMisses;
+    // Filters or defines a string expression, through the compiled callable when the expression cache holds one. registry
+    // lists node's columns and gains a defined label.
+    ROOT::RDF::RNode ApplyRdfExpression_(ROOT::RDF::RNode node, RdfColumnRegistry &registry, bool filter, const std::string &label,
+                                         const std::string &expression);
 
     std::string m_Hash;
     std::string m_Basename;
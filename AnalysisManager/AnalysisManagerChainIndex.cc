@@ -0,0 +1,124 @@
+#include "AnalysisManager.hh"
+#include "AnalysisManagerDetail.inc"
+#include "CacheManager.hh"
+#include "sha256.hh"
+#include <filesystem>
+#include <fstream>
+#include <unistd.h>
+
+using namespace logger;
+using cascade::analysis_detail::FileIdentity;
+
+namespace
+{
+constexpr int CHAIN_INDEX_SCHEMA_VERSION = 1;
+
+struct FileIndex
+{
+    Long64_t Entries = 0;
+    std::vector<Long64_t> ClusterStarts;
+};
+
+std::optional<FileIndex> ReadFileIndex(const std::filesystem::path &recordPath, const nlohmann::json &identity, const std::string &tree)
+{
+    std::ifstream input(recordPath);
+    if (!input) return std::nullopt;
+    try
+    {
+        const auto record = nlohmann::json::parse(input);
+        if (record.at("schema_version") != CHAIN_INDEX_SCHEMA_VERSION || record.at("identity") != identity || record.at("tree") != tree)
+            return std::nullopt;
+        FileIndex index;
+        index.Entries = record.at("entries").get<Long64_t>();
+        index.ClusterStarts = record.at("cluster_starts").get<std::vector<Long64_t>>();
+        return index;
+    }
+    catch (const nlohmann::json::exception &error)
+    {
+        LOG_DEBUG("AnalysisManager", "Ignoring unreadable chain index record " << recordPath.string() << ": " << error.what());
+        return std::nullopt;
+    }
+}
+
+std::optional<FileIndex> ScanFile(const std::string &path, const std::string &treeName)
+{
+    std::unique_ptr<TFile> file(TFile::Open(path.c_str(), "READ"));
+    TTree *tree = file && !file->IsZombie() ? file->Get<TTree>(treeName.c_str()) : nullptr;
+    if (!tree) return std::nullopt;
+    FileIndex index;
+    index.Entries = tree->GetEntries();
+    auto cluster = tree->GetClusterIterator(0);
+    Long64_t start = 0;
+    while ((start = cluster()) < index.Entries)
+        index.ClusterStarts.push_back(start);
+    return index;
+}
+
+// Records are advisory: a write that fails only costs a rescan on the next build.
+void WriteFileIndex(const std::filesystem::path &recordPath, const nlohmann::json &identity, const std::string &path,
+                    const std::string &tree, const FileIndex &index)
+{
+    const nlohmann::json record = {{"schema_version", CHAIN_INDEX_SCHEMA_VERSION},
+                                   {"path", path},
+                                   {"tree", tree},
+                                   {"identity", identity},
+                                   {"entries", index.Entries},
+                                   {"cluster_starts", index.ClusterStarts}};
+    std::error_code error;
+    std::filesystem::create_directories(recordPath.parent_path(), error);
+    const std::filesystem::path temporary = recordPath.string() + ".tmp." + std::to_string(getpid());
+    {
+        std::ofstream output(temporary);
+        output << record.dump();
+        if (!output)
+        {
+            std::filesystem::remove(temporary, error);
+            LOG_DEBUG("AnalysisManager", "Cannot write chain index record " << recordPath.string());
+            return;
+        }
+    }
+    std::filesystem::rename(temporary, recordPath, error);
+    if (error) std::filesystem::remove(temporary, error);
+}
+} // namespace
+
+void AnalysisManager::SetChainIndexDirectory(const std::string &directory) { m_ChainIndexDirectory = directory; }
+
+std::optional<std::vector<Long64_t>> AnalysisManager::IndexChainFiles_()
+{
+    m_ChainClusters.clear();
+    if (!m_ChainIndexDirectory) m_ChainIndexDirectory = CacheManager::CacheDir() + "/chain_index";
+    if (m_ChainIndexDirectory->empty() || m_InputFiles.empty()) return std::nullopt;
+
+    std::vector<Long64_t> entries;
+    std::vector<std::pair<Long64_t, Long64_t>> clusters;
+    std::size_t scanned = 0;
+    Long64_t offset = 0;
+    for (const auto &path : m_InputFiles)
+    {
+        // Wildcards, remote URLs, and other non-regular paths are left to TChain.
+        const auto identity = FileIdentity(path);
+        if (!identity) return std::nullopt;
+        const std::filesystem::path recordPath =
+            std::filesystem::path(*m_ChainIndexDirectory) / (Sha256(m_InTreeName + '\n' + identity->dump()) + ".json");
+        auto index = ReadFileIndex(recordPath, *identity, m_InTreeName);
+        if (!index)
+        {
+            index = ScanFile(path, m_InTreeName);
+            if (!index) return std::nullopt;
+            WriteFileIndex(recordPath, *identity, path, m_InTreeName, *index);
+            ++scanned;
+        }
+        for (std::size_t cluster = 0; cluster < index->ClusterStarts.size(); ++cluster)
+        {
+            const Long64_t end = cluster + 1 < index->ClusterStarts.size() ? index->ClusterStarts[cluster + 1] : index->Entries;
+            clusters.emplace_back(offset + index->ClusterStarts[cluster], offset + end);
+        }
+        entries.push_back(index->Entries);
+        offset += index->Entries;
+    }
+    m_ChainClusters = std::move(clusters);
+    LOG_DEBUG("AnalysisManager", "Chain index covers " << m_InputFiles.size() << " files (" << scanned << " scanned) with " << offset
+                                                       << " entries.");
+    return entries;
+}
@@ -0,0 +1,244 @@
+#include "AnalysisManager.hh"
+#include <TFile.h>
+#include <TObject.h>
+#include <filesystem>
+#include <nlohmann/json.hpp>
+
+using namespace logger;
+
+namespace
+{
+constexpr const char *CUTFLOW_WEIGHT_COLUMN = "__cascade_cutflow_weight";
+
+double Ratio(double numerator, double denominator) { return denominator > 0.0 ? numerator / denominator : 0.0; }
+
+// Bin 1 holds the input ("all") and bin i + 2 holds stage i, labelled with the cut name.
+void WriteCutflowHistogram(const std::string &name, const std::string &title, const Cutflow &cutflow, double total,
+                           const std::function<double(const CutflowStage &)> &value)
+{
+    const int stages = static_cast<int>(cutflow.Stages.size());
+    TH1D histogram(name.c_str(), title.c_str(), stages + 1, 0.0, stages + 1.0);
+    histogram.SetDirectory(nullptr);
+    histogram.GetXaxis()->SetBinLabel(1, "all");
+    histogram.SetBinContent(1, total);
+    for (int stage = 0; stage < stages; ++stage)
+    {
+        histogram.GetXaxis()->SetBinLabel(stage + 2, cutflow.Stages[stage].Name.c_str());
+        histogram.SetBinContent(stage + 2, value(cutflow.Stages[stage]));
+    }
+    if (histogram.Write(histogram.GetName(), TObject::kOverwrite) < 0)
+        throw std::runtime_error("AnalysisManager: failed to write cutflow histogram: " + name);
+}
+} // namespace
+
+void AnalysisManager::EnableCutflow(const std::string &rdfWeight)
+{
+    if (!m_UseRdf)
+    {
+        if (!rdfWeight.empty())
+            throw std::invalid_argument("AnalysisManager: classic cutflow weights are passed to PassesAllCuts(weight).");
+        ResetCutflow_();
+        m_CutflowEnabled = true;
+        LOG_INFO("AnalysisManager", "Cutflow enabled for PassesAllCuts decisions.");
+        return;
+    }
+    if (!m_RdfNode) throw std::runtime_error("AnalysisManager: RDF is not initialized.");
+    if (m_CutflowEnabled) throw std::runtime_error("AnalysisManager: RDF cutflow is already enabled.");
+    // Stage sums are booked as filters are applied, so earlier filters would have no weighted entry.
+    if (!m_AppliedRdfCuts.empty()) throw std::runtime_error("AnalysisManager: enable the RDF cutflow before applying filters.");
+    if (!rdfWeight.empty())
+    {
+        m_RdfCutflowWeight = CUTFLOW_WEIGHT_COLUMN;
+        m_RdfNode = ApplyRdfExpression_(*m_RdfNode, m_RdfColumns, false, m_RdfCutflowWeight,
+                                        "static_cast<double>(" + ExpandAliases_(rdfWeight, m_RdfVariedAliases) + ")");
+        m_RdfCutflowEntriesWeight = m_RdfNode->Sum<double>(m_RdfCutflowWeight);
+    }
+    m_RdfCutflowEntries = m_RdfNode->Count();
+    m_CutflowEnabled = true;
+    LOG_INFO("AnalysisManager", "RDF cutflow enabled" << (rdfWeight.empty() ? std::string() : " with weight " + rdfWeight) << ".");
+}
+
+void AnalysisManager::DisableCutflow()
+{
+    m_CutflowEnabled = false;
+    ResetCutflow_();
+    m_RdfCutflowWeight.clear();
+    m_RdfCutflowEntries.reset();
+    m_RdfCutflowEntriesWeight.reset();
+    m_RdfCutflowNode.reset();
+    m_RdfCutflowReport.reset();
+    m_RdfCutflowWeights.clear();
+}
+
+bool AnalysisManager::CountCutflow_(double weight)
+{
+    if (m_CutflowCounters.empty())
+        for (const auto &name : m_CutSequence)
+        {
+            const auto cut = m_EnabledCuts.find(name);
+            if (cut != m_EnabledCuts.end()) m_CutflowCounters.push_back({name, &cut->second});
+        }
+    ++m_CutflowTotal;
+    m_CutflowTotalWeight += weight;
+    bool passed = true;
+    for (auto &counter : m_CutflowCounters)
+    {
+        if (!counter.Cut->Passes())
+        {
+            passed = false;
+            continue;
+        }
+        ++counter.Individual;
+        counter.IndividualWeight += weight;
+        if (!passed) continue;
+        ++counter.Passed;
+        counter.PassedWeight += weight;
+    }
+    return passed;
+}
+
+void AnalysisManager::MergeCutflow_(const AnalysisManager &worker)
+{
+    if (worker.m_CutflowCounters.empty()) return;
+    if (m_CutflowCounters.empty())
+        for (const auto &counter : worker.m_CutflowCounters)
+            m_CutflowCounters.push_back({counter.Name, &m_EnabledCuts.at(counter.Name)});
+    m_CutflowTotal += worker.m_CutflowTotal;
+    m_CutflowTotalWeight += worker.m_CutflowTotalWeight;
+    for (std::size_t index = 0; index < m_CutflowCounters.size(); ++index)
+    {
+        auto &counter = m_CutflowCounters[index];
+        const auto &other = worker.m_CutflowCounters.at(index);
+        counter.Individual += other.Individual;
+        counter.Passed += other.Passed;
+        counter.IndividualWeight += other.IndividualWeight;
+        counter.PassedWeight += other.PassedWeight;
+    }
+}
+
+void AnalysisManager::ResetCutflow_()
+{
+    m_CutflowTotal = 0;
+    m_CutflowTotalWeight = 0.0;
+    m_CutflowCounters.clear();
+}
+
+void AnalysisManager::BookRdfCutflowStage_(const std::string &name)
+{
+    if (!m_CutflowEnabled) return;
+    // A report booked before this filter would miss it.
+    m_RdfCutflowNode = *m_RdfNode;
+    m_RdfCutflowReport.reset();
+    if (!m_RdfCutflowWeight.empty()) m_RdfCutflowWeights[name] = m_RdfNode->Sum<double>(m_RdfCutflowWeight);
+}
+
+void AnalysisManager::BookRdfCutflowReport_() const
+{
+    if (m_CutflowEnabled && m_RdfCutflowNode && !m_RdfCutflowReport) m_RdfCutflowReport = m_RdfCutflowNode->Report();
+}
+
+Cutflow AnalysisManager::GetCutflow() const
+{
+    if (!m_CutflowEnabled) throw std::runtime_error("AnalysisManager: cutflow is not enabled.");
+    Cutflow cutflow;
+    if (!m_UseRdf)
+    {
+        cutflow.Total = m_CutflowTotal;
+        cutflow.TotalWeight = m_CutflowTotalWeight;
+        if (m_CutflowCounters.empty())
+        {
+            for (const auto &name : m_CutSequence)
+                if (m_EnabledCuts.count(name)) cutflow.Stages.push_back({name, 0, 0.0, 0, 0.0});
+            return cutflow;
+        }
+        for (const auto &counter : m_CutflowCounters)
+            cutflow.Stages.push_back({counter.Name, counter.Passed, counter.PassedWeight, counter.Individual, counter.IndividualWeight});
+        return cutflow;
+    }
+
+    // The first result read runs the shared event loop, which fills every other booked cutflow action as well.
+    BookRdfCutflowReport_();
+    auto entries = *m_RdfCutflowEntries;
+    cutflow.Total = static_cast<Long64_t>(*entries);
+    if (m_RdfCutflowEntriesWeight)
+    {
+        auto weight = *m_RdfCutflowEntriesWeight;
+        cutflow.TotalWeight = *weight;
+    }
+    else
+        cutflow.TotalWeight = static_cast<double>(cutflow.Total);
+    if (!m_RdfCutflowReport) return cutflow;
+    auto report = *m_RdfCutflowReport;
+    for (const auto &info : *report)
+    {
+        if (!m_AppliedRdfCuts.count(info.GetName())) continue;
+        CutflowStage stage;
+        stage.Name = info.GetName();
+        stage.Passed = static_cast<Long64_t>(info.GetPass());
+        const auto weight = m_RdfCutflowWeights.find(stage.Name);
+        if (weight != m_RdfCutflowWeights.end())
+        {
+            auto sum = weight->second;
+            stage.PassedWeight = *sum;
+        }
+        else
+            stage.PassedWeight = static_cast<double>(stage.Passed);
+        cutflow.Stages.push_back(std::move(stage));
+    }
+    return cutflow;
+}
+
+void AnalysisManager::WriteCutflow(const std::string &outfile) const
+{
+    const std::string extension = std::filesystem::path(outfile).extension().string();
+    if (extension != ".json" && extension != ".root")
+        throw std::invalid_argument("AnalysisManager: cutflow output must be a .json or .root file: " + outfile);
+    const Cutflow cutflow = GetCutflow();
+
+    if (extension == ".json")
+    {
+        nlohmann::json stages = nlohmann::json::array();
+        double previous = static_cast<double>(cutflow.Total);
+        for (const auto &stage : cutflow.Stages)
+        {
+            nlohmann::json entry = {{"name", stage.Name},
+                                    {"expression", m_RawCutExpr.count(stage.Name) ? m_RawCutExpr.at(stage.Name) : std::string()},
+                                    {"passed", stage.Passed},
+                                    {"passed_weight", stage.PassedWeight},
+                                    {"efficiency", Ratio(static_cast<double>(stage.Passed), static_cast<double>(cutflow.Total))},
+                                    {"relative_efficiency", Ratio(static_cast<double>(stage.Passed), previous)},
+                                    {"individual", nullptr},
+                                    {"individual_weight", nullptr}};
+            if (stage.Individual) entry["individual"] = *stage.Individual;
+            if (stage.IndividualWeight) entry["individual_weight"] = *stage.IndividualWeight;
+            stages.push_back(std::move(entry));
+            previous = static_cast<double>(stage.Passed);
+        }
+        const nlohmann::json document = {{"schema", "cascade.cutflow"},
+                                         {"schema_version", 1},
+                                         {"backend", m_UseRdf ? "rdf" : "classic"},
+                                         {"total", {{"events", cutflow.Total}, {"weight", cutflow.TotalWeight}}},
+                                         {"stages", stages}};
+        OpenOutputFile(outfile) << document.dump(2) << '\n';
+    }
+    else
+    {
+        TFile file(outfile.c_str(), "recreate");
+        if (file.IsZombie()) throw std::runtime_error("AnalysisManager: cannot create cutflow output file: " + outfile);
+        file.cd();
+        const double total = static_cast<double>(cutflow.Total);
+        WriteCutflowHistogram("cutflow", "Cutflow;;Events", cutflow, total,
+                              [](const CutflowStage &stage) { return static_cast<double>(stage.Passed); });
+        WriteCutflowHistogram("cutflow_weighted", "Weighted cutflow;;Sum of weights", cutflow, cutflow.TotalWeight,
+                              [](const CutflowStage &stage) { return stage.PassedWeight; });
+        if (!cutflow.Stages.empty() && cutflow.Stages.front().Individual)
+        {
+            WriteCutflowHistogram("cutflow_individual", "Individual cut passes;;Events", cutflow, total,
+                                  [](const CutflowStage &stage) { return static_cast<double>(stage.Individual.value_or(0)); });
+            WriteCutflowHistogram("cutflow_individual_weighted", "Individual cut passes;;Sum of weights", cutflow, cutflow.TotalWeight,
+                                  [](const CutflowStage &stage) { return stage.IndividualWeight.value_or(0.0); });
+        }
+        file.Close();
+    }
+    LOG_INFO("AnalysisManager", "Cutflow with " << cutflow.Stages.size() << " stages is saved in " << outfile);
+}
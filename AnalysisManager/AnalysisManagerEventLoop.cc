@@ -0,0 +1,259 @@
+#include "AnalysisManager.hh"
+#include "ExecutionResources.hh"
+#include <TChainElement.h>
+#include <TROOT.h>
+#include <algorithm>
+#include <exception>
+#include <thread>
+
+using namespace logger;
+
+namespace
+{
+using EntryRange = std::pair<Long64_t, Long64_t>;
+
+// TChain has no cluster iterator, so clusters are collected file by file and shifted by the entries of earlier files.
+// A file whose tree cannot be opened here is kept as a single range and left for the worker chain to report.
+std::vector<EntryRange> ChainClusters(TChain &chain)
+{
+    std::vector<EntryRange> clusters;
+    Long64_t offset = 0;
+    TIter next(chain.GetListOfFiles());
+    while (auto *element = static_cast<TChainElement *>(next()))
+    {
+        std::unique_ptr<TFile> file(TFile::Open(element->GetTitle(), "READ"));
+        TTree *tree = file && !file->IsZombie() ? file->Get<TTree>(element->GetName()) : nullptr;
+        if (!tree)
+        {
+            const Long64_t entries = element->GetEntries();
+            if (entries > 0 && entries != TTree::kMaxEntries) clusters.emplace_back(offset, offset + entries);
+            offset += entries > 0 && entries != TTree::kMaxEntries ? entries : 0;
+            continue;
+        }
+        const Long64_t entries = tree->GetEntries();
+        auto cluster = tree->GetClusterIterator(0);
+        Long64_t start = 0;
+        while ((start = cluster()) < entries)
+            clusters.emplace_back(offset + start, offset + std::min(cluster.GetNextEntry(), entries));
+        offset += entries;
+    }
+    return clusters;
+}
+
+// Contiguous cluster groups with roughly equal entry counts. Static assignment keeps every worker's histogram content
+// independent of scheduling, which is what makes the final merge reproducible.
+std::vector<EntryRange> PartitionClusters(const std::vector<EntryRange> &clusters, unsigned int workers)
+{
+    std::vector<EntryRange> ranges;
+    if (clusters.empty()) return ranges;
+    const Long64_t first = clusters.front().first;
+    const Long64_t total = clusters.back().second - first;
+    const std::size_t count = clusters.size();
+    std::size_t next = 0;
+    for (unsigned int worker = 0; worker < workers && next < count; ++worker)
+    {
+        const Long64_t target = first + total * (worker + 1) / workers;
+        // Leave at least one cluster for every later worker while clusters last.
+        const std::size_t reserved = std::min<std::size_t>(workers - worker - 1, count - next - 1);
+        std::size_t end = next + 1;
+        while (end < count - reserved && clusters[end].second <= target)
+            ++end;
+        if (worker + 1 == workers) end = count;
+        ranges.emplace_back(clusters[next].first, clusters[end - 1].second);
+        next = end;
+    }
+    return ranges;
+}
+
+// Cluster ranges re-expressed as positions in a sorted entry selection, dropping clusters without selected entries.
+std::vector<EntryRange> SelectionClusters(const std::vector<EntryRange> &clusters, const std::vector<Long64_t> &selection)
+{
+    std::vector<EntryRange> positions;
+    for (const auto &[first, last] : clusters)
+    {
+        const auto begin = std::lower_bound(selection.begin(), selection.end(), first);
+        const auto end = std::lower_bound(begin, selection.end(), last);
+        if (begin != end) positions.emplace_back(begin - selection.begin(), end - selection.begin());
+    }
+    return positions;
+}
+} // namespace
+
+double *AnalysisManager::GetVariablePointer(const std::string &alias) const
+{
+    const auto variable = m_NewBranchData.find(alias);
+    if (variable == m_NewBranchData.end()) throw std::runtime_error("AnalysisManager: variable is not registered: " + alias);
+    return variable->second;
+}
+
+Long64_t AnalysisManager::RunEventLoop(const EventLoopCallback &callback, unsigned int nThreads, const std::function<bool()> &shouldStop)
+{
+    return RunEventLoop_(callback, nThreads, shouldStop, nullptr);
+}
+
+Long64_t AnalysisManager::RunSelectedEventLoop(const EventLoopCallback &callback, unsigned int nThreads, const std::function<bool()> &shouldStop)
+{
+    if (!callback) throw std::invalid_argument("AnalysisManager: event loop callback is empty.");
+    return RunEventLoop_(callback, nThreads, shouldStop, &GetSelectedEntries());
+}
+
+Long64_t AnalysisManager::RunEventLoop_(const EventLoopCallback &callback, unsigned int nThreads, const std::function<bool()> &shouldStop,
+                                        const std::vector<Long64_t> *selection)
+{
+    if (!callback) throw std::invalid_argument("AnalysisManager: event loop callback is empty.");
+    if (!m_CurrentTree || m_UseRdf) throw std::runtime_error("AnalysisManager: the classic event loop requires an initialized non-RDF tree.");
+    // Loop positions index the selection when there is one and are entry numbers otherwise.
+    const Long64_t entries = selection ? static_cast<Long64_t>(selection->size()) : GetEntryCount();
+    const auto entryAt = [selection](Long64_t position) { return selection ? (*selection)[position] : position; };
+    if (nThreads == 0) nThreads = CascadeThreadBudget();
+
+    FlushHistograms();
+    m_StartTime = std::chrono::steady_clock::now();
+    if (nThreads == 1 || entries < 2)
+    {
+        // Progress and the read report follow the loop position; with a selection the last position is not the last entry.
+        StartInputReadStatistics_();
+        Long64_t processed = 0;
+        for (; processed < entries; ++processed)
+        {
+            if (processed % 500 == 0)
+            {
+                if (shouldStop && shouldStop()) break;
+                UpdateProgress_(static_cast<double>(processed) / entries);
+            }
+            const Long64_t entry = entryAt(processed);
+            ReadInputEntry_(entry);
+            callback(*this, entry);
+        }
+        ReportInputReads_();
+        if (processed == entries) UpdateProgress_(1.0);
+        return processed;
+    }
+
+    StartInputReadStatistics_();
+    auto clusters = m_ChainClusters.empty() ? ChainClusters(*m_CurrentTree) : m_ChainClusters;
+    if (selection) clusters = SelectionClusters(clusters, *selection);
+    auto ranges = PartitionClusters(clusters, nThreads);
+    if (ranges.empty()) ranges.emplace_back(0, entries);
+    ROOT::EnableThreadSafety();
+    std::vector<std::unique_ptr<AnalysisManager>> workers;
+    workers.reserve(ranges.size());
+    for (std::size_t index = 0; index < ranges.size(); ++index)
+        workers.push_back(CloneForWorker_());
+    LOG_INFO("AnalysisManager", "Classic event loop runs " << entries << " entries on " << workers.size() << " workers.");
+
+    std::atomic<Long64_t> processed{0};
+    std::atomic<bool> stop{false};
+    std::vector<std::exception_ptr> errors(workers.size());
+    std::vector<std::thread> threads;
+    threads.reserve(workers.size());
+    for (std::size_t index = 0; index < workers.size(); ++index)
+    {
+        threads.emplace_back(
+            [&, index]()
+            {
+                AnalysisManager &worker = *workers[index];
+                const auto [first, last] = ranges[index];
+                try
+                {
+                    if (worker.m_InputReadPlan && first < last) worker.m_CurrentTree->SetCacheEntryRange(entryAt(first), entryAt(last - 1) + 1);
+                    Long64_t pending = 0;
+                    for (Long64_t position = first; position < last; ++position)
+                    {
+                        if (pending == 500)
+                        {
+                            if (shouldStop && shouldStop()) stop.store(true);
+                            if (stop.load()) break;
+                            UpdateProgress_(static_cast<double>(processed.fetch_add(pending) + pending) / entries);
+                            pending = 0;
+                        }
+                        const Long64_t entry = entryAt(position);
+                        worker.ReadInputEntry_(entry);
+                        callback(worker, entry);
+                        ++pending;
+                    }
+                    processed.fetch_add(pending);
+                    worker.FlushHistograms();
+                }
+                catch (...)
+                {
+                    errors[index] = std::current_exception();
+                    stop.store(true);
+                }
+            });
+    }
+    for (auto &thread : threads)
+        thread.join();
+    for (const auto &error : errors)
+        if (error) std::rethrow_exception(error);
+
+    // Merge in worker order so the summation order, and therefore every bin, depends only on the worker count.
+    for (auto &[alias, inmap] : m_HistData)
+        for (auto &[prefix, hist] : inmap)
+            for (const auto &worker : workers)
+                hist->Add(worker->m_HistData.at(alias).at(prefix));
+    for (const auto &worker : workers)
+    {
+        MergeCutflow_(*worker);
+        MergeCutStatistics_(*worker);
+        const InputReadStatistics reads = worker->GetInputReadStatistics();
+        m_InputReadsDone.Bytes += reads.BytesRead;
+        m_InputReadsDone.CacheBytes += reads.CacheBytesRead;
+        m_InputReadsDone.UncachedBytes += reads.UncachedBytesRead;
+    }
+    if (m_CutLearningEvents > 0 && m_CutOrder.empty() && m_CutObservedEvents >= m_CutLearningEvents) LearnCutOrder_();
+    ReportInputReads_();
+    if (!stop.load()) UpdateProgress_(1.0);
+    return processed.load();
+}
+
+std::unique_ptr<AnalysisManager> AnalysisManager::CloneForWorker_() const
+{
+    auto worker = std::make_unique<AnalysisManager>();
+    worker->m_InputFiles = m_InputFiles;
+    worker->m_InTreeName = m_InTreeName;
+    worker->m_BranchMap = m_BranchMap;
+    worker->m_AliasExpansions = m_AliasExpansions;
+    worker->m_AliasRegexFallback = m_AliasRegexFallback;
+    worker->m_ChainIndexDirectory = m_ChainIndexDirectory;
+    worker->m_RawCutExpr = m_RawCutExpr;
+    worker->m_CutSequence = m_CutSequence;
+    worker->m_Variations = m_Variations;
+    if (!worker->BuildChain()) throw std::runtime_error("AnalysisManager: event loop worker cannot rebuild the input chain.");
+
+    for (const auto &[alias, info] : m_NewBranchMap)
+    {
+        worker->m_NewBranchMap[alias] = info;
+        worker->m_NewBranchData[alias] = new double(*m_NewBranchData.at(alias));
+    }
+    for (const auto &[name, _] : m_EnabledCuts)
+        worker->m_EnabledCuts[name] = worker->MakeEnabledCut_(name, m_RawCutExpr.at(name));
+    if (!m_VariedSelections.empty()) worker->BuildVariedSelections_();
+    worker->m_CutLearningEvents = m_CutLearningEvents;
+    // A learned order carries over, so workers skip their own learning window.
+    for (const EnabledCut *cut : m_CutOrder)
+        for (auto &[name, workerCut] : worker->m_EnabledCuts)
+            if (&m_EnabledCuts.at(name) == cut)
+            {
+                workerCut.Rank = cut->Rank;
+                worker->m_CutOrder.push_back(&workerCut);
+            }
+    worker->m_CutflowEnabled = m_CutflowEnabled;
+
+    for (const auto &[alias, inmap] : m_HistData)
+        for (const auto &[prefix, hist] : inmap)
+        {
+            auto *clone = static_cast<TH1 *>(hist->Clone());
+            clone->SetDirectory(nullptr);
+            clone->Reset();
+            worker->m_HistData[alias][prefix] = clone;
+            worker->m_HistOwnership[alias][prefix] = ResourceOwnership::Owned;
+            worker->m_HistSpecs[alias][prefix] = m_HistSpecs.at(alias).at(prefix);
+        }
+    worker->m_FillBufferSize = m_FillBufferSize;
+    worker->m_InputReadPlan = m_InputReadPlan;
+    // Formula compilation goes through the interpreter, so the fill plan is built here rather than on the worker thread.
+    if (!worker->m_HistData.empty()) worker->BuildFillPlan_();
+    worker->ApplyInputReadPlan_();
+    return worker;
+}
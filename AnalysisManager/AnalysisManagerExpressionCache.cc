@@ -0,0 +1,293 @@
+#include "AnalysisManager.hh"
+#include "AnalysisManagerDetail.inc"
+#include "sha256.hh"
+#include <RVersion.h>
+#include <TString.h>
+#include <TSystem.h>
+#include <dlfcn.h>
+#include <filesystem>
+#include <fstream>
+#include <numeric>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace logger;
+using cascade::analysis_detail::IsWordChar;
+using cascade::analysis_detail::RewriteWords;
+using cascade::analysis_detail::SafeColumnName;
+
+namespace
+{
+using RdfExpressionApply = std::function<ROOT::RDF::RNode(ROOT::RDF::RNode, const std::string &)>;
+using RegisterExpressions = void (*)(void (*)(const char *, const RdfExpressionApply &));
+constexpr const char *REGISTER_SYMBOL = "CascadeRegisterRdfExpressions";
+
+// Shared by every manager in the process. Libraries are never unloaded because the callables live in them. Index maps
+// the keys listed in the cache's manifests to their library, which is loaded on the first lookup of one of its keys.
+struct CompiledExpressions
+{
+    std::mutex Mutex;
+    std::set<std::string> Loaded;
+    std::map<std::string, RdfExpressionApply> Callables;
+    std::map<std::string, std::filesystem::path> Index;
+};
+
+CompiledExpressions &Compiled()
+{
+    static CompiledExpressions compiled;
+    return compiled;
+}
+
+// Called back by a library's register function while LoadExpressionLibrary holds the mutex.
+void AddCompiled(const char *key, const RdfExpressionApply &apply) { Compiled().Callables.emplace(key, apply); }
+
+std::filesystem::path LibraryDirectory(const std::string &cacheDirectory)
+{
+    return std::filesystem::path(cacheDirectory) / ("root-" + SafeColumnName(ROOT_RELEASE));
+}
+
+std::string ExpressionKey(bool filter, const std::string &expression, const std::vector<std::pair<std::string, std::string>> &columns)
+{
+    std::string text = std::string(filter ? "filter" : "define") + '\n' + expression + '\n';
+    for (const auto &[name, type] : columns)
+        text += name + ':' + type + '\n';
+    return Sha256(text + ROOT_RELEASE);
+}
+
+// dlopen runs the library's code in this process, so only libraries this user owns and nobody else can rewrite are loaded.
+bool IsTrustedLibrary(const std::filesystem::path &path)
+{
+    struct stat metadata{};
+    return lstat(path.c_str(), &metadata) == 0 && S_ISREG(metadata.st_mode) && metadata.st_uid == geteuid() &&
+           !(metadata.st_mode & (S_IWGRP | S_IWOTH));
+}
+
+void LoadExpressionLibrary(const std::filesystem::path &path)
+{
+    auto &compiled = Compiled();
+    std::lock_guard<std::mutex> lock(compiled.Mutex);
+    if (compiled.Loaded.count(path.string())) return;
+    if (!IsTrustedLibrary(path))
+    {
+        LOG_WARN("AnalysisManager", "Ignoring RDF expression library that is not a private regular file: " << path.string());
+        return;
+    }
+    void *handle = dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+    if (!handle)
+    {
+        LOG_WARN("AnalysisManager", "Cannot load RDF expression library " << path.string() << ": " << dlerror());
+        return;
+    }
+    const auto registerExpressions = reinterpret_cast<RegisterExpressions>(dlsym(handle, REGISTER_SYMBOL));
+    if (!registerExpressions)
+    {
+        LOG_WARN("AnalysisManager", "RDF expression library " << path.string() << " has no " << REGISTER_SYMBOL);
+        dlclose(handle);
+        return;
+    }
+    registerExpressions(AddCompiled);
+    compiled.Loaded.insert(path.string());
+}
+
+// Each library is published with a manifest listing its keys one per line, so indexing the cache opens no library.
+std::filesystem::path ManifestPath(const std::filesystem::path &library)
+{
+    return std::filesystem::path(library).replace_extension(".keys");
+}
+
+void WriteManifest(const std::filesystem::path &library, const std::vector<std::string> &keys)
+{
+    const std::filesystem::path manifest = ManifestPath(library);
+    const std::string temporary = manifest.string() + ".tmp." + std::to_string(getpid());
+    {
+        std::ofstream out(temporary);
+        for (const auto &key : keys)
+            out << key << '\n';
+        if (!out) throw std::runtime_error("AnalysisManager: cannot write RDF expression manifest: " + temporary);
+    }
+    std::error_code error;
+    std::filesystem::rename(temporary, manifest, error);
+    if (error) std::filesystem::remove(temporary, error);
+}
+
+std::size_t IndexManifest(const std::filesystem::path &manifest)
+{
+    const std::filesystem::path library = std::filesystem::path(manifest).replace_extension(".so");
+    if (!std::filesystem::exists(library)) return 0;
+    std::ifstream in(manifest);
+    auto &compiled = Compiled();
+    std::lock_guard<std::mutex> lock(compiled.Mutex);
+    std::size_t keys = 0;
+    for (std::string key; std::getline(in, key);)
+    {
+        if (key.empty()) continue;
+        compiled.Index.emplace(key, library);
+        ++keys;
+    }
+    return keys;
+}
+
+RdfExpressionApply FindCompiled(const std::string &key)
+{
+    auto &compiled = Compiled();
+    std::filesystem::path library;
+    {
+        std::lock_guard<std::mutex> lock(compiled.Mutex);
+        const auto found = compiled.Callables.find(key);
+        if (found != compiled.Callables.end()) return found->second;
+        const auto indexed = compiled.Index.find(key);
+        if (indexed == compiled.Index.end()) return {};
+        library = indexed->second;
+    }
+    LoadExpressionLibrary(library);
+    std::lock_guard<std::mutex> lock(compiled.Mutex);
+    const auto found = compiled.Callables.find(key);
+    return found != compiled.Callables.end() ? found->second : RdfExpressionApply{};
+}
+} // namespace
+
+void AnalysisManager::SetRdfExpressionCacheDirectory(const std::string &directory)
+{
+    m_RdfExpressionCacheDirectory = directory;
+    m_RdfExpressionMisses.clear();
+    if (directory.empty()) return;
+    std::error_code error;
+    std::size_t libraries = 0;
+    std::size_t expressions = 0;
+    for (const auto &entry : std::filesystem::directory_iterator(LibraryDirectory(directory), error))
+    {
+        if (entry.path().extension() != ".keys" || entry.path().filename().string().find(".tmp.") != std::string::npos) continue;
+        const std::size_t keys = IndexManifest(entry.path());
+        if (keys == 0) continue;
+        expressions += keys;
+        ++libraries;
+    }
+    LOG_INFO("AnalysisManager", "RDF expression cache " << directory << " indexes " << expressions << " compiled expressions in " << libraries
+                                                        << " libraries.");
+}
+
+ROOT::RDF::RNode AnalysisManager::ApplyRdfExpression_(ROOT::RDF::RNode node, RdfColumnRegistry &registry, bool filter, const std::string &label,
+                                                     const std::string &expression)
+{
+    const auto interpret = [&]() -> ROOT::RDF::RNode
+    {
+        if (filter) return node.Filter(expression, label);
+        return node.Define(label, expression);
+    };
+    // Records a defined label once the returned node carries it; the lookups below only see the columns upstream of it.
+    const auto track = [&](ROOT::RDF::RNode result)
+    {
+        if (!filter && registry.Columns) registry.Columns->insert(label);
+        return result;
+    };
+    if (m_RdfExpressionCacheDirectory.empty()) return track(interpret());
+
+    // The compiled callable takes the expression's columns as parameters of the same name, so columns whose names are
+    // not identifiers (the interpreter rewrites those) keep the expression interpreted.
+    const std::set<std::string> &available = RdfColumnNames_(node, registry);
+    for (const auto &name : available)
+        if (!std::all_of(name.begin(), name.end(), IsWordChar) && expression.find(name) != std::string::npos) return track(interpret());
+    std::vector<std::pair<std::string, std::string>> columns;
+    RewriteWords(expression,
+                 [&](const std::string &word) -> const std::string *
+                 {
+                     const bool seen = std::any_of(columns.begin(), columns.end(), [&word](const auto &column) { return column.first == word; });
+                     if (!seen && available.count(word))
+                         columns.emplace_back(word, node.GetColumnType(word));
+                     return nullptr;
+                 });
+    if (std::any_of(columns.begin(), columns.end(), [](const auto &column) { return column.second.empty(); })) return track(interpret());
+
+    const std::string key = ExpressionKey(filter, expression, columns);
+    if (const RdfExpressionApply callable = FindCompiled(key)) return track(callable(node, label));
+    m_RdfExpressionMisses.emplace(key, RdfExpressionMiss{filter, expression, std::move(columns)});
+    return track(interpret());
+}
+
+std::size_t AnalysisManager::SaveRdfExpressionCache()
+{
+    if (m_RdfExpressionCacheDirectory.empty()) throw std::runtime_error("AnalysisManager: RDF expression cache is not enabled.");
+    if (m_RdfExpressionMisses.empty()) return 0;
+
+    std::vector<std::string> keys;
+    for (const auto &[key, _] : m_RdfExpressionMisses)
+        keys.push_back(key);
+    const std::filesystem::path directory = LibraryDirectory(m_RdfExpressionCacheDirectory);
+    const std::string name = "expressions_" + Sha256(std::accumulate(keys.begin(), keys.end(), std::string())).substr(0, 16);
+    const std::filesystem::path library = directory / (name + ".so");
+    const std::size_t count = m_RdfExpressionMisses.size();
+    if (std::filesystem::exists(library))
+    {
+        if (!std::filesystem::exists(ManifestPath(library))) WriteManifest(library, keys);
+        LoadExpressionLibrary(library);
+        m_RdfExpressionMisses.clear();
+        return count;
+    }
+
+    std::filesystem::create_directories(directory);
+    std::filesystem::permissions(directory, std::filesystem::perms::owner_all, std::filesystem::perm_options::replace);
+    // Concurrent runs compile under their own names; the rename publishes one complete library.
+    const std::string stem = (directory / (name + ".tmp." + std::to_string(getpid()))).string();
+    {
+        std::ofstream source(stem + ".cxx");
+        source << "// Generated by Cascade from RDF string expressions.\n"
+                  "#include <ROOT/RDataFrame.hxx>\n"
+                  "#include <ROOT/RVec.hxx>\n"
+                  "#include <TMath.h>\n"
+                  "#include <cmath>\n"
+                  "using namespace ROOT::VecOps;\n"
+                  "using CascadeRdfApply = std::function<ROOT::RDF::RNode(ROOT::RDF::RNode, const std::string &)>;\n"
+                  "extern \"C\" void "
+               << REGISTER_SYMBOL << "(void (*add)(const char *, const CascadeRdfApply &))\n{\n";
+        for (const auto &[key, miss] : m_RdfExpressionMisses)
+        {
+            std::string parameters;
+            std::string names;
+            for (const auto &[column, type] : miss.Columns)
+            {
+                parameters += (parameters.empty() ? "const " : ", const ") + type + " &" + column;
+                names += (names.empty() ? "\"" : ", \"") + column + "\"";
+            }
+            const std::string callable = "[](" + parameters + ")" + (miss.Filter ? " -> bool" : "") + " { return (" + miss.Expression + "); }";
+            source << "    add(\"" << key << "\", [](ROOT::RDF::RNode node, const std::string &label) { return ROOT::RDF::RNode(node."
+                   << (miss.Filter ? "Filter(" + callable + ", {" + names + "}, label)" : "Define(label, " + callable + ", {" + names + "})")
+                   << "); });\n";
+        }
+        source << "}\n";
+        if (!source) throw std::runtime_error("AnalysisManager: cannot write RDF expression source: " + stem + ".cxx");
+    }
+
+    // ACLiC's build command compiles with the compiler and flags ROOT itself was built with.
+    TString command = gSystem->GetMakeSharedLib();
+    command.ReplaceAll("$SourceFiles", (stem + ".cxx").c_str());
+    command.ReplaceAll("$ObjectFiles", (stem + ".o").c_str());
+    command.ReplaceAll("$SharedLib", (stem + ".so").c_str());
+    command.ReplaceAll("$BuildDir", directory.c_str());
+    command.ReplaceAll("$LibName", name.c_str());
+    command.ReplaceAll("$IncludePath", gSystem->GetIncludePath());
+    command.ReplaceAll("$Opt", gSystem->GetFlagsOpt());
+    command.ReplaceAll("$LinkedLibs", "");
+    command.ReplaceAll("$DepLibs", "");
+    LOG_INFO("AnalysisManager", "Compiling " << count << " RDF expressions into " << library.string());
+    const int status = gSystem->Exec(command.Data());
+    std::error_code error;
+    std::filesystem::remove(stem + ".o", error);
+    if (status != 0 || !std::filesystem::exists(stem + ".so"))
+    {
+        LOG_WARN("AnalysisManager", "Compiling RDF expressions failed with status " << status << "; they stay interpreted. Source kept at "
+                                                                                    << stem << ".cxx");
+        std::filesystem::remove(stem + ".so", error);
+        return 0;
+    }
+    std::filesystem::remove(stem + ".cxx", error);
+    std::filesystem::rename(stem + ".so", library, error);
+    if (error)
+    {
+        std::filesystem::remove(stem + ".so", error);
+        if (!std::filesystem::exists(library)) throw std::runtime_error("AnalysisManager: cannot publish RDF expression library: " + library.string());
+    }
+    WriteManifest(library, keys);
+    LoadExpressionLibrary(library);
+    m_RdfExpressionMisses.clear();
+    return count;
+}
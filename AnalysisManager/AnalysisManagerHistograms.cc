@@ -0,0 +1,311 @@
+#include "AnalysisManager.hh"
+#include "AnalysisManagerDetail.inc"
+#include <TH2D.h>
+#include <TH3D.h>
+#include <TProfile.h>
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
+using cascade::analysis_detail::ValidateHistogramBins;
+
+namespace
+{
+const std::vector<std::pair<std::string, HistogramKind>> HISTOGRAM_KINDS{
+    {"TH1D", HistogramKind::TH1D}, {"TH2D", HistogramKind::TH2D}, {"TH3D", HistogramKind::TH3D}, {"TProfile", HistogramKind::TProfile}};
+
+const char *AXIS_KEYS[] = {"", "y", "z"};
+
+const std::string &KindName(HistogramKind kind)
+{
+    for (const auto &[name, value] : HISTOGRAM_KINDS)
+        if (value == kind) return name;
+    throw std::logic_error("AnalysisManager: unknown histogram kind.");
+}
+
+std::size_t AxisCount(HistogramKind kind)
+{
+    switch (kind)
+    {
+    case HistogramKind::TH2D:
+    case HistogramKind::TProfile:
+        return 2;
+    case HistogramKind::TH3D:
+        return 3;
+    default:
+        return 1;
+    }
+}
+
+// Whether axis index of kind is binned; the profiled y axis of a TProfile only supplies values.
+bool IsBinned(HistogramKind kind, std::size_t index) { return !(kind == HistogramKind::TProfile && index == 1); }
+
+std::string AxisPath(const std::string &path, std::size_t index) { return index == 0 ? path : path + "." + AXIS_KEYS[index]; }
+
+// Semantic checks shared by YAML parsing and programmatic booking. path names the entry in messages.
+void CheckSpec(const HistogramSpec &spec, const std::string &path, const std::string &name, std::vector<std::string> &errors)
+{
+    if (spec.Axes.size() != AxisCount(spec.Kind))
+    {
+        errors.push_back(path + " needs " + std::to_string(AxisCount(spec.Kind)) + " axes for " + KindName(spec.Kind));
+        return;
+    }
+    for (std::size_t index = 0; index < spec.Axes.size(); ++index)
+    {
+        const HistogramAxis &axis = spec.Axes[index];
+        const std::string axisPath = AxisPath(path, index);
+        if (axis.Expression.empty()) errors.push_back(axisPath + ".expr cannot be empty");
+        if (!IsBinned(spec.Kind, index)) continue;
+        if (axis.Edges.empty())
+        {
+            try
+            {
+                ValidateHistogramBins({static_cast<double>(axis.Bins), axis.Min, axis.Max}, index == 0 ? name : name + "." + AXIS_KEYS[index]);
+            }
+            catch (const std::invalid_argument &error)
+            {
+                errors.push_back(error.what());
+            }
+            continue;
+        }
+        bool increasing = axis.Edges.size() >= 2;
+        for (std::size_t edge = 0; increasing && edge < axis.Edges.size(); ++edge)
+            increasing = std::isfinite(axis.Edges[edge]) && (edge == 0 || axis.Edges[edge] > axis.Edges[edge - 1]);
+        if (!increasing) errors.push_back(axisPath + ".edges must list at least two finite, strictly increasing bin edges");
+    }
+}
+
+void ParseAxis(const YAML::Node &node, const std::string &axisPath, bool binned, HistogramAxis &axis, std::vector<std::string> &errors)
+{
+    if (!node["expr"] || !node["expr"].IsScalar())
+        errors.push_back(axisPath + ".expr must be a non-empty string");
+    else
+        axis.Expression = node["expr"].as<std::string>();
+    const YAML::Node bins = node["bins"];
+    const YAML::Node edges = node["edges"];
+    if (!binned)
+    {
+        if (bins || edges) errors.push_back(axisPath + " is profiled and takes no bins or edges");
+        return;
+    }
+    if (bins && edges)
+    {
+        errors.push_back(axisPath + " must set either bins or edges, not both");
+        return;
+    }
+    try
+    {
+        if (edges)
+        {
+            if (!edges.IsSequence())
+                errors.push_back(axisPath + ".edges must be a list of bin edges");
+            else
+                axis.Edges = edges.as<std::vector<double>>();
+        }
+        else if (!bins || !bins.IsSequence() || bins.size() != 3)
+            errors.push_back(axisPath + ".bins must contain [nbins, xmin, xmax]");
+        else
+        {
+            const double count = bins[0].as<double>();
+            // Non-integer counts are rejected by the range check below.
+            axis.Bins = std::isfinite(count) && std::floor(count) == count && std::abs(count) < 1e9 ? static_cast<int>(count) : 0;
+            axis.Min = bins[1].as<double>();
+            axis.Max = bins[2].as<double>();
+        }
+    }
+    catch (const YAML::Exception &)
+    {
+        errors.push_back(axisPath + (edges ? ".edges" : ".bins") + " must contain numbers");
+    }
+}
+
+void EmitBinning(YAML::Emitter &out, const HistogramAxis &axis)
+{
+    if (!axis.Edges.empty())
+    {
+        out << YAML::Key << "edges" << YAML::Value << YAML::Flow << axis.Edges;
+        return;
+    }
+    out << YAML::Key << "bins" << YAML::Value << YAML::Flow << YAML::BeginSeq << axis.Bins << axis.Min << axis.Max << YAML::EndSeq;
+}
+
+std::string DescribeBinning(const HistogramAxis &axis)
+{
+    std::ostringstream text;
+    if (axis.Edges.empty())
+    {
+        text << "[" << axis.Bins << "," << axis.Min << "," << axis.Max << "]";
+        return text.str();
+    }
+    text << "{";
+    for (std::size_t edge = 0; edge < axis.Edges.size(); ++edge)
+        text << (edge ? "," : "") << axis.Edges[edge];
+    text << "}";
+    return text.str();
+}
+} // namespace
+
+std::vector<double> HistogramAxis::BinEdges() const
+{
+    if (!Edges.empty()) return Edges;
+    std::vector<double> edges(static_cast<std::size_t>(Bins) + 1);
+    for (int bin = 0; bin <= Bins; ++bin)
+        edges[static_cast<std::size_t>(bin)] = Min + (Max - Min) * bin / Bins;
+    return edges;
+}
+
+HistogramSpec HistogramSpec::FromBins(const std::string &expression, const std::vector<double> &binfo)
+{
+    HistogramAxis axis;
+    axis.Expression = expression;
+    if (binfo.size() == 3)
+    {
+        axis.Bins = static_cast<int>(binfo[0]);
+        axis.Min = binfo[1];
+        axis.Max = binfo[2];
+    }
+    HistogramSpec spec;
+    spec.Axes.push_back(std::move(axis));
+    return spec;
+}
+
+std::optional<HistogramSpec> HistogramSpec::FromYaml(const YAML::Node &entry, const std::string &name, std::vector<std::string> &errors)
+{
+    const std::string path = "histograms." + name;
+    if (!entry || !entry.IsMap())
+    {
+        errors.push_back("histogram entries must be named maps");
+        return std::nullopt;
+    }
+    const std::size_t firstError = errors.size();
+    HistogramSpec spec;
+    if (const YAML::Node type = entry["type"])
+    {
+        const auto kind = std::find_if(HISTOGRAM_KINDS.begin(), HISTOGRAM_KINDS.end(), [&type](const auto &known)
+                                       { return type.IsScalar() && type.Scalar() == known.first; });
+        if (kind == HISTOGRAM_KINDS.end())
+        {
+            errors.push_back(path + ".type must be one of TH1D, TH2D, TH3D, or TProfile");
+            return std::nullopt;
+        }
+        spec.Kind = kind->second;
+    }
+    spec.Axes.resize(AxisCount(spec.Kind));
+    ParseAxis(entry, path, true, spec.Axes[0], errors);
+    for (std::size_t index = 1; index < 3; ++index)
+    {
+        const YAML::Node node = entry[AXIS_KEYS[index]];
+        if (index >= spec.Axes.size())
+        {
+            if (node) errors.push_back(AxisPath(path, index) + " is not an axis of " + KindName(spec.Kind));
+            continue;
+        }
+        if (!node || !node.IsMap())
+            errors.push_back(AxisPath(path, index) + " must be a map with expr" + (IsBinned(spec.Kind, index) ? " and bins or edges" : ""));
+        else
+            ParseAxis(node, AxisPath(path, index), IsBinned(spec.Kind, index), spec.Axes[index], errors);
+    }
+    if (errors.size() == firstError) CheckSpec(spec, path, name, errors);
+    if (errors.size() != firstError) return std::nullopt;
+    return spec;
+}
+
+void HistogramSpec::Validate(const std::string &name) const
+{
+    std::vector<std::string> errors;
+    CheckSpec(*this, "histogram " + name, name, errors);
+    if (errors.empty()) return;
+    const std::string &error = errors.front();
+    throw std::invalid_argument(error.rfind("AnalysisManager: ", 0) == 0 ? error : "AnalysisManager: " + error);
+}
+
+std::unique_ptr<TH1> HistogramSpec::Create(const std::string &name, const std::string &title) const
+{
+    const HistogramAxis &x = Axes.at(0);
+    std::unique_ptr<TH1> histogram;
+    switch (Kind)
+    {
+    case HistogramKind::TH1D:
+        histogram = x.Edges.empty() ? std::make_unique<TH1D>(name.c_str(), title.c_str(), x.Bins, x.Min, x.Max)
+                                    : std::make_unique<TH1D>(name.c_str(), title.c_str(), x.BinCount(), x.Edges.data());
+        break;
+    case HistogramKind::TProfile:
+        histogram = x.Edges.empty() ? std::make_unique<TProfile>(name.c_str(), title.c_str(), x.Bins, x.Min, x.Max)
+                                    : std::make_unique<TProfile>(name.c_str(), title.c_str(), x.BinCount(), x.Edges.data());
+        break;
+    case HistogramKind::TH2D:
+    {
+        const HistogramAxis &y = Axes.at(1);
+        if (x.Edges.empty() && y.Edges.empty())
+        {
+            histogram = std::make_unique<TH2D>(name.c_str(), title.c_str(), x.Bins, x.Min, x.Max, y.Bins, y.Min, y.Max);
+            break;
+        }
+        const auto xEdges = x.BinEdges();
+        const auto yEdges = y.BinEdges();
+        histogram = std::make_unique<TH2D>(name.c_str(), title.c_str(), x.BinCount(), xEdges.data(), y.BinCount(), yEdges.data());
+        break;
+    }
+    case HistogramKind::TH3D:
+    {
+        const HistogramAxis &y = Axes.at(1);
+        const HistogramAxis &z = Axes.at(2);
+        if (x.Edges.empty() && y.Edges.empty() && z.Edges.empty())
+        {
+            histogram = std::make_unique<TH3D>(name.c_str(), title.c_str(), x.Bins, x.Min, x.Max, y.Bins, y.Min, y.Max, z.Bins, z.Min, z.Max);
+            break;
+        }
+        // TH3D has no mixed uniform/variable constructor, so every axis is given as edges.
+        const auto xEdges = x.BinEdges();
+        const auto yEdges = y.BinEdges();
+        const auto zEdges = z.BinEdges();
+        histogram = std::make_unique<TH3D>(name.c_str(), title.c_str(), x.BinCount(), xEdges.data(), y.BinCount(), yEdges.data(),
+                                           z.BinCount(), zEdges.data());
+        break;
+    }
+    }
+    histogram->SetDirectory(nullptr);
+    return histogram;
+}
+
+std::string HistogramSpec::Title() const
+{
+    // One-dimensional histograms keep the expression as their title; the others label each axis instead.
+    if (Kind == HistogramKind::TH1D) return Axes.at(0).Expression;
+    std::string title;
+    for (const auto &axis : Axes)
+        title += ";" + axis.Expression;
+    return title;
+}
+
+std::string HistogramSpec::Describe() const
+{
+    if (Kind == HistogramKind::TH1D) return DescribeBinning(Axes.at(0));
+    std::string text = KindName(Kind) + " " + DescribeBinning(Axes.at(0));
+    if (Kind == HistogramKind::TProfile) return text + " of " + Axes.at(1).Expression;
+    for (std::size_t index = 1; index < Axes.size(); ++index)
+        text += " x " + DescribeBinning(Axes[index]);
+    return text;
+}
+
+void HistogramSpec::EmitYaml(YAML::Emitter &out) const
+{
+    if (Kind != HistogramKind::TH1D) out << YAML::Key << "type" << YAML::Value << KindName(Kind);
+    out << YAML::Key << "expr" << YAML::Value << Axes.at(0).Expression;
+    EmitBinning(out, Axes.at(0));
+    for (std::size_t index = 1; index < Axes.size(); ++index)
+    {
+        out << YAML::Key << AXIS_KEYS[index] << YAML::Value << YAML::BeginMap;
+        out << YAML::Key << "expr" << YAML::Value << Axes[index].Expression;
+        if (IsBinned(Kind, index)) EmitBinning(out, Axes[index]);
+        out << YAML::EndMap;
+    }
+}
+
+bool HistogramSpec::operator==(const HistogramSpec &other) const
+{
+    const auto sameAxis = [](const HistogramAxis &lhs, const HistogramAxis &rhs)
+    { return lhs.Expression == rhs.Expression && lhs.Bins == rhs.Bins && lhs.Min == rhs.Min && lhs.Max == rhs.Max && lhs.Edges == rhs.Edges; };
+    return Kind == other.Kind && Variation == other.Variation &&
+           std::equal(Axes.begin(), Axes.end(), other.Axes.begin(), other.Axes.end(), sameAxis);
+}
@@ -0,0 +1,226 @@
+#include "AnalysisManager.hh"
+#include <TBranch.h>
+#include <TLeaf.h>
+#include <TTreeCache.h>
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+
+using namespace logger;
+
+namespace
+{
+constexpr Long64_t MIN_CACHE_BYTES = 1 << 20;
+
+// Identifier-like tokens of a tree expression, including dotted member paths. Quoted text and numbers are skipped.
+std::vector<std::string> ExpressionNames(const std::string &expr)
+{
+    std::vector<std::string> names;
+    const auto isNameChar = [](char c) { return std::isalnum(static_cast<unsigned char>(c)) || c == '_' || c == '.'; };
+    std::size_t pos = 0;
+    while (pos < expr.size())
+    {
+        const char c = expr[pos];
+        if (c == '"' || c == '\'')
+        {
+            const std::size_t close = expr.find(c, pos + 1);
+            pos = close == std::string::npos ? expr.size() : close + 1;
+        }
+        else if (std::isalpha(static_cast<unsigned char>(c)) || c == '_')
+        {
+            const std::size_t start = pos;
+            while (pos < expr.size() && isNameChar(expr[pos]))
+                ++pos;
+            names.push_back(expr.substr(start, pos - start));
+        }
+        else if (std::isdigit(static_cast<unsigned char>(c)))
+        {
+            while (pos < expr.size() && isNameChar(expr[pos]))
+                ++pos;
+        }
+        else
+            ++pos;
+    }
+    return names;
+}
+
+// The branch storing name, trying shorter member paths of dotted names.
+TBranch *FindInputBranch(TTree &tree, std::string name)
+{
+    while (!name.empty())
+    {
+        if (TBranch *branch = tree.GetBranch(name.c_str())) return branch;
+        if (TLeaf *leaf = tree.GetLeaf(name.c_str())) return leaf->GetBranch();
+        const std::size_t dot = name.rfind('.');
+        if (dot == std::string::npos) break;
+        name.resize(dot);
+    }
+    return nullptr;
+}
+} // namespace
+
+void AnalysisManager::OptimizeInputReads(Long64_t cacheBytes, bool asyncPrefetch, const std::vector<std::string> &keepBranches)
+{
+    if (!m_CurrentTree || m_UseRdf) throw std::runtime_error("AnalysisManager: input read optimization requires an initialized non-RDF tree.");
+    if (cacheBytes < 0) throw std::invalid_argument("AnalysisManager: TTreeCache size must not be negative.");
+    m_InputReadPlan = InputReadPlan{cacheBytes, asyncPrefetch, keepBranches};
+    m_ActiveBranches.clear();
+    ApplyInputReadPlan_();
+}
+
+void AnalysisManager::ApplyInputReadPlan_()
+{
+    if (!m_InputReadPlan || !m_CurrentTree) return;
+    // Branches are looked up in the tree holding the loaded entry, so a plan applied mid-loop keeps the loop's position.
+    const Long64_t loaded = m_CurrentTree->GetReadEntry();
+    if (m_CurrentTree->LoadTree(std::max<Long64_t>(loaded, 0)) < 0) return;
+    TTree *tree = m_CurrentTree->GetTree();
+
+    std::vector<std::string> expressions = m_InputReadPlan->KeepBranches;
+    for (const auto &[_, info] : m_BranchMap)
+        expressions.push_back(info.RealName);
+    for (const auto &[_, expr] : m_RawCutExpr)
+        expressions.push_back(ExpandAliases_(expr));
+    // Replacement branches read by varied cuts; varied histogram expressions are covered by their specs below.
+    for (const auto &[_, variation] : m_Variations)
+    {
+        for (const auto &[_, expr] : variation.Columns)
+            expressions.push_back(ExpandAliases_(expr));
+        expressions.push_back(ExpandAliases_(variation.Weight));
+    }
+    for (const auto &[_, inmap] : m_HistSpecs)
+        for (const auto &[_, spec] : inmap)
+            for (const auto &axis : spec.Axes)
+                expressions.push_back(ExpandAliases_(axis.Expression));
+    std::set<std::string> active;
+    for (const auto &expr : expressions)
+        for (const auto &name : ExpressionNames(expr))
+            if (TBranch *branch = FindInputBranch(*tree, name)) active.insert(branch->GetName());
+    for (const auto &name : m_InputReadPlan->KeepBranches)
+        if (!FindInputBranch(*tree, name)) throw std::runtime_error("AnalysisManager: kept branch is not in the input tree: " + name);
+    if (active == m_ActiveBranches) return;
+
+    // The chain keeps branch statuses and the cache branch list across file switches.
+    m_CurrentTree->SetBranchStatus("*", false);
+    for (const auto &name : active)
+        m_CurrentTree->SetBranchStatus(name.c_str(), true);
+
+    Long64_t cacheBytes = m_InputReadPlan->CacheBytes;
+    if (cacheBytes == 0)
+    {
+        double zipBytes = 0.0;
+        for (const auto &name : active)
+            zipBytes += static_cast<double>(tree->GetBranch(name.c_str())->GetZipBytes());
+        auto cluster = tree->GetClusterIterator(0);
+        cluster();
+        const double entries = static_cast<double>(std::max<Long64_t>(1, tree->GetEntries()));
+        const double clusterEntries = static_cast<double>(std::max<Long64_t>(1, cluster.GetNextEntry()));
+        // One cluster of the active branches with a quarter of headroom for uneven baskets.
+        cacheBytes = std::max(MIN_CACHE_BYTES, static_cast<Long64_t>(1.25 * zipBytes * std::min(1.0, clusterEntries / entries)));
+    }
+    // Reads of the open file are booked before its cache changes; entering it again enables prefetching on the new cache.
+    LeaveInputFile_();
+    m_CurrentTree->SetCacheSize(cacheBytes);
+    for (const auto &name : active)
+        m_CurrentTree->AddBranchToCache(name.c_str(), true);
+    // The branch set is known, so the cache skips its learning phase.
+    m_CurrentTree->StopCacheLearningPhase();
+    EnterInputFile_();
+
+    const bool grew = !std::includes(m_ActiveBranches.begin(), m_ActiveBranches.end(), active.begin(), active.end());
+    m_ActiveBranches = std::move(active);
+    m_TotalBranches = tree->GetListOfBranches() ? static_cast<std::size_t>(tree->GetListOfBranches()->GetEntriesFast()) : 0;
+    LOG_INFO("AnalysisManager", "Input reads limited to " << m_ActiveBranches.size() << " of " << m_TotalBranches << " branches with a "
+                                                         << cacheBytes / 1024 << " KiB TTreeCache"
+                                                         << (m_InputReadPlan->AsyncPrefetch ? " and asynchronous prefetching." : "."));
+    // A branch activated mid-loop has not been read for the loaded entry yet.
+    if (grew && loaded >= 0) m_CurrentTree->GetEntry(loaded);
+}
+
+AnalysisManager::InputFileReads AnalysisManager::CurrentFileReads_() const
+{
+    InputFileReads reads;
+    TFile *file = m_CurrentTree ? m_CurrentTree->GetCurrentFile() : nullptr;
+    if (!file) return reads;
+    reads.Bytes = file->GetBytesRead();
+    if (TTreeCache *cache = m_CurrentTree->GetReadCache(file))
+    {
+        reads.CacheBytes = cache->GetBytesRead();
+        reads.UncachedBytes = cache->GetNoCacheBytesRead();
+    }
+    return reads;
+}
+
+void AnalysisManager::EnterInputFile_()
+{
+    TFile *file = m_CurrentTree ? m_CurrentTree->GetCurrentFile() : nullptr;
+    TTree *tree = m_CurrentTree ? m_CurrentTree->GetTree() : nullptr;
+    if (!file || !tree)
+    {
+        m_InputFileEnd = -1;
+        return;
+    }
+    m_InputFileFirst = m_CurrentTree->GetTreeOffset()[m_CurrentTree->GetTreeNumber()];
+    m_InputFileEnd = m_InputFileFirst + tree->GetEntries();
+    // Prefetching is enabled on this chain's cache only, since TFile.AsyncPrefetching would apply to every file the process opens.
+    // Like that setting, it leaves local files alone.
+    TTreeCache *cache = m_CurrentTree->GetReadCache(file);
+    if (cache && m_InputReadPlan && m_InputReadPlan->AsyncPrefetch && !cache->IsEnablePrefetching() &&
+        std::strcmp(file->GetEndpointUrl()->GetProtocol(), "file") != 0)
+        cache->SetEnablePrefetching(true);
+    m_InputReadsAtEntry = CurrentFileReads_();
+}
+
+void AnalysisManager::LeaveInputFile_()
+{
+    if (m_InputFileEnd < 0) return;
+    const InputFileReads reads = CurrentFileReads_();
+    m_InputReadsDone.Bytes += reads.Bytes - m_InputReadsAtEntry.Bytes;
+    m_InputReadsDone.CacheBytes += reads.CacheBytes - m_InputReadsAtEntry.CacheBytes;
+    m_InputReadsDone.UncachedBytes += reads.UncachedBytes - m_InputReadsAtEntry.UncachedBytes;
+    m_InputFileEnd = -1;
+}
+
+void AnalysisManager::ReadInputEntry_(Long64_t entry)
+{
+    // The chain closes a file, and with it possibly its cache, when the entry lies in another one, so its counters are read first.
+    const bool switching = entry < m_InputFileFirst || entry >= m_InputFileEnd;
+    if (switching) LeaveInputFile_();
+    m_CurrentTree->GetEntry(entry);
+    if (switching) EnterInputFile_();
+}
+
+void AnalysisManager::StartInputReadStatistics_()
+{
+    m_InputReadsDone = {};
+    if (m_InputFileEnd >= 0) EnterInputFile_();
+}
+
+InputReadStatistics AnalysisManager::GetInputReadStatistics() const
+{
+    InputReadStatistics statistics;
+    statistics.ActiveBranches = m_ActiveBranches.size();
+    statistics.TotalBranches = m_TotalBranches;
+    InputFileReads reads = m_InputReadsDone;
+    if (m_InputFileEnd >= 0)
+    {
+        const InputFileReads current = CurrentFileReads_();
+        reads.Bytes += current.Bytes - m_InputReadsAtEntry.Bytes;
+        reads.CacheBytes += current.CacheBytes - m_InputReadsAtEntry.CacheBytes;
+        reads.UncachedBytes += current.UncachedBytes - m_InputReadsAtEntry.UncachedBytes;
+    }
+    statistics.BytesRead = reads.Bytes;
+    statistics.CacheBytesRead = reads.CacheBytes;
+    statistics.UncachedBytesRead = reads.UncachedBytes;
+    if (m_CurrentTree) statistics.CacheSize = m_CurrentTree->GetCacheSize();
+    return statistics;
+}
+
+void AnalysisManager::ReportInputReads_() const
+{
+    if (!m_InputReadPlan) return;
+    const InputReadStatistics statistics = GetInputReadStatistics();
+    LOG_INFO("AnalysisManager", "Input reads: " << statistics.BytesRead / 1024 << " KiB read, cache hit ratio "
+                                                << 100.0 * statistics.CacheHitRatio() << "% with " << statistics.ActiveBranches << " of "
+                                                << statistics.TotalBranches << " branches active.");
+}
@@ -0,0 +1,138 @@
+#include "AnalysisManager.hh"
+#include <Compression.h>
+#include <TBranch.h>
+#include <TObjArray.h>
+
+using namespace logger;
+
+namespace
+{
+using Algorithm = ROOT::RCompressionSetting::EAlgorithm::EValues;
+
+struct CompressionAlgorithm
+{
+    const char *Name;
+    Algorithm Value;
+    int DefaultLevel;
+};
+
+constexpr CompressionAlgorithm ALGORITHMS[] = {
+    {"zlib", ROOT::RCompressionSetting::EAlgorithm::kZLIB, ROOT::RCompressionSetting::ELevel::kDefaultZLIB},
+    {"lzma", ROOT::RCompressionSetting::EAlgorithm::kLZMA, ROOT::RCompressionSetting::ELevel::kDefaultLZMA},
+    {"lz4", ROOT::RCompressionSetting::EAlgorithm::kLZ4, ROOT::RCompressionSetting::ELevel::kDefaultLZ4},
+    {"zstd", ROOT::RCompressionSetting::EAlgorithm::kZSTD, ROOT::RCompressionSetting::ELevel::kDefaultZSTD},
+};
+
+const CompressionAlgorithm *FindAlgorithm(const std::string &name)
+{
+    for (const auto &algorithm : ALGORITHMS)
+        if (name == algorithm.Name) return &algorithm;
+    return nullptr;
+}
+
+// Level 0 stores baskets uncompressed; ROOT accepts 1 through 9 for every algorithm.
+constexpr int MAX_COMPRESSION_LEVEL = 9;
+
+void ValidateOutputSettings(const OutputSettings &settings, std::vector<std::string> &errors)
+{
+    if (!settings.Algorithm.empty() && !FindAlgorithm(settings.Algorithm))
+        errors.push_back("output.compression must be zlib, lzma, lz4, or zstd: " + settings.Algorithm);
+    if (settings.Level && (*settings.Level < 0 || *settings.Level > MAX_COMPRESSION_LEVEL))
+        errors.push_back("output.compression_level must be between 0 and 9");
+    if (settings.BasketSize && *settings.BasketSize <= 0) errors.push_back("output.basket_size must be a positive number of bytes");
+    // RDF snapshots store the auto-flush value as an int.
+    if (settings.AutoFlush && (*settings.AutoFlush < std::numeric_limits<int>::min() || *settings.AutoFlush > std::numeric_limits<int>::max()))
+        errors.push_back("output.auto_flush must fit in a 32-bit integer");
+}
+} // namespace
+
+std::optional<OutputSettings> OutputSettings::FromYaml(const YAML::Node &node, std::vector<std::string> &errors)
+{
+    if (!node || !node.IsMap())
+    {
+        errors.push_back("output must be a map");
+        return std::nullopt;
+    }
+    const std::size_t firstError = errors.size();
+    OutputSettings settings;
+    for (const auto &field : node)
+    {
+        const std::string key = field.first.as<std::string>();
+        try
+        {
+            if (key == "compression")
+                settings.Algorithm = field.second.as<std::string>();
+            else if (key == "compression_level")
+                settings.Level = field.second.as<int>();
+            else if (key == "auto_flush")
+                settings.AutoFlush = field.second.as<Long64_t>();
+            else if (key == "basket_size")
+                settings.BasketSize = field.second.as<int>();
+            else
+                errors.push_back("output." + key + " is not an output field");
+        }
+        catch (const YAML::Exception &)
+        {
+            errors.push_back("output." + key + (key == "compression" ? " must be a string" : " must be an integer"));
+        }
+    }
+    ValidateOutputSettings(settings, errors);
+    if (errors.size() != firstError) return std::nullopt;
+    return settings;
+}
+
+std::optional<int> OutputSettings::CompressionSettings() const
+{
+    if (Algorithm.empty() && !Level) return std::nullopt;
+    const CompressionAlgorithm *algorithm = Algorithm.empty() ? nullptr : FindAlgorithm(Algorithm);
+    if (!Algorithm.empty() && !algorithm) throw std::invalid_argument("AnalysisManager: unknown compression algorithm: " + Algorithm);
+    if (!algorithm) return ROOT::CompressionSettings(ROOT::RCompressionSetting::EAlgorithm::kUseGlobal, *Level);
+    return ROOT::CompressionSettings(algorithm->Value, Level.value_or(algorithm->DefaultLevel));
+}
+
+void OutputSettings::Apply(ROOT::RDF::RSnapshotOptions &options) const
+{
+    if (!Algorithm.empty())
+    {
+        const CompressionAlgorithm *algorithm = FindAlgorithm(Algorithm);
+        if (!algorithm) throw std::invalid_argument("AnalysisManager: unknown compression algorithm: " + Algorithm);
+        options.fCompressionAlgorithm = algorithm->Value;
+        options.fCompressionLevel = Level.value_or(algorithm->DefaultLevel);
+    }
+    else if (Level)
+        options.fCompressionLevel = *Level;
+    // RSnapshotOptions stores the auto-flush value as an int; validation keeps it in range.
+    if (AutoFlush) options.fAutoFlush = static_cast<int>(*AutoFlush);
+    if (BasketSize) options.fBasketSize = *BasketSize;
+}
+
+void AnalysisManager::SetOutputSettings(const OutputSettings &settings)
+{
+    std::vector<std::string> errors;
+    ValidateOutputSettings(settings, errors);
+    if (!errors.empty()) throw std::invalid_argument("AnalysisManager: invalid output settings: " + errors.front());
+    m_OutputSettings = settings;
+    for (const auto &[name, tree] : m_TreeMap)
+        if (settings.AutoFlush && m_TreeOwnership.at(name) == ResourceOwnership::Owned) tree->SetAutoFlush(*settings.AutoFlush);
+}
+
+void AnalysisManager::WriteTrees(const std::string &outfile, const std::optional<OutputSettings> &settings)
+{
+    const OutputSettings &output = settings ? *settings : m_OutputSettings;
+    const std::optional<int> compression = output.CompressionSettings();
+    TFile file(outfile.c_str(), "recreate");
+    if (file.IsZombie()) throw std::runtime_error("AnalysisManager: cannot create tree output file: " + outfile);
+    if (compression) file.SetCompressionSettings(*compression);
+    file.cd();
+    for (const auto &[_, tree] : m_TreeMap)
+    {
+        // Baskets of a tree without a directory are compressed when written, with the setting of their branch.
+        TObjArray *branches = compression ? tree->GetListOfBranches() : nullptr;
+        for (int i = 0; branches && i < branches->GetEntries(); ++i)
+            static_cast<TBranch *>(branches->At(i))->SetCompressionSettings(*compression);
+        if (tree->Write(tree->GetName(), TObject::kOverwrite) < 0)
+            throw std::runtime_error("AnalysisManager: failed to write tree: " + std::string(tree->GetName()));
+    }
+    file.Close();
+    LOG_INFO("AnalysisManager", "Trees are saved in " << outfile);
+}
@@ -1,29 +1,111 @@
 #include "AnalysisManager.hh"
 #include "AnalysisManagerDetail.inc"
+#include "ExecutionResources.hh"
 #include "LambdaManager.hh"
 #include <ROOT/RDFHelpers.hxx>
+#include <RVersion.h>
 #include <TFile.h>
+#include <TKey.h>
+#include <TH2D.h>
+#include <TH3D.h>
 #include <TObject.h>
+#include <TProfile.h>
 #include <algorithm>
 #include <atomic>
 
+#if ROOT_VERSION_CODE >= ROOT_VERSION(6, 36, 0)
+#include <ROOT/RNTupleReader.hxx>
+#define CASCADE_HAS_RNTUPLE 1
+#endif
+
 using namespace logger;
+using cascade::analysis_detail::IsWord;
+using cascade::analysis_detail::LambdaTarget;
+using cascade::analysis_detail::RNTUPLE_CLASS;
 using cascade::analysis_detail::SafeColumnName;
 using cascade::analysis_detail::ValidateHistogramBins;
+using cascade::analysis_detail::VARIATION_WEIGHT_COLUMN;
+using cascade::analysis_detail::VariedPrefix;
+
+namespace
+{
+using VariedResults = std::function<std::vector<std::pair<std::string, TH1 *>>()>;
+
+// The varied copies of a booked result, keyed "<variation>:0", read after the event loop.
+template <typename T> VariedResults TrackVariations(const ROOT::RDF::RResultPtr<T> &result)
+{
+    auto variations = std::make_shared<ROOT::RDF::Experimental::RResultMap<T>>(ROOT::RDF::Experimental::VariationsFor(result));
+    return [variations]()
+    {
+        std::vector<std::pair<std::string, TH1 *>> histograms;
+        for (const auto &key : variations->GetKeys())
+            if (key != "nominal") histograms.emplace_back(key, &(*variations)[key]);
+        return histograms;
+    };
+}
+
+// Writes booked histograms and their varied copies into the current directory.
+void WriteRdfResults(std::map<std::string, std::map<std::string, ROOT::RDF::RResultPtr<TH1>>> &histograms,
+                     std::map<std::string, std::map<std::string, VariedResults>> &variations)
+{
+    for (auto &[_, inmap] : histograms)
+    {
+        for (auto &[_, hist] : inmap)
+            if (hist->Write(hist->GetName(), TObject::kOverwrite) < 0)
+                throw std::runtime_error("AnalysisManager: failed to write RDF histogram: " + std::string(hist->GetName()));
+    }
+    for (auto &[alias, inmap] : variations)
+        for (auto &[prefix, varied] : inmap)
+            for (auto &[key, hist] : varied())
+            {
+                const std::string name = "hist_" + alias + "_" + VariedPrefix(prefix, key.substr(0, key.find(':')));
+                hist->SetName(name.c_str());
+                if (hist->Write(name.c_str(), TObject::kOverwrite) < 0)
+                    throw std::runtime_error("AnalysisManager: failed to write varied RDF histogram: " + name);
+            }
+}
+bool HoldsRNTuple(const std::string &path, const std::string &name)
+{
+    std::unique_ptr<TFile> file(TFile::Open(path.c_str(), "READ"));
+    const TKey *key = file && !file->IsZombie() ? file->GetKey(name.c_str()) : nullptr;
+    return key && std::string(key->GetClassName()) == RNTUPLE_CLASS;
+}
+} // namespace
+
+void AnalysisManager::EnableMT(unsigned int nThreads)
+{
+    // The pool is process-wide and Parallel-lane nodes run beside tasks that may be using it, so only the lanes that run
+    // one node at a time may resize it.
+    if (CascadeParallelNode())
+        throw std::runtime_error("AnalysisManager: EnableMT resizes ROOT's process-wide thread pool and must run in the Root or Serial DAG lane.");
+    const unsigned int threads = nThreads == 0 ? CascadeThreadBudget() : nThreads;
+    std::lock_guard<std::recursive_mutex> lock(CascadeRootExecutionMutex());
+    if (ROOT::IsImplicitMTEnabled() && ROOT::GetThreadPoolSize() == threads) return;
+    if (ROOT::IsImplicitMTEnabled()) ROOT::DisableImplicitMT();
+    ROOT::EnableImplicitMT(threads);
+    LOG_INFO("AnalysisManager", "ROOT implicit multi-threading uses " << threads << " threads.");
+}
 
 void AnalysisManager::InitRdfFromConfig(const std::string &yamlPath)
 {
     LoadInputConfig(yamlPath);
     if (m_InputFiles.empty() || m_InTreeName.empty()) throw std::runtime_error("AnalysisManager: RDF input config is incomplete.");
-    if (!BuildChain()) throw std::runtime_error("AnalysisManager: RDF input files did not provide the requested tree.");
+    if (m_InputFormat == DataFormat::RNTuple)
+        InitRdfFromRNTuple_();
+    else
+    {
+        if (!BuildChain()) throw std::runtime_error("AnalysisManager: RDF input files did not provide the requested tree.");
+        m_RdfRaw = std::make_unique<ROOT::RDataFrame>(*m_CurrentTree);
+    }
 
     m_UseRdf = true;
-    m_RdfRaw = std::make_unique<ROOT::RDataFrame>(*m_CurrentTree);
     m_RdfNode = *m_RdfRaw;
     for (const auto &[alias, info] : m_BranchMap)
     {
-        if (alias != info.RealName) m_RdfNode = m_RdfNode->Define(alias, info.RealName);
+        if (alias != info.RealName) m_RdfNode = ApplyRdfExpression_(*m_RdfNode, m_RdfColumns, false, alias, info.RealName);
     }
+    for (const auto &[_, variation] : m_Variations)
+        ApplyRdfVariation_(variation);
     m_LambdaManager = std::make_unique<LambdaManager>();
     LOG_INFO("AnalysisManager", "RDF input initialized from config " << yamlPath << " with " << m_InputFiles.size()
                                   << " files for tree " << m_InTreeName);
@@ -33,26 +115,56 @@ void AnalysisManager::InitRdfFromFile(const std::string &treename, const std::st
 {
     ReleaseCurrentTree_();
     m_BranchMap.clear();
+    BuildAliasTable_();
     m_InputFiles = {filename};
     m_InTreeName = treename;
-    m_CurrentTreeOwner = std::make_shared<TChain>(treename.c_str());
-    m_CurrentTree = m_CurrentTreeOwner.get();
-    if (m_CurrentTree->Add(filename.c_str()) < 1)
+    m_InputFormat = HoldsRNTuple(filename, treename) ? DataFormat::RNTuple : DataFormat::TTree;
+    if (m_InputFormat == DataFormat::RNTuple)
+        InitRdfFromRNTuple_();
+    else
     {
-        ReleaseCurrentTree_();
-        throw std::runtime_error("AnalysisManager: failed to add RDF input file: " + filename);
+        m_CurrentTreeOwner = std::make_shared<TChain>(treename.c_str());
+        m_CurrentTree = m_CurrentTreeOwner.get();
+        if (m_CurrentTree->Add(filename.c_str()) < 1)
+        {
+            ReleaseCurrentTree_();
+            throw std::runtime_error("AnalysisManager: failed to add RDF input file: " + filename);
+        }
+        m_RdfRaw = std::make_unique<ROOT::RDataFrame>(*m_CurrentTree);
     }
     m_UseRdf = true;
-    m_RdfRaw = std::make_unique<ROOT::RDataFrame>(*m_CurrentTree);
     m_RdfNode = *m_RdfRaw;
+    for (const auto &[_, variation] : m_Variations)
+        ApplyRdfVariation_(variation);
     m_LambdaManager = std::make_unique<LambdaManager>();
     LOG_INFO("AnalysisManager", "RDF input initialized from file " << filename << " for tree " << treename);
 }
 
+void AnalysisManager::InitRdfFromRNTuple_()
+{
+#ifdef CASCADE_HAS_RNTUPLE
+    // RDataFrame picks the RNTuple data source for an ntuple name; the readers only supply the entry count up front.
+    m_RdfRaw = std::make_unique<ROOT::RDataFrame>(m_InTreeName, m_InputFiles);
+    m_EntryCount = 0;
+    for (const auto &file : m_InputFiles)
+        m_EntryCount += static_cast<Long64_t>(ROOT::RNTupleReader::Open(m_InTreeName, file)->GetNEntries());
+#else
+    throw std::runtime_error("AnalysisManager: RNTuple input requires ROOT 6.36 or newer: " + m_InTreeName);
+#endif
+}
+
 void AnalysisManager::DefineRdfVariable(const std::string &name, const std::string &expr)
 {
     if (!m_UseRdf) throw std::runtime_error("RDF not initialized");
-    m_RdfNode = m_RdfNode->Define(name, expr);
+    if (const auto target = LambdaTarget(expr))
+    {
+        const RdfLambda *lambda = FindRdfLambda_(*target, RdfLambda::Kind::Define);
+        if (!lambda) throw std::runtime_error("AnalysisManager: RDF define is not registered: " + *target);
+        m_RdfNode = lambda->Apply(*m_RdfNode, name);
+        if (m_RdfColumns.Columns) m_RdfColumns.Columns->insert(name);
+    }
+    else
+        m_RdfNode = ApplyRdfExpression_(*m_RdfNode, m_RdfColumns, false, name, expr);
     LOG_INFO("AnalysisManager", "Defined RDF variable '" << name << "' with expression '" << expr << "'");
 }
 
@@ -62,19 +174,70 @@ void AnalysisManager::ApplyRdfFilter(const std::string &name)
     if (m_AppliedRdfCuts.count(name)) return;
 
     auto it = m_RawCutExpr.find(name);
-    if (it != m_RawCutExpr.end())
+    if (it == m_RawCutExpr.end()) throw std::runtime_error("AnalysisManager: RDF cut is not registered: " + name);
+    m_RdfNode = FilterRdfNode_(*m_RdfNode, m_RdfColumns, name);
+    LOG_INFO("AnalysisManager", "Cut " << name << " : " << it->second << " is applied.");
+    m_AppliedRdfCuts.insert(name);
+    BookRdfCutflowStage_(name);
+}
+
+ROOT::RDF::RNode AnalysisManager::FilterRdfNode_(ROOT::RDF::RNode node, RdfColumnRegistry &registry, const std::string &name)
+{
+    const auto it = m_RawCutExpr.find(name);
+    if (it == m_RawCutExpr.end()) throw std::runtime_error("AnalysisManager: RDF cut is not registered: " + name);
+    if (const auto target = LambdaTarget(it->second))
     {
-        if (it->second.find("--lambda:") == std::string::npos)
-        {
-            LOG_INFO("AnalysisManager", "Cut " << name << " : " << it->second << " is applied.");
-            m_RdfNode = m_RdfNode->Filter(ExpandAliases_(it->second), name);
-            m_AppliedRdfCuts.insert(name);
-        }
-        else
-            throw std::runtime_error("AnalysisManager: lambda cut has no callable implementation: " + name);
+        const RdfLambda *lambda = FindRdfLambda_(*target, RdfLambda::Kind::Filter);
+        if (!lambda) throw std::runtime_error("AnalysisManager: lambda cut has no callable implementation: " + name);
+        return lambda->Apply(node, name);
+    }
+    return ApplyRdfExpression_(node, registry, true, name, ExpandAliases_(it->second, m_RdfVariedAliases));
+}
+
+const RdfLambda *AnalysisManager::FindRdfLambda_(const std::string &name, RdfLambda::Kind kind) const
+{
+    if (m_LambdaManager)
+        if (const RdfLambda *lambda = m_LambdaManager->FindRdfLambda(name, kind)) return lambda;
+    return LambdaManager::Library().FindRdfLambda(name, kind);
+}
+
+void AnalysisManager::DefineRegions(const std::map<std::string, std::vector<std::string>> &regions)
+{
+    if (!m_UseRdf) throw std::runtime_error("RDF not initialized");
+    for (const auto &[name, cuts] : regions)
+    {
+        // Region names become output directories.
+        if (!IsWord(name)) throw std::invalid_argument("AnalysisManager: region names must be letters, digits, and underscores: " + name);
+        if (m_RdfRegions.count(name)) throw std::runtime_error("AnalysisManager: region already defined: " + name);
+        for (const auto &cut : cuts)
+            if (!m_RawCutExpr.count(cut)) throw std::runtime_error("AnalysisManager: RDF cut is not registered: " + cut);
+    }
+    for (const auto &[name, cuts] : regions)
+    {
+        ROOT::RDF::RNode node = *m_RdfNode;
+        for (const auto &cut : cuts)
+            node = FilterRdfNode_(node, m_RdfColumns, cut);
+        // The region branches off the main lineage, so it starts from the columns that lineage defined and reuses them
+        // instead of defining them again under the same name.
+        RdfRegion &region = m_RdfRegions.emplace(name, RdfRegion{cuts, node, m_RdfColumns, {}, {}}).first->second;
+        for (const auto &[alias, inmap] : m_HistRdf)
+            for (const auto &[prefix, _] : inmap)
+            {
+                VariedRdfResults varied;
+                region.Histograms[alias][prefix] = BookRdfHistogram_(region.Node, region.Columns, alias, prefix, m_HistSpecs.at(alias).at(prefix), varied);
+                if (varied) region.Variations[alias][prefix] = std::move(varied);
+            }
+        LOG_INFO("AnalysisManager", "Region '" << name << "' defined with " << cuts.size() << " cuts and " << m_HistRdf.size()
+                                               << " booked histogram aliases.");
     }
-    else
-        throw std::runtime_error("AnalysisManager: RDF cut is not registered: " + name);
+}
+
+std::vector<std::string> AnalysisManager::ListRegions() const
+{
+    std::vector<std::string> names;
+    for (const auto &[name, _] : m_RdfRegions)
+        names.push_back(name);
+    return names;
 }
 
 void AnalysisManager::ApplyRdfFilter(const std::string &name, const std::string &expr)
@@ -85,10 +248,12 @@ void AnalysisManager::ApplyRdfFilter(const std::string &name, const std::string
         throw std::runtime_error("AnalysisManager: RDF cut already exists: " + name);
     else
     {
-        m_RdfNode = m_RdfNode->Filter(expr, name);
+        m_RdfNode = ApplyRdfExpression_(*m_RdfNode, m_RdfColumns, true, name, expr);
         LOG_INFO("AnalysisManager", "Direct filter is applied and registered. name : " << name << " and expr : " << expr);
         m_RawCutExpr[name] = expr;
+        AddToCutSequence_(name);
         m_AppliedRdfCuts.insert(name);
+        BookRdfCutflowStage_(name);
     }
 }
 
@@ -109,24 +274,105 @@ void AnalysisManager::BookRdfHistogram1D(const std::string &alias, const std::st
 {
     if (!m_RdfNode) throw std::runtime_error("RDF not initialized!");
     ValidateHistogramBins(binfo, alias);
+    BookRdfHistogram(alias, prefix, HistogramSpec::FromBins(expression, binfo));
+}
+
+void AnalysisManager::BookRdfHistogram(const std::string &alias, const std::string &prefix, HistogramSpec spec)
+{
+    if (!m_RdfNode) throw std::runtime_error("RDF not initialized!");
+    if (!spec.Axes.empty() && spec.Axes.front().Expression.empty()) spec.Axes.front().Expression = alias;
+    spec.Validate(alias);
     std::string fullname = "hist_" + alias + "_" + prefix;
     if (m_HistRdf.count(alias) && m_HistRdf.at(alias).count(prefix))
         throw std::runtime_error("AnalysisManager: RDF histogram already exists: " + fullname);
-    std::string column = expression.empty() ? alias : expression;
-    const auto columns = m_RdfNode->GetColumnNames();
-    if (std::find(columns.begin(), columns.end(), column) == columns.end())
+    VariedRdfResults varied;
+    m_HistRdf[alias][prefix] = BookRdfHistogram_(*m_RdfNode, m_RdfColumns, alias, prefix, spec, varied);
+    if (varied) m_HistRdfVariations[alias][prefix] = std::move(varied);
+    for (auto &[_, region] : m_RdfRegions)
     {
-        const std::string internalColumn = "__cascade_hist_" + SafeColumnName(alias + "_" + prefix);
-        m_RdfNode = m_RdfNode->Define(internalColumn, ExpandAliases_(column));
-        column = internalColumn;
+        VariedRdfResults regionVaried;
+        region.Histograms[alias][prefix] = BookRdfHistogram_(region.Node, region.Columns, alias, prefix, spec, regionVaried);
+        if (regionVaried) region.Variations[alias][prefix] = std::move(regionVaried);
     }
-    auto model = ROOT::RDF::TH1DModel(fullname.c_str(), "", int(binfo[0]), binfo[1], binfo[2]);
-    auto rptr = m_RdfNode->Histo1D(model, column);
-    m_HistRdf[alias][prefix] = rptr;
-    m_HistMap[alias][prefix] = binfo;
-    m_HistExpressions[alias][prefix] = expression.empty() ? alias : expression;
-    LOG_INFO("AnalysisManager", "Booked RDF histogram '" << fullname << "' with bins {" << binfo[0] << ", " << binfo[1] << ", "
-                                           << binfo[2] << "}");
+    LOG_INFO("AnalysisManager", "Booked RDF histogram '" << fullname << "' with bins " << spec.Describe()
+                                                         << (m_RdfRegions.empty() ? "" : " in " + std::to_string(m_RdfRegions.size() + 1) + " regions"));
+    m_HistSpecs[alias][prefix] = std::move(spec);
+}
+
+const std::set<std::string> &AnalysisManager::RdfColumnNames_(ROOT::RDF::RNode &node, RdfColumnRegistry &registry) const
+{
+    if (!registry.Columns)
+    {
+        const auto names = node.GetColumnNames();
+        registry.Columns.emplace(names.begin(), names.end());
+    }
+    return *registry.Columns;
+}
+
+ROOT::RDF::RResultPtr<TH1> AnalysisManager::BookRdfHistogram_(ROOT::RDF::RNode &node, RdfColumnRegistry &registry, const std::string &alias,
+                                                              const std::string &prefix, const HistogramSpec &spec, VariedRdfResults &varied)
+{
+    const auto hasColumn = [&](const std::string &name) { return RdfColumnNames_(node, registry).count(name) > 0; };
+    // Existing columns are filled directly. Any other expression is defined once per lineage, in an internal column
+    // named after the first histogram that needs it, and every later histogram with the same expansion reuses it.
+    const auto column = [&](const std::string &expression, const std::string &internalColumn)
+    {
+        if (hasColumn(expression)) return expression;
+        const std::string expanded = ExpandAliases_(expression, m_RdfVariedAliases);
+        const auto found = registry.Expressions.find(expanded);
+        if (found != registry.Expressions.end()) return found->second;
+        node = ApplyRdfExpression_(node, registry, false, internalColumn, expanded);
+        registry.Expressions.emplace(expanded, internalColumn);
+        return internalColumn;
+    };
+    const std::string fullname = "hist_" + alias + "_" + prefix;
+    const std::string suffix = SafeColumnName(alias + "_" + prefix);
+    std::vector<std::string> axisColumns;
+    for (std::size_t axis = 0; axis < spec.Axes.size(); ++axis)
+        axisColumns.push_back(column(spec.Axes[axis].Expression, "__cascade_hist_" + suffix + (axis == 0 ? "" : axis == 1 ? "_y" : "_z")));
+    // A region branched off before the first weight variation does not see its factor column.
+    const std::string weightColumn = m_RdfVariationWeight && hasColumn(VARIATION_WEIGHT_COLUMN) ? VARIATION_WEIGHT_COLUMN : "";
+
+    // The models copy their binning from a template histogram, which covers uniform and variable-width axes alike.
+    const auto templateHistogram = spec.Create(fullname, spec.Kind == HistogramKind::TH1D ? "" : spec.Title());
+    ROOT::RDF::RResultPtr<TH1> rptr;
+    // Varied results are booked with the nominal one so the same event loop fills them.
+    const auto keep = [this, &rptr, &varied](const auto &result)
+    {
+        rptr = result;
+        if (!m_Variations.empty()) varied = TrackVariations(result);
+    };
+    switch (spec.Kind)
+    {
+    case HistogramKind::TH1D:
+    {
+        const ROOT::RDF::TH1DModel model(*static_cast<TH1D *>(templateHistogram.get()));
+        keep(weightColumn.empty() ? node.Histo1D(model, axisColumns[0]) : node.Histo1D(model, axisColumns[0], weightColumn));
+        break;
+    }
+    case HistogramKind::TH2D:
+    {
+        const ROOT::RDF::TH2DModel model(*static_cast<TH2D *>(templateHistogram.get()));
+        keep(weightColumn.empty() ? node.Histo2D(model, axisColumns[0], axisColumns[1])
+                                  : node.Histo2D(model, axisColumns[0], axisColumns[1], weightColumn));
+        break;
+    }
+    case HistogramKind::TH3D:
+    {
+        const ROOT::RDF::TH3DModel model(*static_cast<TH3D *>(templateHistogram.get()));
+        keep(weightColumn.empty() ? node.Histo3D(model, axisColumns[0], axisColumns[1], axisColumns[2])
+                                  : node.Histo3D(model, axisColumns[0], axisColumns[1], axisColumns[2], weightColumn));
+        break;
+    }
+    case HistogramKind::TProfile:
+    {
+        const ROOT::RDF::TProfile1DModel model(*static_cast<TProfile *>(templateHistogram.get()));
+        keep(weightColumn.empty() ? node.Profile1D(model, axisColumns[0], axisColumns[1])
+                                  : node.Profile1D(model, axisColumns[0], axisColumns[1], weightColumn));
+        break;
+    }
+    }
+    return rptr;
 }
 
 void AnalysisManager::BookRdfHistogramsFromConfig(const std::string &yamlPath, const std::string &prefix)
@@ -134,23 +380,14 @@ void AnalysisManager::BookRdfHistogramsFromConfig(const std::string &yamlPath, c
     YAML::Node root = YAML::LoadFile(yamlPath);
     auto hists = root["histograms"];
     if (!hists) return;
+    LoadVariations_(root, false);
     for (auto it : hists)
     {
-        std::string alias = it.first.as<std::string>();
-        std::string expr = it.second["expr"].as<std::string>();
-        auto bins = it.second["bins"];
-
-        if (bins.size() == 3)
-        {
-            int nbins = bins[0].as<int>();
-            double xmin = bins[1].as<double>();
-            double xmax = bins[2].as<double>();
-            BookRdfHistogram1D(alias, prefix, {double(nbins), xmin, xmax}, expr);
-        }
-        else
-        {
-            throw std::invalid_argument("AnalysisManager: invalid bin format for RDF histogram '" + alias + "'.");
-        }
+        const std::string alias = it.first.as<std::string>();
+        std::vector<std::string> errors;
+        auto spec = HistogramSpec::FromYaml(it.second, alias, errors);
+        if (!spec) throw std::invalid_argument("AnalysisManager: invalid RDF histogram '" + alias + "': " + errors.front());
+        BookRdfHistogram(alias, prefix, std::move(*spec));
     }
     LOG_INFO("AnalysisManager", "Booked RDF histograms from config " << yamlPath << " with prefix '" << prefix << "'");
 }
@@ -167,9 +404,13 @@ void AnalysisManager::BookRdfHistogramsFromFile(const std::string &histfile)
     LOG_INFO("AnalysisManager", "Booked RDF histograms based on file " << histfile);
 }
 
-void AnalysisManager::WriteRdfSnapshot(const std::string &treeName, const std::string &fileName, TreeOpt::Om option)
+void AnalysisManager::WriteRdfSnapshot(const std::string &treeName, const std::string &fileName, TreeOpt::Om option, DataFormat format,
+                                       const std::optional<OutputSettings> &settings)
 {
     if (!m_UseRdf) throw std::runtime_error("RDF not initialized");
+#ifndef CASCADE_HAS_RNTUPLE
+    if (format == DataFormat::RNTuple) throw std::runtime_error("AnalysisManager: RNTuple snapshots require ROOT 6.36 or newer.");
+#endif
     std::atomic<ULong64_t> counter = 0;
     const double entryCount = static_cast<double>(GetEntryCount());
     auto callback = m_RdfNode->Count();
@@ -183,6 +424,10 @@ void AnalysisManager::WriteRdfSnapshot(const std::string &treeName, const std::s
     // ROOT::RDF::Experimental::AddProgressBar(*m_RdfNode);
     ROOT::RDF::RSnapshotOptions opts;
     opts.fLazy = true;
+    (settings ? *settings : m_OutputSettings).Apply(opts);
+#ifdef CASCADE_HAS_RNTUPLE
+    if (format == DataFormat::RNTuple) opts.fOutputFormat = ROOT::RDF::ESnapshotOutputFormat::kRNTuple;
+#endif
     std::vector<std::string> columns;
     if (option == TreeOpt::Om::Recreate)
         columns = GetDefinedVarNames();
@@ -191,6 +436,7 @@ void AnalysisManager::WriteRdfSnapshot(const std::string &treeName, const std::s
     else
         throw std::runtime_error("AnalysisManager: unsupported snapshot option.");
     auto snapshot = m_RdfNode->Snapshot(treeName, fileName, columns, opts);
+    BookRdfCutflowReport_();
     m_StartTime = std::chrono::steady_clock::now();
     ROOT::RDF::RunGraphs({callback, snapshot});
     UpdateProgress_(1.0);
@@ -219,13 +465,21 @@ void AnalysisManager::WriteRdfHistograms(const std::string &outfile)
     for (auto &[_, histograms] : m_HistRdf)
         for (auto &[__, histogram] : histograms)
             actions.emplace_back(histogram);
+    for (auto &[_, region] : m_RdfRegions)
+        for (auto &[__, histograms] : region.Histograms)
+            for (auto &[___, histogram] : histograms)
+                actions.emplace_back(histogram);
+    BookRdfCutflowReport_();
     m_StartTime = std::chrono::steady_clock::now();
     ROOT::RDF::RunGraphs(actions);
-    for (auto &[_, inmap] : m_HistRdf)
+    WriteRdfResults(m_HistRdf, m_HistRdfVariations);
+    for (auto &[name, region] : m_RdfRegions)
     {
-        for (auto &[_, hist] : inmap)
-            if (hist->Write(hist->GetName(), TObject::kOverwrite) < 0)
-                throw std::runtime_error("AnalysisManager: failed to write RDF histogram: " + std::string(hist->GetName()));
+        TDirectory *directory = file.mkdir(name.c_str(), "", true);
+        if (!directory) throw std::runtime_error("AnalysisManager: cannot create region directory: " + name);
+        directory->cd();
+        WriteRdfResults(region.Histograms, region.Variations);
+        file.cd();
     }
     file.Close();
     UpdateProgress_(1.0);
@@ -239,13 +493,32 @@ std::unique_ptr<AnalysisManager> AnalysisManager::Fork()
     forked->m_RdfNode = this->m_RdfNode->Filter([]() { return true; });
     forked->m_UseRdf = true;
     forked->m_RawCutExpr = this->m_RawCutExpr;
+    forked->m_CutSequence = this->m_CutSequence;
     forked->m_AppliedRdfCuts = this->m_AppliedRdfCuts;
     forked->m_BranchMap = this->m_BranchMap;
+    forked->m_AliasExpansions = this->m_AliasExpansions;
+    forked->m_AliasRegexFallback = this->m_AliasRegexFallback;
     forked->m_InputFiles = this->m_InputFiles;
     forked->m_InTreeName = this->m_InTreeName;
+    forked->m_InputFormat = this->m_InputFormat;
+    forked->m_OutputSettings = this->m_OutputSettings;
+    // Vary calls upstream of the fork still apply to what it books.
+    forked->m_Variations = this->m_Variations;
+    forked->m_RdfVariationWeight = this->m_RdfVariationWeight;
+    forked->m_RdfVariedAliases = this->m_RdfVariedAliases;
     forked->m_CurrentTree = this->m_CurrentTree;
     forked->m_CurrentTreeOwner = this->m_CurrentTreeOwner;
     forked->m_LambdaManager = std::make_unique<LambdaManager>();
+    forked->m_RdfExpressionCacheDirectory = this->m_RdfExpressionCacheDirectory;
+    forked->m_RdfColumns = this->m_RdfColumns;
+    // Upstream stages keep the parent's results; filters applied to the fork extend its own report.
+    forked->m_CutflowEnabled = this->m_CutflowEnabled;
+    forked->m_RdfCutflowWeight = this->m_RdfCutflowWeight;
+    forked->m_RdfCutflowEntries = this->m_RdfCutflowEntries;
+    forked->m_RdfCutflowEntriesWeight = this->m_RdfCutflowEntriesWeight;
+    forked->m_RdfCutflowNode = this->m_RdfCutflowNode;
+    forked->m_RdfCutflowReport = this->m_RdfCutflowReport;
+    forked->m_RdfCutflowWeights = this->m_RdfCutflowWeights;
 
     return forked;
 }
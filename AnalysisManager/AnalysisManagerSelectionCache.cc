@@ -0,0 +1,147 @@
+#include "AnalysisManager.hh"
+#include "AnalysisManagerDetail.inc"
+#include "CacheManager.hh"
+#include "sha256.hh"
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <unistd.h>
+
+using namespace logger;
+using cascade::analysis_detail::FileIdentity;
+
+namespace
+{
+constexpr char SELECTION_MAGIC[8] = {'C', 'A', 'S', 'C', 'S', 'E', 'L', '1'};
+
+// Layout: magic, total entries and selected count as little-endian int64, then the gaps between consecutive selected
+// entries as LEB128 varints. Dense selections cost about one byte per entry.
+void WriteSelection(const std::filesystem::path &path, Long64_t total, const std::vector<Long64_t> &selected)
+{
+    std::string payload(SELECTION_MAGIC, sizeof(SELECTION_MAGIC));
+    const auto appendFixed = [&payload](std::uint64_t value)
+    {
+        for (int byte = 0; byte < 8; ++byte)
+            payload.push_back(static_cast<char>((value >> (8 * byte)) & 0xff));
+    };
+    appendFixed(static_cast<std::uint64_t>(total));
+    appendFixed(static_cast<std::uint64_t>(selected.size()));
+    Long64_t previous = 0;
+    for (const Long64_t entry : selected)
+    {
+        auto gap = static_cast<std::uint64_t>(entry - previous);
+        previous = entry;
+        do
+        {
+            payload.push_back(static_cast<char>((gap & 0x7f) | (gap > 0x7f ? 0x80 : 0)));
+            gap >>= 7;
+        } while (gap);
+    }
+
+    std::error_code error;
+    std::filesystem::create_directories(path.parent_path(), error);
+    const std::filesystem::path temporary = path.string() + ".tmp." + std::to_string(getpid());
+    {
+        std::ofstream output(temporary, std::ios::binary | std::ios::trunc);
+        output.write(payload.data(), static_cast<std::streamsize>(payload.size()));
+        if (!output)
+        {
+            std::filesystem::remove(temporary, error);
+            LOG_WARN("AnalysisManager", "Cannot write selection cache " << path.string());
+            return;
+        }
+    }
+    std::filesystem::rename(temporary, path, error);
+    if (error) std::filesystem::remove(temporary, error);
+}
+
+bool ReadSelection(const std::filesystem::path &path, Long64_t total, std::vector<Long64_t> &selected)
+{
+    std::ifstream input(path, std::ios::binary);
+    if (!input) return false;
+    const std::string payload((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+    std::size_t offset = sizeof(SELECTION_MAGIC);
+    if (payload.size() < offset + 16 || std::memcmp(payload.data(), SELECTION_MAGIC, sizeof(SELECTION_MAGIC)) != 0) return false;
+    const auto readFixed = [&payload, &offset]()
+    {
+        std::uint64_t value = 0;
+        for (int byte = 0; byte < 8; ++byte)
+            value |= static_cast<std::uint64_t>(static_cast<unsigned char>(payload[offset++])) << (8 * byte);
+        return value;
+    };
+    if (static_cast<Long64_t>(readFixed()) != total) return false;
+    const std::uint64_t count = readFixed();
+    if (count > static_cast<std::uint64_t>(total)) return false;
+
+    std::vector<Long64_t> entries;
+    entries.reserve(count);
+    Long64_t previous = 0;
+    while (entries.size() < count)
+    {
+        std::uint64_t gap = 0;
+        for (int shift = 0;; shift += 7)
+        {
+            if (offset == payload.size() || shift > 63) return false;
+            const auto byte = static_cast<unsigned char>(payload[offset++]);
+            gap |= static_cast<std::uint64_t>(byte & 0x7f) << shift;
+            if (!(byte & 0x80)) break;
+        }
+        const Long64_t entry = previous + static_cast<Long64_t>(gap);
+        if (entry >= total || (!entries.empty() && gap == 0)) return false;
+        entries.push_back(entry);
+        previous = entry;
+    }
+    if (offset != payload.size()) return false;
+    selected = std::move(entries);
+    return true;
+}
+} // namespace
+
+void AnalysisManager::SetSelectionCacheDirectory(const std::string &directory) { m_SelectionCacheDirectory = directory; }
+
+std::optional<std::string> AnalysisManager::SelectionKey_() const
+{
+    nlohmann::json inputs = nlohmann::json::array();
+    for (const auto &path : m_InputFiles)
+    {
+        const auto identity = FileIdentity(path);
+        if (!identity) return std::nullopt;
+        inputs.push_back(*identity);
+    }
+    nlohmann::json cuts = nlohmann::json::object();
+    for (const auto &[name, _] : m_EnabledCuts)
+        cuts[name] = ExpandAliases_(m_RawCutExpr.at(name));
+    nlohmann::json key = {{"schema_version", 1}, {"tree", m_InTreeName}, {"inputs", inputs}, {"cuts", cuts}};
+    // The list also holds the entries only a cut-level variation selects, so the varied cuts are part of the key.
+    for (const VariedSelection &selection : m_VariedSelections)
+        for (const auto &[name, _] : selection.Cuts)
+            key["variations"][selection.Variation][name] = ExpandAliases_(m_Variations.at(selection.Variation).Apply(m_RawCutExpr.at(name)));
+    return Sha256(key.dump());
+}
+
+const std::vector<Long64_t> &AnalysisManager::GetSelectedEntries()
+{
+    if (!m_CurrentTree || m_UseRdf) throw std::runtime_error("AnalysisManager: selected entries require an initialized non-RDF tree.");
+    const auto key = SelectionKey_();
+    if (key && *key == m_SelectedEntriesKey) return m_SelectedEntries;
+
+    m_SelectedEntries.clear();
+    m_SelectedEntriesKey.clear();
+    const Long64_t entries = GetEntryCount();
+    if (!m_SelectionCacheDirectory) m_SelectionCacheDirectory = CacheManager::CacheDir() + "/selections";
+    std::filesystem::path path;
+    if (key && !m_SelectionCacheDirectory->empty()) path = std::filesystem::path(*m_SelectionCacheDirectory) / (*key + ".sel");
+    if (!path.empty() && ReadSelection(path, entries, m_SelectedEntries))
+    {
+        m_SelectedEntriesKey = *key;
+        LOG_INFO("AnalysisManager", "Selection cache hit: " << m_SelectedEntries.size() << " of " << entries << " entries pass the enabled cuts.");
+        return m_SelectedEntries;
+    }
+
+    SelectEntries_(0, entries, m_SelectedEntries, 256, true);
+    if (!path.empty()) WriteSelection(path, entries, m_SelectedEntries);
+    if (key) m_SelectedEntriesKey = *key;
+    LOG_INFO("AnalysisManager", "Selection evaluated: " << m_SelectedEntries.size() << " of " << entries << " entries pass the enabled cuts"
+                                                       << (path.empty() ? "." : "; stored in " + path.string() + "."));
+    return m_SelectedEntries;
+}
@@ -0,0 +1,329 @@
+#include "AnalysisManager.hh"
+#include "AnalysisManagerDetail.inc"
+
+using namespace logger;
+using cascade::analysis_detail::IsWord;
+using cascade::analysis_detail::RewriteWords;
+using cascade::analysis_detail::VARIATION_WEIGHT_COLUMN;
+using cascade::analysis_detail::VariedPrefix;
+
+namespace
+{
+HistogramSpec VarySpec(const HistogramSpec &nominal, const SystematicVariation &variation)
+{
+    HistogramSpec varied = nominal;
+    for (auto &axis : varied.Axes)
+        axis.Expression = variation.Apply(axis.Expression);
+    varied.Variation = variation.Name;
+    return varied;
+}
+} // namespace
+
+std::optional<SystematicVariation> SystematicVariation::FromYaml(const YAML::Node &entry, const std::string &name,
+                                                                 std::vector<std::string> &errors)
+{
+    const std::string path = "variations." + name;
+    if (!entry || !entry.IsMap())
+    {
+        errors.push_back(path + " must be a map with columns and/or weight");
+        return std::nullopt;
+    }
+    const std::size_t firstError = errors.size();
+    // Names end up in histogram names and RDF variation names.
+    if (!IsWord(name)) errors.push_back(path + " must be named with letters, digits, and underscores only");
+    SystematicVariation variation;
+    variation.Name = name;
+    for (const auto &field : entry)
+    {
+        const std::string key = field.first.as<std::string>();
+        if (key != "columns" && key != "weight") errors.push_back(path + "." + key + " is not a variation field");
+    }
+    if (const YAML::Node columns = entry["columns"])
+    {
+        if (!columns.IsMap())
+            errors.push_back(path + ".columns must map aliases to replacement expressions");
+        else
+            for (const auto &column : columns)
+            {
+                const std::string alias = column.first.as<std::string>();
+                if (!IsWord(alias))
+                    errors.push_back(path + ".columns." + alias + " must name an alias");
+                else if (!column.second.IsScalar() || column.second.as<std::string>().empty())
+                    errors.push_back(path + ".columns." + alias + " must be a non-empty string");
+                else
+                    variation.Columns[alias] = column.second.as<std::string>();
+            }
+    }
+    if (const YAML::Node weight = entry["weight"])
+    {
+        if (!weight.IsScalar() || weight.as<std::string>().empty())
+            errors.push_back(path + ".weight must be a non-empty string");
+        else
+            variation.Weight = weight.as<std::string>();
+    }
+    if (errors.size() == firstError && variation.Columns.empty() && variation.Weight.empty())
+        errors.push_back(path + " must vary at least one column or the weight");
+    if (errors.size() != firstError) return std::nullopt;
+    return variation;
+}
+
+std::string SystematicVariation::Apply(const std::string &expression) const
+{
+    if (Columns.empty()) return expression;
+    std::string replacement;
+    return RewriteWords(expression,
+                        [this, &replacement](const std::string &word) -> const std::string *
+                        {
+                            const auto column = Columns.find(word);
+                            if (column == Columns.end()) return nullptr;
+                            replacement = "(" + column->second + ")";
+                            return &replacement;
+                        });
+}
+
+void SystematicVariation::EmitYaml(YAML::Emitter &out) const
+{
+    if (!Columns.empty())
+    {
+        out << YAML::Key << "columns" << YAML::Value << YAML::BeginMap;
+        for (const auto &[alias, expression] : Columns)
+            out << YAML::Key << alias << YAML::Value << expression;
+        out << YAML::EndMap;
+    }
+    if (!Weight.empty()) out << YAML::Key << "weight" << YAML::Value << Weight;
+}
+
+bool SystematicVariation::operator==(const SystematicVariation &other) const
+{
+    return Name == other.Name && Columns == other.Columns && Weight == other.Weight && AffectsCuts == other.AffectsCuts;
+}
+
+void AnalysisManager::DeclareVariation(SystematicVariation variation)
+{
+    if (!IsWord(variation.Name)) throw std::invalid_argument("AnalysisManager: variation names must be letters, digits, and underscores: " + variation.Name);
+    if (variation.Columns.empty() && variation.Weight.empty())
+        throw std::invalid_argument("AnalysisManager: variation varies neither columns nor the weight: " + variation.Name);
+    if (const auto existing = m_Variations.find(variation.Name); existing != m_Variations.end())
+    {
+        if (existing->second == variation) return;
+        throw std::runtime_error("AnalysisManager: variation is already declared differently: " + variation.Name);
+    }
+    if (m_UseRdf)
+    {
+        // Vary only reaches the nodes booked after it, so a selection variation has to precede the filters.
+        if (variation.AffectsCuts && !m_AppliedRdfCuts.empty())
+            throw std::runtime_error("AnalysisManager: cut variations must be declared before RDF filters are applied: " + variation.Name);
+        ApplyRdfVariation_(variation);
+    }
+    LOG_INFO("AnalysisManager", "Variation '" << variation.Name << "' declared with " << variation.Columns.size() << " varied columns"
+                                              << (variation.Weight.empty() ? "" : " and weight " + variation.Weight)
+                                              << (variation.AffectsCuts ? ", applied to the cuts." : "."));
+    const std::string name = variation.Name;
+    m_Variations[name] = std::move(variation);
+    if (!m_EnabledCuts.empty()) BuildVariedSelections_();
+    SyncVariedHistograms_();
+    ApplyInputReadPlan_();
+}
+
+std::vector<std::string> AnalysisManager::ListVariations() const
+{
+    std::vector<std::string> names;
+    for (const auto &[name, _] : m_Variations)
+        names.push_back(name);
+    return names;
+}
+
+void AnalysisManager::LoadVariations_(const YAML::Node &config, bool affectsCuts)
+{
+    const YAML::Node variations = config["variations"];
+    if (!variations) return;
+    for (const auto &entry : variations)
+    {
+        const std::string name = entry.first.as<std::string>();
+        std::vector<std::string> errors;
+        auto variation = SystematicVariation::FromYaml(entry.second, name, errors);
+        if (!variation) throw std::invalid_argument("AnalysisManager: invalid variation '" + name + "': " + errors.front());
+        variation->AffectsCuts = affectsCuts;
+        DeclareVariation(std::move(*variation));
+    }
+}
+
+void AnalysisManager::PreflightVariations_(const YAML::Node &config, ConfigValidationResult &result) const
+{
+    const YAML::Node variations = config["variations"];
+    if (!variations) return;
+    if (!variations.IsMap())
+    {
+        result.Errors.push_back("variations must be a map");
+        return;
+    }
+    for (const auto &entry : variations)
+    {
+        try
+        {
+            const std::string name = entry.first.as<std::string>();
+            const auto variation = SystematicVariation::FromYaml(entry.second, name, result.Errors);
+            if (!variation || !m_CurrentTree) continue;
+            for (const auto &[alias, expression] : variation->Columns)
+                if (!PreflightExpression_(ExpandAliases_(expression)))
+                    result.Errors.push_back("variations." + name + ".columns." + alias + " is not a valid tree expression");
+            if (!variation->Weight.empty() && !PreflightExpression_(ExpandAliases_(variation->Weight)))
+                result.Errors.push_back("variations." + name + ".weight is not a valid tree expression");
+        }
+        catch (const std::exception &error)
+        {
+            result.Errors.push_back(std::string("invalid variation entry: ") + error.what());
+        }
+    }
+}
+
+// A variation affects a histogram when it changes a filled value or weight, or, for a cut-level variation, the
+// selection. This is the dependency RDF tracks for VariationsFor, so both paths produce the same set of histograms.
+bool AnalysisManager::VariationAffects_(const SystematicVariation &variation, const HistogramSpec &spec) const
+{
+    if (!variation.Weight.empty()) return true;
+    const auto reads = [&variation](const std::string &expression) { return variation.Apply(expression) != expression; };
+    for (const auto &axis : spec.Axes)
+        if (reads(axis.Expression)) return true;
+    if (variation.AffectsCuts)
+        for (const auto &[_, expression] : m_RawCutExpr)
+            if (reads(expression)) return true;
+    return false;
+}
+
+void AnalysisManager::SyncVariedHistograms_()
+{
+    using Key = std::pair<std::string, std::string>;
+    std::map<Key, std::pair<const TH1 *, HistogramSpec>> wanted;
+    std::vector<Key> existing;
+    for (const auto &[alias, inmap] : m_HistData)
+        for (const auto &[prefix, hist] : inmap)
+        {
+            const HistogramSpec &spec = m_HistSpecs.at(alias).at(prefix);
+            if (!spec.Variation.empty())
+            {
+                existing.emplace_back(alias, prefix);
+                continue;
+            }
+            for (const auto &[name, variation] : m_Variations)
+                if (VariationAffects_(variation, spec)) wanted.emplace(Key{alias, VariedPrefix(prefix, name)}, std::make_pair(hist, VarySpec(spec, variation)));
+        }
+
+    // Unchanged varied histograms keep their contents; the rest are dropped and rebuilt from the nominal histogram.
+    bool changed = false;
+    for (const auto &key : existing)
+    {
+        const auto &[alias, prefix] = key;
+        const auto target = wanted.find(key);
+        if (target != wanted.end() && target->second.second == m_HistSpecs.at(alias).at(prefix))
+        {
+            wanted.erase(target);
+            continue;
+        }
+        delete m_HistData.at(alias).at(prefix);
+        m_HistData.at(alias).erase(prefix);
+        m_HistSpecs.at(alias).erase(prefix);
+        m_HistOwnership.at(alias).erase(prefix);
+        changed = true;
+    }
+    for (auto &[key, source] : wanted)
+    {
+        const auto &[alias, prefix] = key;
+        const std::string fullname = "hist_" + alias + "_" + prefix;
+        if (m_HistData.at(alias).count(prefix))
+            throw std::runtime_error("AnalysisManager: varied histogram collides with a booked histogram: " + fullname);
+        auto *hist = static_cast<TH1 *>(source.first->Clone(fullname.c_str()));
+        hist->Reset();
+        hist->SetDirectory(nullptr);
+        m_HistData[alias][prefix] = hist;
+        m_HistSpecs[alias][prefix] = std::move(source.second);
+        m_HistOwnership[alias][prefix] = ResourceOwnership::Owned;
+        changed = true;
+    }
+    if (changed) ResetFillPlan_();
+}
+
+void AnalysisManager::BuildVariedSelections_()
+{
+    m_VariedSelections.clear();
+    for (const auto &[name, variation] : m_Variations)
+    {
+        if (!variation.AffectsCuts) continue;
+        VariedSelection selection{name, {}};
+        for (const auto &[cut, _] : m_EnabledCuts)
+        {
+            const std::string &expression = m_RawCutExpr.at(cut);
+            const std::string varied = variation.Apply(expression);
+            if (varied != expression) selection.Cuts[cut] = MakeEnabledCut_(cut + "_" + name, varied);
+        }
+        // A variation that reaches no enabled cut selects the nominal events.
+        if (!selection.Cuts.empty()) m_VariedSelections.push_back(std::move(selection));
+    }
+    ResetFillPlan_();
+}
+
+bool AnalysisManager::PassesVariedSelection_(const VariedSelection &selection) const
+{
+    for (const auto &[name, cut] : m_EnabledCuts)
+    {
+        const auto varied = selection.Cuts.find(name);
+        if (!(varied == selection.Cuts.end() ? cut : varied->second).Passes()) return false;
+    }
+    return true;
+}
+
+void AnalysisManager::FillSelectedHistograms(double weight)
+{
+    if (!m_CurrentTree) throw std::runtime_error("AnalysisManager: cannot fill histograms before a tree is initialized.");
+    if (!m_FillPlanReady) BuildFillPlan_();
+    m_SelectionPasses.resize(m_VariedSelections.size() + 1);
+    m_SelectionPasses[0] = PassesAllCuts(weight);
+    bool any = m_SelectionPasses[0];
+    for (std::size_t index = 0; index < m_VariedSelections.size(); ++index)
+        any = (m_SelectionPasses[index + 1] = PassesVariedSelection_(m_VariedSelections[index])) || any;
+    if (any) FillPlan_(weight, &m_SelectionPasses);
+}
+
+// All columns of one variation are varied together through a single Vary call, which RDF requires to share a type.
+// Weight variations vary a shared factor column that histograms booked afterwards multiply into their weight.
+void AnalysisManager::ApplyRdfVariation_(const SystematicVariation &variation)
+{
+    if (!m_RdfNode) throw std::runtime_error("AnalysisManager: RDF is not initialized.");
+    std::vector<std::string> columns;
+    std::vector<std::string> values;
+    for (const auto &[alias, expression] : variation.Columns)
+    {
+        columns.push_back(alias);
+        values.push_back(ExpandAliases_(expression));
+    }
+    if (!variation.Weight.empty())
+    {
+        if (!m_RdfVariationWeight)
+        {
+            m_RdfNode = m_RdfNode->Define(VARIATION_WEIGHT_COLUMN, "1.0");
+            m_RdfVariationWeight = true;
+        }
+        columns.push_back(VARIATION_WEIGHT_COLUMN);
+        values.push_back(ExpandAliases_(variation.Weight));
+    }
+    const std::string type = m_RdfNode->GetColumnType(columns.front());
+    for (const auto &column : columns)
+        if (m_RdfNode->GetColumnType(column) != type)
+            throw std::invalid_argument("AnalysisManager: RDF variation '" + variation.Name + "' varies columns of different types (" +
+                                        columns.front() + " and " + column + ").");
+    const auto element = [&type](const std::string &value) { return "{static_cast<" + type + ">(" + value + ")}"; };
+    if (columns.size() == 1)
+        m_RdfNode = m_RdfNode->Vary(columns.front(), "ROOT::RVec<" + type + ">" + element(values.front()), 1, variation.Name);
+    else
+    {
+        std::string expression = "ROOT::RVec<ROOT::RVec<" + type + ">>{";
+        for (std::size_t index = 0; index < values.size(); ++index)
+            expression += (index ? ", " : "") + element(values[index]);
+        m_RdfNode = m_RdfNode->Vary(columns, expression + "}", 1, variation.Name);
+    }
+    // Columns defined upstream of the Vary do not see it, so later histograms must not reuse them.
+    m_RdfColumns = {};
+    // Cuts and expressions that expanded a varied alias to its branch would read the nominal branch.
+    for (const auto &[alias, _] : variation.Columns)
+        m_RdfVariedAliases.insert(alias);
+}
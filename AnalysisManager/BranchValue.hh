@@ -0,0 +1,89 @@
+#pragma once
+#include <RtypesCore.h>
+#include <type_traits>
+
+enum class BranchValueType
+{
+    Double,
+    Float,
+    Int,
+    UInt,
+    Long64,
+    ULong64,
+    Bool
+};
+
+template <typename T> constexpr BranchValueType BranchValueTypeOf()
+{
+    if constexpr (std::is_same_v<T, double>)
+        return BranchValueType::Double;
+    else if constexpr (std::is_same_v<T, float>)
+        return BranchValueType::Float;
+    else if constexpr (std::is_same_v<T, int>)
+        return BranchValueType::Int;
+    else if constexpr (std::is_same_v<T, unsigned int>)
+        return BranchValueType::UInt;
+    else if constexpr (std::is_same_v<T, Long64_t>)
+        return BranchValueType::Long64;
+    else if constexpr (std::is_same_v<T, ULong64_t>)
+        return BranchValueType::ULong64;
+    else
+    {
+        static_assert(std::is_same_v<T, bool>, "unsupported branch value type");
+        return BranchValueType::Bool;
+    }
+}
+
+// Read-only view of one classic input branch or derived variable. The type is resolved once when the handle is
+// created, so reading it costs a single switch instead of a name lookup. Handles stay valid until BuildChain() or
+// LoadInputConfig() replaces the input chain.
+class ValueHandle
+{
+  public:
+    ValueHandle() = default;
+    ValueHandle(const void *pointer, BranchValueType type) : m_Pointer(pointer), m_Type(type) {}
+
+    bool IsValid() const { return m_Pointer != nullptr; }
+    BranchValueType Type() const { return m_Type; }
+    const void *Data() const { return m_Pointer; }
+    double Get() const
+    {
+        switch (m_Type)
+        {
+        case BranchValueType::Double:
+            return *static_cast<const double *>(m_Pointer);
+        case BranchValueType::Float:
+            return *static_cast<const float *>(m_Pointer);
+        case BranchValueType::Int:
+            return *static_cast<const int *>(m_Pointer);
+        case BranchValueType::UInt:
+            return *static_cast<const unsigned int *>(m_Pointer);
+        case BranchValueType::Long64:
+            return static_cast<double>(*static_cast<const Long64_t *>(m_Pointer));
+        case BranchValueType::ULong64:
+            return static_cast<double>(*static_cast<const ULong64_t *>(m_Pointer));
+        case BranchValueType::Bool:
+            return *static_cast<const bool *>(m_Pointer) ? 1.0 : 0.0;
+        }
+        return 0.0;
+    }
+    double operator*() const { return Get(); }
+
+  private:
+    const void *m_Pointer = nullptr;
+    BranchValueType m_Type = BranchValueType::Double;
+};
+
+template <typename T> class BranchHandle
+{
+  public:
+    BranchHandle() = default;
+    explicit BranchHandle(const T *pointer) : m_Pointer(pointer) {}
+
+    bool IsValid() const { return m_Pointer != nullptr; }
+    T Get() const { return *m_Pointer; }
+    const T &operator*() const { return *m_Pointer; }
+
+  private:
+    const T *m_Pointer = nullptr;
+};
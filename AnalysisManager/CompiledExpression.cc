@@ -0,0 +1,551 @@
+#include "CompiledExpression.hh"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <locale>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+
+namespace
+{
+using OpCode = CompiledExpression::OpCode;
+
+struct FunctionInfo
+{
+    OpCode Op;
+    std::size_t Arity;
+};
+
+// Names accepted by TTreeFormula for the same operations. Anything missing here falls back to TTreeFormula.
+const std::map<std::string, FunctionInfo> &Functions()
+{
+    static const std::map<std::string, FunctionInfo> functions{
+        {"abs", {OpCode::Abs, 1}},         {"fabs", {OpCode::Abs, 1}},         {"TMath::Abs", {OpCode::Abs, 1}},
+        {"sqrt", {OpCode::Sqrt, 1}},       {"TMath::Sqrt", {OpCode::Sqrt, 1}}, {"exp", {OpCode::Exp, 1}},
+        {"TMath::Exp", {OpCode::Exp, 1}},  {"log", {OpCode::Log, 1}},          {"TMath::Log", {OpCode::Log, 1}},
+        {"log10", {OpCode::Log10, 1}},     {"TMath::Log10", {OpCode::Log10, 1}}, {"sin", {OpCode::Sin, 1}},
+        {"TMath::Sin", {OpCode::Sin, 1}},  {"cos", {OpCode::Cos, 1}},          {"TMath::Cos", {OpCode::Cos, 1}},
+        {"tan", {OpCode::Tan, 1}},         {"TMath::Tan", {OpCode::Tan, 1}},   {"asin", {OpCode::ASin, 1}},
+        {"TMath::ASin", {OpCode::ASin, 1}}, {"acos", {OpCode::ACos, 1}},       {"TMath::ACos", {OpCode::ACos, 1}},
+        {"atan", {OpCode::ATan, 1}},       {"TMath::ATan", {OpCode::ATan, 1}}, {"sinh", {OpCode::SinH, 1}},
+        {"TMath::SinH", {OpCode::SinH, 1}}, {"cosh", {OpCode::CosH, 1}},       {"TMath::CosH", {OpCode::CosH, 1}},
+        {"tanh", {OpCode::TanH, 1}},       {"TMath::TanH", {OpCode::TanH, 1}}, {"floor", {OpCode::Floor, 1}},
+        {"TMath::Floor", {OpCode::Floor, 1}}, {"ceil", {OpCode::Ceil, 1}},     {"TMath::Ceil", {OpCode::Ceil, 1}},
+        {"atan2", {OpCode::ATan2, 2}},     {"TMath::ATan2", {OpCode::ATan2, 2}}, {"pow", {OpCode::Power, 2}},
+        {"TMath::Power", {OpCode::Power, 2}}, {"min", {OpCode::Min, 2}},       {"TMath::Min", {OpCode::Min, 2}},
+        {"max", {OpCode::Max, 2}},         {"TMath::Max", {OpCode::Max, 2}},   {"fmod", {OpCode::FMod, 2}},
+    };
+    return functions;
+}
+
+std::size_t Arity(OpCode op)
+{
+    switch (op)
+    {
+    case OpCode::Constant:
+    case OpCode::Input:
+        return 0;
+    case OpCode::Add:
+    case OpCode::Subtract:
+    case OpCode::Multiply:
+    case OpCode::Divide:
+    case OpCode::Modulo:
+    case OpCode::Power:
+    case OpCode::Less:
+    case OpCode::LessEqual:
+    case OpCode::Greater:
+    case OpCode::GreaterEqual:
+    case OpCode::Equal:
+    case OpCode::NotEqual:
+    case OpCode::And:
+    case OpCode::Or:
+    case OpCode::ATan2:
+    case OpCode::Min:
+    case OpCode::Max:
+    case OpCode::FMod:
+        return 2;
+    default:
+        return 1;
+    }
+}
+
+// The guards below are TTreeFormula's, so a compiled expression selects the same events as the interpreted one.
+double ApplyUnary(OpCode op, double value)
+{
+    switch (op)
+    {
+    case OpCode::Negate:
+        return -value;
+    case OpCode::Not:
+        return value == 0.0 ? 1.0 : 0.0;
+    case OpCode::Abs:
+        return std::fabs(value);
+    case OpCode::Sqrt:
+        return std::sqrt(std::fabs(value));
+    case OpCode::Exp:
+        if (value < -700.0) return 0.0;
+        return std::exp(std::min(value, 700.0));
+    case OpCode::Log:
+        return value > 0.0 ? std::log(value) : 0.0;
+    case OpCode::Log10:
+        return value > 0.0 ? std::log10(value) : 0.0;
+    case OpCode::Sin:
+        return std::sin(value);
+    case OpCode::Cos:
+        return std::cos(value);
+    case OpCode::Tan:
+        return std::tan(value);
+    case OpCode::ASin:
+        return std::fabs(value) > 1.0 ? 0.0 : std::asin(value);
+    case OpCode::ACos:
+        return std::fabs(value) > 1.0 ? 0.0 : std::acos(value);
+    case OpCode::ATan:
+        return std::atan(value);
+    case OpCode::SinH:
+        return std::sinh(value);
+    case OpCode::CosH:
+        return std::cosh(value);
+    case OpCode::TanH:
+        return std::tanh(value);
+    case OpCode::Floor:
+        return std::floor(value);
+    case OpCode::Ceil:
+        return std::ceil(value);
+    default:
+        return value;
+    }
+}
+
+double ApplyBinary(OpCode op, double lhs, double rhs)
+{
+    switch (op)
+    {
+    case OpCode::Add:
+        return lhs + rhs;
+    case OpCode::Subtract:
+        return lhs - rhs;
+    case OpCode::Multiply:
+        return lhs * rhs;
+    case OpCode::Divide:
+        return rhs == 0.0 ? 0.0 : lhs / rhs;
+    case OpCode::Modulo:
+    {
+        // TTreeFormula's % truncates both operands to 64-bit integers.
+        if (!std::isfinite(lhs) || !std::isfinite(rhs)) return std::nan("");
+        const auto divisor = static_cast<long long>(rhs);
+        return divisor == 0 ? 0.0 : static_cast<double>(static_cast<long long>(lhs) % divisor);
+    }
+    case OpCode::Power:
+        return std::pow(lhs, rhs);
+    case OpCode::Less:
+        return lhs < rhs ? 1.0 : 0.0;
+    case OpCode::LessEqual:
+        return lhs <= rhs ? 1.0 : 0.0;
+    case OpCode::Greater:
+        return lhs > rhs ? 1.0 : 0.0;
+    case OpCode::GreaterEqual:
+        return lhs >= rhs ? 1.0 : 0.0;
+    case OpCode::Equal:
+        return lhs == rhs ? 1.0 : 0.0;
+    case OpCode::NotEqual:
+        return lhs != rhs ? 1.0 : 0.0;
+    case OpCode::And:
+        return lhs != 0.0 && rhs != 0.0 ? 1.0 : 0.0;
+    case OpCode::Or:
+        return lhs != 0.0 || rhs != 0.0 ? 1.0 : 0.0;
+    case OpCode::ATan2:
+        return std::atan2(lhs, rhs);
+    case OpCode::Min:
+        return std::min(lhs, rhs);
+    case OpCode::Max:
+        return std::max(lhs, rhs);
+    case OpCode::FMod:
+        return std::fmod(lhs, rhs);
+    default:
+        return lhs;
+    }
+}
+
+template <typename F> void Transform(double *lhs, const double *rhs, std::size_t size, F function)
+{
+    for (std::size_t index = 0; index < size; ++index)
+        lhs[index] = function(lhs[index], rhs[index]);
+}
+
+// The common operators get branch-free loops the compiler can vectorize; the rest share the scalar kernel.
+void ApplyBinaryBlock(OpCode op, double *lhs, const double *rhs, std::size_t size)
+{
+    switch (op)
+    {
+    case OpCode::Add:
+        return Transform(lhs, rhs, size, [](double a, double b) { return a + b; });
+    case OpCode::Subtract:
+        return Transform(lhs, rhs, size, [](double a, double b) { return a - b; });
+    case OpCode::Multiply:
+        return Transform(lhs, rhs, size, [](double a, double b) { return a * b; });
+    case OpCode::Divide:
+        return Transform(lhs, rhs, size, [](double a, double b) { return b == 0.0 ? 0.0 : a / b; });
+    case OpCode::Less:
+        return Transform(lhs, rhs, size, [](double a, double b) { return a < b ? 1.0 : 0.0; });
+    case OpCode::LessEqual:
+        return Transform(lhs, rhs, size, [](double a, double b) { return a <= b ? 1.0 : 0.0; });
+    case OpCode::Greater:
+        return Transform(lhs, rhs, size, [](double a, double b) { return a > b ? 1.0 : 0.0; });
+    case OpCode::GreaterEqual:
+        return Transform(lhs, rhs, size, [](double a, double b) { return a >= b ? 1.0 : 0.0; });
+    case OpCode::And:
+        return Transform(lhs, rhs, size, [](double a, double b) { return a != 0.0 && b != 0.0 ? 1.0 : 0.0; });
+    case OpCode::Or:
+        return Transform(lhs, rhs, size, [](double a, double b) { return a != 0.0 || b != 0.0 ? 1.0 : 0.0; });
+    default:
+        return Transform(lhs, rhs, size, [op](double a, double b) { return ApplyBinary(op, a, b); });
+    }
+}
+
+enum class TokenKind
+{
+    Number,
+    Identifier,
+    Operator,
+    LeftParen,
+    RightParen,
+    Comma,
+    End
+};
+
+struct Token
+{
+    TokenKind Kind = TokenKind::End;
+    std::string Text;
+    double Value = 0.0;
+};
+
+bool IsIdentifierStart(char character) { return std::isalpha(static_cast<unsigned char>(character)) || character == '_'; }
+bool IsIdentifierPart(char character) { return std::isalnum(static_cast<unsigned char>(character)) || character == '_'; }
+} // namespace
+
+class ExpressionParser
+{
+  public:
+    ExpressionParser(const std::string &source, const CompiledExpression::Resolver &resolve, CompiledExpression &target)
+        : m_Source(source), m_Resolve(resolve), m_Target(target)
+    {
+    }
+
+    void Parse()
+    {
+        Advance();
+        ParseExpression(0);
+        if (m_Token.Kind != TokenKind::End) Fail("unexpected '" + m_Token.Text + "'");
+    }
+
+  private:
+    const std::string &m_Source;
+    const CompiledExpression::Resolver &m_Resolve;
+    CompiledExpression &m_Target;
+    std::size_t m_Position = 0;
+    Token m_Token;
+    std::size_t m_Depth = 0;
+
+    [[noreturn]] void Fail(const std::string &reason) const
+    {
+        throw std::invalid_argument("CompiledExpression: cannot compile '" + m_Source + "': " + reason);
+    }
+
+    void Advance()
+    {
+        while (m_Position < m_Source.size() && std::isspace(static_cast<unsigned char>(m_Source[m_Position])))
+            ++m_Position;
+        m_Token = Token();
+        if (m_Position >= m_Source.size()) return;
+
+        const std::size_t start = m_Position;
+        const char character = m_Source[m_Position];
+        const char following = m_Position + 1 < m_Source.size() ? m_Source[m_Position + 1] : '\0';
+        if (std::isdigit(static_cast<unsigned char>(character)) || (character == '.' && std::isdigit(static_cast<unsigned char>(following))))
+        {
+            if (character == '0' && (following == 'x' || following == 'X')) Fail("hexadecimal literals are not supported");
+            while (m_Position < m_Source.size() && (std::isdigit(static_cast<unsigned char>(m_Source[m_Position])) || m_Source[m_Position] == '.'))
+                ++m_Position;
+            if (m_Position < m_Source.size() && (m_Source[m_Position] == 'e' || m_Source[m_Position] == 'E'))
+            {
+                ++m_Position;
+                if (m_Position < m_Source.size() && (m_Source[m_Position] == '+' || m_Source[m_Position] == '-')) ++m_Position;
+                while (m_Position < m_Source.size() && std::isdigit(static_cast<unsigned char>(m_Source[m_Position])))
+                    ++m_Position;
+            }
+            m_Token.Kind = TokenKind::Number;
+            m_Token.Text = m_Source.substr(start, m_Position - start);
+            std::istringstream input(m_Token.Text);
+            input.imbue(std::locale::classic());
+            input >> m_Token.Value;
+            if (!input || input.peek() != std::char_traits<char>::eof()) Fail("invalid number '" + m_Token.Text + "'");
+            if (m_Position < m_Source.size() && IsIdentifierPart(m_Source[m_Position])) Fail("invalid number suffix");
+            return;
+        }
+        if (IsIdentifierStart(character))
+        {
+            while (true)
+            {
+                while (m_Position < m_Source.size() && IsIdentifierPart(m_Source[m_Position]))
+                    ++m_Position;
+                std::size_t separator = 0;
+                if (m_Source.compare(m_Position, 2, "::") == 0)
+                    separator = 2;
+                else if (m_Position < m_Source.size() && m_Source[m_Position] == '.')
+                    separator = 1;
+                if (separator == 0 || m_Position + separator >= m_Source.size() || !IsIdentifierStart(m_Source[m_Position + separator]))
+                    break;
+                m_Position += separator;
+            }
+            m_Token.Kind = TokenKind::Identifier;
+            m_Token.Text = m_Source.substr(start, m_Position - start);
+            return;
+        }
+        if (character == '(' || character == ')' || character == ',')
+        {
+            ++m_Position;
+            m_Token.Kind = character == '(' ? TokenKind::LeftParen : character == ')' ? TokenKind::RightParen : TokenKind::Comma;
+            m_Token.Text = std::string(1, character);
+            return;
+        }
+        static const char *const twoCharacterOperators[] = {"&&", "||", "==", "!=", "<=", ">=", "**"};
+        for (const char *candidate : twoCharacterOperators)
+            if (m_Source.compare(m_Position, 2, candidate) == 0)
+            {
+                m_Position += 2;
+                m_Token.Kind = TokenKind::Operator;
+                m_Token.Text = candidate;
+                return;
+            }
+        if (std::string("+-*/%^<>!").find(character) != std::string::npos)
+        {
+            ++m_Position;
+            m_Token.Kind = TokenKind::Operator;
+            m_Token.Text = std::string(1, character);
+            return;
+        }
+        Fail(std::string("unsupported character '") + character + "'");
+    }
+
+    struct InfixOperator
+    {
+        OpCode Op;
+        int Precedence;
+    };
+
+    static std::optional<InfixOperator> Infix(const Token &token)
+    {
+        if (token.Kind != TokenKind::Operator) return std::nullopt;
+        static const std::map<std::string, InfixOperator> operators{
+            {"||", {OpCode::Or, 1}},          {"&&", {OpCode::And, 2}},         {"==", {OpCode::Equal, 3}},
+            {"!=", {OpCode::NotEqual, 3}},    {"<", {OpCode::Less, 4}},         {"<=", {OpCode::LessEqual, 4}},
+            {">", {OpCode::Greater, 4}},      {">=", {OpCode::GreaterEqual, 4}}, {"+", {OpCode::Add, 5}},
+            {"-", {OpCode::Subtract, 5}},     {"*", {OpCode::Multiply, 6}},     {"/", {OpCode::Divide, 6}},
+            {"%", {OpCode::Modulo, 6}},       {"^", {OpCode::Power, 8}},        {"**", {OpCode::Power, 8}},
+        };
+        const auto found = operators.find(token.Text);
+        if (found == operators.end()) return std::nullopt;
+        return found->second;
+    }
+
+    static constexpr int UNARY_PRECEDENCE = 7;
+
+    // Pratt loop: operators bind while their precedence exceeds minimum. Chained comparisons and powers are rejected
+    // rather than guessing at TTreeFormula's associativity for them.
+    void ParseExpression(int minimum)
+    {
+        ParsePrefix();
+        while (const auto infix = Infix(m_Token))
+        {
+            if (infix->Precedence <= minimum) break;
+            Advance();
+            ParseExpression(infix->Precedence);
+            Emit(infix->Op);
+            const auto next = Infix(m_Token);
+            if (next && next->Precedence == infix->Precedence && (infix->Precedence == 3 || infix->Precedence == 4 || infix->Precedence == 8))
+                Fail("ambiguous chained '" + m_Token.Text + "'");
+        }
+    }
+
+    void ParsePrefix()
+    {
+        const Token token = m_Token;
+        switch (token.Kind)
+        {
+        case TokenKind::Number:
+            Advance();
+            EmitConstant(token.Value);
+            return;
+        case TokenKind::LeftParen:
+            Advance();
+            ParseExpression(0);
+            if (m_Token.Kind != TokenKind::RightParen) Fail("missing ')'");
+            Advance();
+            return;
+        case TokenKind::Operator:
+            if (token.Text == "-" || token.Text == "+" || token.Text == "!")
+            {
+                Advance();
+                ParseExpression(UNARY_PRECEDENCE);
+                if (token.Text == "-") Emit(OpCode::Negate);
+                if (token.Text == "!") Emit(OpCode::Not);
+                return;
+            }
+            Fail("unexpected '" + token.Text + "'");
+        case TokenKind::Identifier:
+            Advance();
+            if (m_Token.Kind == TokenKind::LeftParen)
+                ParseCall(token.Text);
+            else
+                EmitInput(token.Text);
+            return;
+        default:
+            Fail(token.Kind == TokenKind::End ? "unexpected end of expression" : "unexpected '" + token.Text + "'");
+        }
+    }
+
+    void ParseCall(const std::string &name)
+    {
+        Advance();
+        if (name == "TMath::Pi" && m_Token.Kind == TokenKind::RightParen)
+        {
+            Advance();
+            EmitConstant(M_PI);
+            return;
+        }
+        const auto function = Functions().find(name);
+        if (function == Functions().end()) Fail("unsupported function '" + name + "'");
+        for (std::size_t argument = 0; argument < function->second.Arity; ++argument)
+        {
+            if (argument > 0)
+            {
+                if (m_Token.Kind != TokenKind::Comma) Fail("'" + name + "' expects " + std::to_string(function->second.Arity) + " arguments");
+                Advance();
+            }
+            ParseExpression(0);
+        }
+        if (m_Token.Kind != TokenKind::RightParen) Fail("'" + name + "' expects " + std::to_string(function->second.Arity) + " arguments");
+        Advance();
+        Emit(function->second.Op);
+    }
+
+    void Push()
+    {
+        if (++m_Depth > CompiledExpression::MAX_STACK_DEPTH) Fail("expression is nested too deeply");
+        m_Target.m_StackDepth = std::max(m_Target.m_StackDepth, m_Depth);
+    }
+
+    void EmitConstant(double value)
+    {
+        Push();
+        m_Target.m_Code.push_back({OpCode::Constant, static_cast<std::uint32_t>(m_Target.m_Constants.size())});
+        m_Target.m_Constants.push_back(value);
+    }
+
+    void EmitInput(const std::string &name)
+    {
+        const std::optional<ValueHandle> handle = m_Resolve ? m_Resolve(name) : std::nullopt;
+        if (!handle || !handle->IsValid()) Fail("unknown name '" + name + "'");
+        auto &inputs = m_Target.m_Inputs;
+        const auto existing =
+            std::find_if(inputs.begin(), inputs.end(), [&](const ValueHandle &input) { return input.Data() == handle->Data(); });
+        const auto index = static_cast<std::uint32_t>(existing - inputs.begin());
+        if (existing == inputs.end()) inputs.push_back(*handle);
+        Push();
+        m_Target.m_Code.push_back({OpCode::Input, index});
+    }
+
+    // Operations whose operands are all constants are folded immediately; in postfix order those operands are
+    // exactly the trailing Constant instructions.
+    void Emit(OpCode op)
+    {
+        auto &code = m_Target.m_Code;
+        auto &constants = m_Target.m_Constants;
+        const std::size_t arity = Arity(op);
+        m_Depth -= arity - 1;
+        const bool foldable = code.size() >= arity && std::all_of(code.end() - static_cast<std::ptrdiff_t>(arity), code.end(),
+                                                                   [](const auto &instruction) { return instruction.Op == OpCode::Constant; });
+        if (!foldable)
+        {
+            code.push_back({op, 0});
+            return;
+        }
+        const double lhs = constants[code[code.size() - arity].Index];
+        const double value = arity == 1 ? ApplyUnary(op, lhs) : ApplyBinary(op, lhs, constants[code.back().Index]);
+        code.resize(code.size() - arity);
+        constants.resize(constants.size() - arity);
+        code.push_back({OpCode::Constant, static_cast<std::uint32_t>(constants.size())});
+        constants.push_back(value);
+    }
+};
+
+CompiledExpression CompiledExpression::Compile(const std::string &expression, const Resolver &resolve)
+{
+    CompiledExpression compiled;
+    compiled.m_Source = expression;
+    ExpressionParser(compiled.m_Source, resolve, compiled).Parse();
+    return compiled;
+}
+
+double CompiledExpression::Evaluate() const
+{
+    double stack[MAX_STACK_DEPTH];
+    std::size_t top = 0;
+    for (const Instruction &instruction : m_Code)
+    {
+        switch (instruction.Op)
+        {
+        case OpCode::Constant:
+            stack[top++] = m_Constants[instruction.Index];
+            break;
+        case OpCode::Input:
+            stack[top++] = m_Inputs[instruction.Index].Get();
+            break;
+        default:
+            if (Arity(instruction.Op) == 1)
+                stack[top - 1] = ApplyUnary(instruction.Op, stack[top - 1]);
+            else
+            {
+                --top;
+                stack[top - 1] = ApplyBinary(instruction.Op, stack[top - 1], stack[top]);
+            }
+        }
+    }
+    return top ? stack[0] : 0.0;
+}
+
+void CompiledExpression::EvaluateBlock(const std::vector<const double *> &columns, std::size_t size, double *out) const
+{
+    if (columns.size() != m_Inputs.size()) throw std::invalid_argument("CompiledExpression: block columns do not match the expression inputs.");
+    if (size == 0 || m_Code.empty()) return;
+    std::vector<double> scratch(m_StackDepth * size);
+    std::size_t top = 0;
+    const auto slot = [&](std::size_t index) { return scratch.data() + index * size; };
+    for (const Instruction &instruction : m_Code)
+    {
+        switch (instruction.Op)
+        {
+        case OpCode::Constant:
+            std::fill_n(slot(top++), size, m_Constants[instruction.Index]);
+            break;
+        case OpCode::Input:
+            std::copy_n(columns[instruction.Index], size, slot(top++));
+            break;
+        default:
+            if (Arity(instruction.Op) == 1)
+            {
+                double *values = slot(top - 1);
+                for (std::size_t index = 0; index < size; ++index)
+                    values[index] = ApplyUnary(instruction.Op, values[index]);
+            }
+            else
+            {
+                --top;
+                ApplyBinaryBlock(instruction.Op, slot(top - 1), slot(top), size);
+            }
+        }
+    }
+    std::copy_n(slot(0), size, out);
+}
@@ -0,0 +1,87 @@
+#pragma once
+#include "BranchValue.hh"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
+#include <vector>
+
+// Stack bytecode for the arithmetic, comparison, and logical subset of the tree-expression grammar, bound directly to
+// branch buffers. Compile() throws std::invalid_argument for anything outside that subset (array subscripts, strings,
+// bitwise operators, unknown names, ...) so callers can fall back to TTreeFormula with unchanged semantics.
+class CompiledExpression
+{
+  public:
+    using Resolver = std::function<std::optional<ValueHandle>(const std::string &name)>;
+
+    static constexpr std::size_t MAX_STACK_DEPTH = 64;
+
+    CompiledExpression() = default;
+    static CompiledExpression Compile(const std::string &expression, const Resolver &resolve);
+
+    bool IsValid() const { return !m_Code.empty(); }
+    const std::string &Source() const { return m_Source; }
+    const std::vector<ValueHandle> &Inputs() const { return m_Inputs; }
+
+    // Evaluates against the current contents of the bound buffers.
+    double Evaluate() const;
+    // Evaluates size events at once. columns[i] holds size values of Inputs()[i]; results go to out.
+    void EvaluateBlock(const std::vector<const double *> &columns, std::size_t size, double *out) const;
+
+    enum class OpCode : std::uint8_t
+    {
+        Constant,
+        Input,
+        Negate,
+        Not,
+        Add,
+        Subtract,
+        Multiply,
+        Divide,
+        Modulo,
+        Power,
+        Less,
+        LessEqual,
+        Greater,
+        GreaterEqual,
+        Equal,
+        NotEqual,
+        And,
+        Or,
+        Abs,
+        Sqrt,
+        Exp,
+        Log,
+        Log10,
+        Sin,
+        Cos,
+        Tan,
+        ASin,
+        ACos,
+        ATan,
+        SinH,
+        CosH,
+        TanH,
+        Floor,
+        Ceil,
+        ATan2,
+        Min,
+        Max,
+        FMod
+    };
+    struct Instruction
+    {
+        OpCode Op;
+        std::uint32_t Index = 0;
+    };
+
+  private:
+    friend class ExpressionParser;
+
+    std::string m_Source;
+    std::vector<Instruction> m_Code;
+    std::vector<double> m_Constants;
+    std::vector<ValueHandle> m_Inputs;
+    std::size_t m_StackDepth = 0;
+};
@@ -1,4 +1,5 @@
 #pragma once
+#include <ROOT/RDataFrame.hxx>
 #include <functional>
 #include <map>
 #include <memory>
@@ -22,6 +23,7 @@ template <typename T> class LambdaHolder : public LambdaBase
     LambdaHolder(T func, std::vector<std::string> columns) : m_Func(std::move(func)), m_Columns(std::move(columns)) {}
 
     T Get() const { return m_Func; }
+    const T &Ref() const { return m_Func; }
     std::vector<std::string> GetColumns() const override { return m_Columns; }
     std::type_index GetType() const override { return std::type_index(typeid(T)); }
 
@@ -30,9 +32,55 @@ template <typename T> class LambdaHolder : public LambdaBase
     std::vector<std::string> m_Columns;
 };
 
+// A compiled RDF filter or define. Apply builds the node through the typed RDataFrame overload captured at registration,
+// so applying it by name never goes through the interpreter.
+struct RdfLambda
+{
+    enum class Kind
+    {
+        Filter,
+        Define
+    };
+    Kind Type;
+    std::function<ROOT::RDF::RNode(ROOT::RDF::RNode, const std::string &)> Apply;
+};
+
 class LambdaManager
 {
   public:
+    // Process-wide library shared by every manager. Plugins register their standard selections here from
+    // CascadeRegisterPlugin; registration is not synchronized, so it must finish before graphs are built.
+    static LambdaManager &Library()
+    {
+        static LambdaManager library;
+        return library;
+    }
+
+    // Registers a typed callable as a filter. Applying it calls node.Filter(func, columns, cutName).
+    template <typename F> void RegisterFilter(const std::string &name, F func, std::vector<std::string> columns)
+    {
+        RdfLambda lambda{RdfLambda::Kind::Filter, [func = std::move(func), columns](ROOT::RDF::RNode node, const std::string &label)
+                         { return ROOT::RDF::RNode(node.Filter(func, columns, label)); }};
+        Register<RdfLambda>(name, std::move(lambda), std::move(columns));
+    }
+
+    // Registers a typed callable as a define. Applying it calls node.Define(columnName, func, columns).
+    template <typename F> void RegisterDefine(const std::string &name, F func, std::vector<std::string> columns)
+    {
+        RdfLambda lambda{RdfLambda::Kind::Define, [func = std::move(func), columns](ROOT::RDF::RNode node, const std::string &label)
+                         { return ROOT::RDF::RNode(node.Define(label, func, columns)); }};
+        Register<RdfLambda>(name, std::move(lambda), std::move(columns));
+    }
+
+    // Returns the compiled RDF lambda of the given kind, or nullptr when the name is unknown or registered as another kind.
+    const RdfLambda *FindRdfLambda(const std::string &name, RdfLambda::Kind kind) const
+    {
+        auto it = m_Lambdas.find(name);
+        if (it == m_Lambdas.end() || it->second->GetType() != std::type_index(typeid(RdfLambda))) return nullptr;
+        const RdfLambda &lambda = std::static_pointer_cast<LambdaHolder<RdfLambda>>(it->second)->Ref();
+        return lambda.Type == kind ? &lambda : nullptr;
+    }
+
     template <typename T> void Register(const std::string &name, T func, std::vector<std::string> columns)
     {
         if (m_Lambdas.count(name))
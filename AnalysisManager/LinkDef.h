@@ -1,7 +1,14 @@
 #ifdef __CLING__
 #pragma link C++ class LambdaManager+;
 #pragma link C++ enum TreeOpt::Om;
+#pragma link C++ enum DataFormat;
 #pragma link C++ enum ResourceOwnership;
+#pragma link C++ enum BranchValueType;
 #pragma link C++ class ConfigValidationResult+;
+#pragma link C++ enum HistogramKind;
+#pragma link C++ class HistogramAxis+;
+#pragma link C++ class HistogramSpec+;
+#pragma link C++ class SystematicVariation+;
+#pragma link C++ class OutputSettings+;
 #pragma link C++ class AnalysisManager+;
 #endif
@@ -43,7 +43,8 @@ class AMCM
     std::vector<RunResult> RunModules(const std::vector<std::string> &group, bool failFast = true);
     std::vector<RunResult> RunModules(std::vector<std::shared_ptr<IAnalysisModule>> group, bool failFast = true);
     DAGManager &GetDAGManager() { return *m_Dag; }
-    void AddModuleToDAG(const std::string &name, const std::vector<std::string> &dependencies, bool isolated = false);
+    void AddModuleToDAG(const std::string &name, const std::vector<std::string> &dependencies, bool isolated = false,
+                        const DAGNodeResources &resources = {});
     void LinkDAGModuleParameter(const std::string &fromNode, const std::string &fromKey, const std::string &toNode,
                                 const std::string &toKey);
     DAGRunResult RunDAG(bool failFast = true);
@@ -1,7 +1,10 @@
 #pragma once
+#include <cstddef>
 #include <functional>
 #include <map>
+#include <memory>
 #include <mutex>
+#include <optional>
 #include <stdexcept>
 #include <string>
 #include <vector>
@@ -64,6 +67,17 @@ struct DAGRunResult
     bool Failed() const;
 };
 
+// What a node needs from the machine while it runs. Execute packs running nodes so their threads stay within
+// CASCADE_DAG_MAX_WORKERS and their memory within CASCADE_DAG_MEMORY_MB; a node asking for more than a budget runs
+// with the whole budget to itself.
+struct DAGNodeResources
+{
+    // Cores the node keeps busy; 0 for a node with no work of its own, such as one served from the cache.
+    unsigned int Threads = 1;
+    // Peak resident memory in MiB; 0 when not declared.
+    std::size_t MemoryMB = 0;
+};
+
 struct DAGDataLinkInfo
 {
     std::string FromNode;
@@ -71,6 +85,8 @@ struct DAGDataLinkInfo
     std::string Label;
 };
 
+class DAGWorkerPool;
+
 class DAGManager
 {
   public:
@@ -85,11 +101,21 @@ class DAGManager
         DAGExecutionLane Lane = DAGExecutionLane::Serial;
         DAGNodeStatus Status = DAGNodeStatus::Pending;
         std::string Message;
+        std::optional<double> ExpectedSeconds;
+        DAGNodeResources Resources;
     };
 
+    DAGManager();
+    ~DAGManager();
+
     void AddNode(const std::string &name, const std::vector<std::string> &dependencies, Task task,
                  DAGExecutionLane lane = DAGExecutionLane::Serial);
     void AddDataLink(const std::string &fromNode, const std::string &toNode, const std::string &label, DataTransfer transfer);
+    // When more nodes are ready than workers are free, Execute starts the one with the longest expected path to the end
+    // of the DAG first. Nodes without an expected duration count as the mean of the known ones; with none known, ready
+    // nodes start in topological order.
+    void SetExpectedDuration(const std::string &name, double seconds);
+    void SetNodeResources(const std::string &name, const DAGNodeResources &resources);
     void Validate() const;
     DAGRunResult Execute(bool failFast = true);
     void Reset();
@@ -114,6 +140,8 @@ class DAGManager
         DataTransfer Transfer;
     };
     std::vector<DataLink> m_DataLinks;
+    // Worker threads for Root, Parallel, and Isolated nodes, kept across Execute calls.
+    std::unique_ptr<DAGWorkerPool> m_Pool;
 
     void Validate_() const;
     std::vector<std::string> TopologicalOrder_() const;
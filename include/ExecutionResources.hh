@@ -1,9 +1,33 @@
 #pragma once
 
 #include <mutex>
+#include <thread>
 
 inline std::recursive_mutex &CascadeRootExecutionMutex()
 {
     static std::recursive_mutex mutex;
     return mutex;
 }
+
+// Threads the DAG scheduler granted to the node running on this thread; 0 outside a DAG node.
+inline unsigned int &CascadeNodeThreads()
+{
+    thread_local unsigned int threads = 0;
+    return threads;
+}
+
+// Whether the DAG node running on this thread is in the Parallel lane, beside other running nodes that share ROOT's
+// process-wide state. Such a node must not change that state; false outside a DAG node.
+inline bool &CascadeParallelNode()
+{
+    thread_local bool parallel = false;
+    return parallel;
+}
+
+// Threads the current work may keep busy: the running DAG node's grant, otherwise the hardware concurrency.
+inline unsigned int CascadeThreadBudget()
+{
+    if (const unsigned int granted = CascadeNodeThreads()) return granted;
+    const unsigned int detected = std::thread::hardware_concurrency();
+    return detected == 0 ? 1 : detected;
+}
@@ -6,6 +6,7 @@
 
 #include <cstdint>
 #include <filesystem>
+#include <map>
 #include <optional>
 #include <string>
 #include <utility>
@@ -63,6 +64,7 @@ struct ModuleRunManifest
     std::string Message;
     std::vector<ArtifactProvenance> Inputs;
     std::vector<ArtifactProvenance> Outputs;
+    std::string AnalysisJson;
     std::string ManifestPath;
 
     std::string ToJSON(int indent = 2) const;
@@ -128,6 +130,12 @@ class ProvenanceRecorder
     static void DiscardModuleRun(const std::string &runId);
     static std::optional<ModuleRunManifest> FindModuleRun(const std::string &runId);
     static std::optional<ModuleRunManifest> FindLastModuleRun(const std::string &instanceName);
+    // Wall time of a Done or Skipped run, from its recorded timing.
+    static std::optional<double> ModuleRunSeconds(const ModuleRunManifest &manifest);
+    // Newest recorded duration per DAG node across the latest workflow manifests in a directory (the default workflow
+    // manifest directory when empty). Unreadable manifests are ignored; the result only guides scheduling.
+    static std::map<std::string, double> HistoricalNodeSeconds(const std::filesystem::path &directory = {},
+                                                               std::size_t maxWorkflows = 20);
 
     static std::string SuccessfulModuleManifestPath(const std::filesystem::path &outputDirectory,
                                                     const std::string &runId);
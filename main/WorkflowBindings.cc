@@ -116,12 +116,14 @@ void BindWorkflow(py::module_ &m)
              py::arg("group"), py::arg("fail_fast") = true)
         .def("get_dag", &AMCM::GetDAGManager, py::return_value_policy::reference_internal)
         .def("add_module_to_dag",
-             [](AMCM &self, const std::string &name, const std::vector<std::string> &dependencies, bool isolated)
+             [](AMCM &self, const std::string &name, const std::vector<std::string> &dependencies, bool isolated,
+                unsigned int threads, std::size_t memoryMB)
              {
                  py::gil_scoped_release release;
-                 self.AddModuleToDAG(name, dependencies, isolated);
+                 self.AddModuleToDAG(name, dependencies, isolated, {threads, memoryMB});
              },
-             py::arg("name"), py::arg("dependencies") = std::vector<std::string>{}, py::arg("isolated") = false)
+             py::arg("name"), py::arg("dependencies") = std::vector<std::string>{}, py::arg("isolated") = false,
+             py::arg("threads") = 1, py::arg("memory_mb") = 0)
         .def("link_dag_module_parameter",
              [](AMCM &self, const std::string &fromNode, const std::string &fromKey, const std::string &toNode,
                 const std::string &toKey)
@@ -259,6 +261,20 @@ void BindWorkflow(py::module_ &m)
                  py::gil_scoped_release release;
                  dag.AddDataLink(fromNode, toNode, label, std::move(transfer));
              })
+        .def("set_expected_duration",
+             [](DAGManager &dag, const std::string &name, double seconds)
+             {
+                 py::gil_scoped_release release;
+                 dag.SetExpectedDuration(name, seconds);
+             },
+             py::arg("name"), py::arg("seconds"))
+        .def("set_node_resources",
+             [](DAGManager &dag, const std::string &name, unsigned int threads, std::size_t memoryMB)
+             {
+                 py::gil_scoped_release release;
+                 dag.SetNodeResources(name, {threads, memoryMB});
+             },
+             py::arg("name"), py::arg("threads") = 1, py::arg("memory_mb") = 0)
         .def("validate",
              [](const DAGManager &dag)
              {
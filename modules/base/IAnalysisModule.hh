@@ -87,6 +87,7 @@ class IAnalysisModule
     virtual std::string RuntimeLanguage() const { return "cpp"; }
     virtual void ConfigureProvenance();
     virtual std::string AnalysisSnapshotState() const;
+    virtual std::string AnalysisRunStatistics() const;
 
     ParamManager &Parameters();
     const ParamManager &Parameters() const;
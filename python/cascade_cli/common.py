@@ -91,6 +91,7 @@ def _runtime_environment(args):
         "input_hash": "CASCADE_INPUT_HASH_MODE",
         "output_hash": "CASCADE_PROVENANCE_HASH_MODE",
         "workers": "CASCADE_DAG_MAX_WORKERS",
+        "memory_mb": "CASCADE_DAG_MEMORY_MB",
         "timeout": "CASCADE_ISOLATED_TIMEOUT_SECONDS",
         "progress_interval_ms": "CASCADE_PROGRESS_INTERVAL_MS",
     }
@@ -110,6 +110,8 @@ def _configure_dag_workflow(args):
         "name",
         "dependencies",
         "isolated",
+        "threads",
+        "memory_mb",
         "params",
         "param_file",
         "output_directory",
@@ -141,11 +143,19 @@ def _configure_dag_workflow(args):
         isolated = item.get("isolated", False)
         if not isinstance(isolated, bool):
             raise TypeError(f"workflow.modules[{index}].isolated must be a boolean")
+        resources = {}
+        for key, default in (("threads", 1), ("memory_mb", 0)):
+            value = item.get(key, default)
+            if isinstance(value, bool) or not isinstance(value, int) or value < 0:
+                raise TypeError(f"workflow.modules[{index}].{key} must be a non-negative integer")
+            resources[key] = value
         configured.append({
             "class_name": class_name,
             "name": name,
             "dependencies": dependencies,
             "isolated": isolated,
+            "threads": resources["threads"],
+            "memory_mb": resources["memory_mb"],
             "params": params,
             "param_file": item.get("param_file"),
             "output_directory": item.get("output_directory"),
@@ -180,7 +190,13 @@ def _configure_dag_workflow(args):
         _apply_parameters(handle, item["params"])
 
     for item in configured:
-        controller.add_module_to_dag(item["name"], item["dependencies"], isolated=item["isolated"])
+        controller.add_module_to_dag(
+            item["name"],
+            item["dependencies"],
+            isolated=item["isolated"],
+            threads=item["threads"],
+            memory_mb=item["memory_mb"],
+        )
 
     for link in configured_links:
         controller.link_dag_parameter(
@@ -37,6 +37,7 @@ def _add_runtime_options(parser, include_workers=False):
     parser.add_argument("--progress-interval-ms", type=_non_negative_int, help="Analysis progress render interval")
     if include_workers:
         parser.add_argument("--workers", type=_positive_int, help="Maximum concurrent DAG workers")
+        parser.add_argument("--memory-mb", type=_positive_int, help="Memory budget of concurrent DAG nodes in MiB")
 
 
 def build_parser() -> argparse.ArgumentParser:
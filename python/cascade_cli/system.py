@@ -136,6 +136,7 @@ def cmd_doctor_runtime(args) -> None:
         "input_hash": os.environ.get("CASCADE_INPUT_HASH_MODE", "metadata"),
         "output_hash": os.environ.get("CASCADE_PROVENANCE_HASH_MODE", "full"),
         "dag_workers": os.environ.get("CASCADE_DAG_MAX_WORKERS", str(os.cpu_count() or 1)),
+        "dag_memory_mb": os.environ.get("CASCADE_DAG_MEMORY_MB", "unlimited"),
         "progress_interval_ms": os.environ.get("CASCADE_PROGRESS_INTERVAL_MS", "200"),
         "isolated_timeout_seconds": os.environ.get("CASCADE_ISOLATED_TIMEOUT_SECONDS", "0"),
     }
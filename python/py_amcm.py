@@ -435,8 +435,8 @@ class py_amcm:
     def get_dag(self):
         return self.ctrl.get_dag()
 
-    def add_module_to_dag(self, name, dependencies=None, isolated=False):
-        self.ctrl.add_module_to_dag(name, list(dependencies or []), bool(isolated))
+    def add_module_to_dag(self, name, dependencies=None, isolated=False, threads=1, memory_mb=0):
+        self.ctrl.add_module_to_dag(name, list(dependencies or []), bool(isolated), int(threads), int(memory_mb))
 
     def link_dag_parameter(self, from_node, from_key, to_node, to_key):
         self.ctrl.link_dag_module_parameter(from_node, from_key, to_node, to_key)
@@ -589,6 +589,7 @@ RunResult AMCM::RunAModuleIsolated(std::shared_ptr<IAnalysisModule> module)
         {"manifest_path", origin->ManifestPath},
         {"manifest_sha256", origin->ManifestSha256},
         {"artifact_sha256", origin->ArtifactSha256},
+        {"threads", CascadeNodeThreads()},
     };
     const std::string payload = request.dump();
 
@@ -780,7 +781,8 @@ std::vector<RunResult> AMCM::RunModules(std::vector<std::shared_ptr<IAnalysisMod
     return results;
 }
 
-void AMCM::AddModuleToDAG(const std::string &name, const std::vector<std::string> &dependencies, bool isolated)
+void AMCM::AddModuleToDAG(const std::string &name, const std::vector<std::string> &dependencies, bool isolated,
+                          const DAGNodeResources &resources)
 {
     const auto module = RegisteredModule_(name);
     DAGExecutionLane lane = DAGExecutionLane::Parallel;
@@ -798,6 +800,7 @@ void AMCM::AddModuleToDAG(const std::string &name, const std::vector<std::string
                                          (result.Message.empty() ? std::string() : ": " + result.Message));
         },
         lane);
+    m_Dag->SetNodeResources(name, resources);
 }
 
 void AMCM::LinkDAGModuleParameter(const std::string &fromNode, const std::string &fromKey, const std::string &toNode,
@@ -820,6 +823,20 @@ DAGRunResult AMCM::RunDAG(bool failFast)
         std::lock_guard<std::mutex> controlLock(m_ControlMutex);
         m_ExecutedModules.clear();
     }
+    // Durations from this process win over those recorded by earlier workflows; history is read only when needed.
+    std::optional<std::map<std::string, double>> history;
+    for (const auto &name : m_Dag->GetNodeNames())
+    {
+        std::optional<double> seconds;
+        if (const auto last = ProvenanceRecorder::FindLastModuleRun(name)) seconds = ProvenanceRecorder::ModuleRunSeconds(*last);
+        if (!seconds)
+        {
+            if (!history) history = ProvenanceRecorder::HistoricalNodeSeconds();
+            const auto recorded = history->find(name);
+            if (recorded != history->end()) seconds = recorded->second;
+        }
+        if (seconds) m_Dag->SetExpectedDuration(name, *seconds);
+    }
     LOG_INFO("CONTROL", "Executing DAG workflow");
     auto result = m_Dag->Execute(failFast);
     LOG_INFO("CONTROL", "DAG workflow execution completed");
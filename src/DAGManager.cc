@@ -4,15 +4,18 @@
 #include <algorithm>
 #include <atomic>
 #include <cerrno>
+#include <cmath>
 #include <condition_variable>
 #include <cstdlib>
 #include <deque>
 #include <fstream>
 #include <memory>
+#include <queue>
 #include <set>
 #include <sstream>
 #include <thread>
 #include <unordered_map>
+#include <utility>
 
 namespace
 {
@@ -31,79 +34,164 @@ std::string EscapeDot(std::string value)
     return escaped;
 }
 
+std::optional<std::size_t> PositiveEnvironmentValue(const char *variable)
+{
+    const char *configured = std::getenv(variable);
+    if (!configured || !*configured) return std::nullopt;
+    if (*configured == '-') throw std::runtime_error(std::string(variable) + " must be a positive integer");
+    char *end = nullptr;
+    errno = 0;
+    const unsigned long value = std::strtoul(configured, &end, 10);
+    if (errno != 0 || end == configured || *end != '\0' || value == 0)
+        throw std::runtime_error(std::string(variable) + " must be a positive integer");
+    return static_cast<std::size_t>(value);
+}
+
 std::size_t DagWorkerCount()
 {
-    const char *configured = std::getenv("CASCADE_DAG_MAX_WORKERS");
-    if (configured && *configured)
-    {
-        if (*configured == '-') throw std::runtime_error("CASCADE_DAG_MAX_WORKERS must be a positive integer");
-        char *end = nullptr;
-        errno = 0;
-        const unsigned long value = std::strtoul(configured, &end, 10);
-        if (errno != 0 || end == configured || *end != '\0' || value == 0)
-            throw std::runtime_error("CASCADE_DAG_MAX_WORKERS must be a positive integer");
-        return static_cast<std::size_t>(value);
-    }
+    if (const auto configured = PositiveEnvironmentValue("CASCADE_DAG_MAX_WORKERS")) return *configured;
     const unsigned int detected = std::thread::hardware_concurrency();
     return detected == 0 ? 1 : static_cast<std::size_t>(detected);
 }
 
-class TaskPool
+// Memory the running nodes may declare together, in MiB; 0 leaves memory unaccounted.
+std::size_t DagMemoryBudgetMB() { return PositiveEnvironmentValue("CASCADE_DAG_MEMORY_MB").value_or(0); }
+
+class ScopedNodeThreads
 {
   public:
-    explicit TaskPool(std::size_t size)
+    ScopedNodeThreads(unsigned int threads, bool parallel)
+        : m_Previous(std::exchange(CascadeNodeThreads(), threads)), m_PreviousParallel(std::exchange(CascadeParallelNode(), parallel))
+    {
+    }
+    ~ScopedNodeThreads()
     {
-        m_Threads.reserve(size);
+        CascadeNodeThreads() = m_Previous;
+        CascadeParallelNode() = m_PreviousParallel;
+    }
+    ScopedNodeThreads(const ScopedNodeThreads &) = delete;
+    ScopedNodeThreads &operator=(const ScopedNodeThreads &) = delete;
+
+  private:
+    unsigned int m_Previous;
+    bool m_PreviousParallel;
+};
+
+} // namespace
+
+// Each worker owns a deque and takes from its front; a worker whose deque is empty steals from the back of the others
+// before sleeping. A task submitted by a worker goes to that worker's deque, others are spread round-robin.
+class DAGWorkerPool
+{
+  public:
+    explicit DAGWorkerPool(std::size_t size)
+    {
+        m_Workers.reserve(size);
         for (std::size_t index = 0; index < size; ++index)
-            m_Threads.emplace_back(
-                [this]()
-                {
-                    while (true)
-                    {
-                        std::function<void()> task;
-                        {
-                            std::unique_lock<std::mutex> lock(m_Mutex);
-                            m_Ready.wait(lock, [&]() { return m_Stopping || !m_Tasks.empty(); });
-                            if (m_Stopping && m_Tasks.empty()) return;
-                            task = std::move(m_Tasks.front());
-                            m_Tasks.pop_front();
-                        }
-                        task();
-                    }
-                });
+            m_Workers.push_back(std::make_unique<Worker>());
+        for (std::size_t index = 0; index < size; ++index)
+            m_Workers[index]->Thread = std::thread([this, index]() { Run_(index); });
     }
 
-    ~TaskPool()
+    ~DAGWorkerPool()
     {
         {
-            std::lock_guard<std::mutex> lock(m_Mutex);
+            std::lock_guard<std::mutex> lock(m_SleepMutex);
             m_Stopping = true;
         }
-        m_Ready.notify_all();
-        for (auto &thread : m_Threads)
-            thread.join();
+        m_Wake.notify_all();
+        for (auto &worker : m_Workers)
+            worker->Thread.join();
     }
 
-    TaskPool(const TaskPool &) = delete;
-    TaskPool &operator=(const TaskPool &) = delete;
+    DAGWorkerPool(const DAGWorkerPool &) = delete;
+    DAGWorkerPool &operator=(const DAGWorkerPool &) = delete;
+
+    std::size_t Size() const { return m_Workers.size(); }
 
     void Submit(std::function<void()> task)
     {
+        const std::size_t target = t_Pool == this ? t_Worker : m_Next.fetch_add(1, std::memory_order_relaxed) % m_Workers.size();
+        Worker &worker = *m_Workers[target];
+        {
+            std::lock_guard<std::mutex> lock(worker.Mutex);
+            worker.Tasks.push_back(std::move(task));
+        }
+        // Paired with the sleeper count in Run_: either the sleeper sees the queued task or this sees the sleeper.
+        m_Queued.fetch_add(1);
+        if (m_Sleeping.load() > 0)
         {
-            std::lock_guard<std::mutex> lock(m_Mutex);
-            m_Tasks.push_back(std::move(task));
+            std::lock_guard<std::mutex> lock(m_SleepMutex);
+            m_Wake.notify_one();
         }
-        m_Ready.notify_one();
     }
 
   private:
-    std::mutex m_Mutex;
-    std::condition_variable m_Ready;
-    std::deque<std::function<void()>> m_Tasks;
-    std::vector<std::thread> m_Threads;
+    struct Worker
+    {
+        std::mutex Mutex;
+        std::deque<std::function<void()>> Tasks;
+        std::thread Thread;
+    };
+
+    static thread_local const DAGWorkerPool *t_Pool;
+    static thread_local std::size_t t_Worker;
+
+    std::vector<std::unique_ptr<Worker>> m_Workers;
+    std::atomic<std::size_t> m_Next{0};
+    std::atomic<std::size_t> m_Queued{0};
+    std::atomic<std::size_t> m_Sleeping{0};
+    std::mutex m_SleepMutex;
+    std::condition_variable m_Wake;
     bool m_Stopping = false;
+
+    bool TryTake_(std::size_t self, std::function<void()> &task)
+    {
+        for (std::size_t offset = 0; offset < m_Workers.size(); ++offset)
+        {
+            Worker &worker = *m_Workers[(self + offset) % m_Workers.size()];
+            std::lock_guard<std::mutex> lock(worker.Mutex);
+            if (worker.Tasks.empty()) continue;
+            if (offset == 0)
+            {
+                task = std::move(worker.Tasks.front());
+                worker.Tasks.pop_front();
+            }
+            else
+            {
+                task = std::move(worker.Tasks.back());
+                worker.Tasks.pop_back();
+            }
+            m_Queued.fetch_sub(1);
+            return true;
+        }
+        return false;
+    }
+
+    void Run_(std::size_t self)
+    {
+        t_Pool = this;
+        t_Worker = self;
+        std::function<void()> task;
+        while (true)
+        {
+            if (TryTake_(self, task))
+            {
+                task();
+                task = nullptr;
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(m_SleepMutex);
+            m_Sleeping.fetch_add(1);
+            m_Wake.wait(lock, [&]() { return m_Stopping || m_Queued.load() > 0; });
+            m_Sleeping.fetch_sub(1);
+            if (m_Stopping && m_Queued.load() == 0) return;
+        }
+    }
 };
-} // namespace
+
+thread_local const DAGWorkerPool *DAGWorkerPool::t_Pool = nullptr;
+thread_local std::size_t DAGWorkerPool::t_Worker = 0;
 
 bool DAGRunResult::Succeeded() const
 {
@@ -117,6 +205,10 @@ bool DAGRunResult::Failed() const
                        { return node.Status == DAGNodeStatus::Failed || node.Status == DAGNodeStatus::Blocked; });
 }
 
+DAGManager::DAGManager() = default;
+
+DAGManager::~DAGManager() = default;
+
 void DAGManager::AddNode(const std::string &name, const std::vector<std::string> &dependencies, Task task,
                          DAGExecutionLane lane)
 {
@@ -151,6 +243,25 @@ void DAGManager::AddDataLink(const std::string &fromNode, const std::string &toN
     m_DataLinks.push_back({fromNode, toNode, label, std::move(transfer)});
 }
 
+void DAGManager::SetExpectedDuration(const std::string &name, double seconds)
+{
+    std::lock_guard<std::recursive_mutex> lock(m_Mutex);
+    if (m_Executing) throw std::runtime_error("Cannot change a DAG node duration while the DAG is executing.");
+    if (!std::isfinite(seconds) || seconds < 0.0) throw std::invalid_argument("DAG node duration must be a non-negative number: " + name);
+    const auto node = m_Nodes.find(name);
+    if (node == m_Nodes.end()) throw std::runtime_error("DAG node does not exist: " + name);
+    node->second.ExpectedSeconds = seconds;
+}
+
+void DAGManager::SetNodeResources(const std::string &name, const DAGNodeResources &resources)
+{
+    std::lock_guard<std::recursive_mutex> lock(m_Mutex);
+    if (m_Executing) throw std::runtime_error("Cannot change DAG node resources while the DAG is executing.");
+    const auto node = m_Nodes.find(name);
+    if (node == m_Nodes.end()) throw std::runtime_error("DAG node does not exist: " + name);
+    node->second.Resources = resources;
+}
+
 void DAGManager::Validate() const
 {
     std::lock_guard<std::recursive_mutex> lock(m_Mutex);
@@ -159,61 +270,176 @@ void DAGManager::Validate() const
 
 DAGRunResult DAGManager::Execute(bool failFast)
 {
-    std::vector<std::string> order;
+    // Scheduling state is indexed by topological position. Each node counts the dependencies it still waits for and
+    // completions decrement the counts of their dependents, so dispatch never rescans the graph.
+    struct ScheduledNode
+    {
+        Node *Entry = nullptr;
+        std::vector<std::size_t> Dependents;
+        std::size_t Waiting = 0;
+        std::vector<std::pair<std::string, DataTransfer>> Transfers;
+        // Expected seconds from this node's start to the end of its longest chain of dependents.
+        double CriticalPath = 0.0;
+        // Share of the thread and memory budgets held while running, and the threads granted to the task.
+        std::size_t Threads = 0;
+        std::size_t MemoryMB = 0;
+        unsigned int GrantedThreads = 1;
+    };
+    std::vector<ScheduledNode> nodes;
+    // Ready nodes are ordered by their expected time to the end of the DAG, then by topological position.
+    const auto runsLater = [&nodes](std::size_t left, std::size_t right)
+    {
+        if (nodes[left].CriticalPath != nodes[right].CriticalPath) return nodes[left].CriticalPath < nodes[right].CriticalPath;
+        return left > right;
+    };
+    using ReadyQueue = std::priority_queue<std::size_t, std::vector<std::size_t>, decltype(runsLater)>;
+    ReadyQueue readyPooled(runsLater);
+    ReadyQueue readyRoot(runsLater);
+    ReadyQueue readySerial(runsLater);
+    std::size_t pending = 0;
+    std::size_t pooledNodeCount = 0;
+
+    const auto makeReady = [&](std::size_t index)
+    {
+        const DAGExecutionLane lane = nodes[index].Entry->Lane;
+        if (lane == DAGExecutionLane::Serial)
+            readySerial.push(index);
+        else if (lane == DAGExecutionLane::Root)
+            readyRoot.push(index);
+        else
+            readyPooled.push(index);
+    };
+    // Requires m_Mutex. failedNode names the node that failed; without fail-fast each blocked node names the
+    // dependency that blocked it, as the status of a dependency does.
+    const auto blockDescendants = [&](std::size_t failed, const std::string &failedNode)
+    {
+        std::vector<std::size_t> stack{failed};
+        while (!stack.empty())
+        {
+            const std::size_t current = stack.back();
+            stack.pop_back();
+            for (const std::size_t dependent : nodes[current].Dependents)
+            {
+                Node &node = *nodes[dependent].Entry;
+                if (node.Status != DAGNodeStatus::Pending) continue;
+                node.Status = DAGNodeStatus::Blocked;
+                node.Message = "Blocked by dependency: " + (failFast ? failedNode : nodes[current].Entry->Name);
+                --pending;
+                stack.push_back(dependent);
+            }
+        }
+    };
+
     const std::size_t maxWorkers = DagWorkerCount();
+    const std::size_t memoryBudget = DagMemoryBudgetMB();
     {
         std::lock_guard<std::recursive_mutex> lock(m_Mutex);
         if (m_Executing) throw std::runtime_error("DAG execution is already in progress.");
         Validate_();
-        order = TopologicalOrder_();
+        const std::vector<std::string> order = TopologicalOrder_();
+        std::unordered_map<std::string, std::size_t> positions;
+        positions.reserve(order.size());
+        nodes.resize(order.size());
+        for (std::size_t index = 0; index < order.size(); ++index)
+        {
+            positions.emplace(order[index], index);
+            nodes[index].Entry = &m_Nodes.at(order[index]);
+            if (nodes[index].Entry->Lane != DAGExecutionLane::Serial) ++pooledNodeCount;
+            const DAGNodeResources &resources = nodes[index].Entry->Resources;
+            nodes[index].Threads = std::min<std::size_t>(resources.Threads, maxWorkers);
+            nodes[index].MemoryMB = memoryBudget == 0 ? 0 : std::min(resources.MemoryMB, memoryBudget);
+            nodes[index].GrantedThreads = static_cast<unsigned int>(std::max<std::size_t>(nodes[index].Threads, 1));
+        }
+        for (const auto &link : m_DataLinks)
+            nodes[positions.at(link.ToNode)].Transfers.emplace_back(link.Label, link.Transfer);
+        for (std::size_t index = 0; index < nodes.size(); ++index)
+            for (const auto &dependency : nodes[index].Entry->Dependencies)
+                nodes[positions.at(dependency)].Dependents.push_back(index);
+
+        double knownSeconds = 0.0;
+        std::size_t knownCount = 0;
+        for (const auto &node : nodes)
+            if (node.Entry->ExpectedSeconds)
+            {
+                knownSeconds += *node.Entry->ExpectedSeconds;
+                ++knownCount;
+            }
+        const double unknownSeconds = knownCount == 0 ? 0.0 : knownSeconds / static_cast<double>(knownCount);
+        for (std::size_t index = nodes.size(); index-- > 0;)
+        {
+            double longestDependent = 0.0;
+            for (const std::size_t dependent : nodes[index].Dependents)
+                longestDependent = std::max(longestDependent, nodes[dependent].CriticalPath);
+            nodes[index].CriticalPath = nodes[index].Entry->ExpectedSeconds.value_or(unknownSeconds) + longestDependent;
+        }
+
+        // Dependencies that succeeded in an earlier run stay satisfied; failed or blocked ones block their dependents.
+        for (std::size_t index = 0; index < nodes.size(); ++index)
+        {
+            Node &node = *nodes[index].Entry;
+            if (node.Status != DAGNodeStatus::Pending) continue;
+            for (const auto &dependency : node.Dependencies)
+            {
+                const auto status = nodes[positions.at(dependency)].Entry->Status;
+                if (status == DAGNodeStatus::Failed || status == DAGNodeStatus::Blocked)
+                {
+                    node.Status = DAGNodeStatus::Blocked;
+                    node.Message = "Blocked by dependency: " + dependency;
+                    break;
+                }
+                if (status != DAGNodeStatus::Succeeded) ++nodes[index].Waiting;
+            }
+            if (node.Status != DAGNodeStatus::Pending) continue;
+            ++pending;
+            if (nodes[index].Waiting == 0) makeReady(index);
+        }
         m_Executing = true;
     }
+
+    // The scheduling state below is guarded by scheduleMutex. Workers complete their own nodes and dispatch the ones
+    // that become ready, so short pooled nodes never wait for this thread. This thread is the serial executor: it runs
+    // the serial node handed to it while the pool keeps working, and waits for the pool to drain. Pooled tasks refer to
+    // this frame, so every exit waits until none is active.
+    constexpr std::size_t noSerialNode = static_cast<std::size_t>(-1);
+    std::mutex scheduleMutex;
+    std::condition_variable wake;
+    std::size_t active = 0;
+    std::size_t usedThreads = 0;
+    std::size_t usedMemory = 0;
+    bool rootActive = false;
+    // Set from the moment a serial node is handed to this thread until it completes.
+    bool serialActive = false;
+    std::size_t serialNext = noSerialNode;
+    bool stopDispatch = false;
     try
     {
-        struct WorkItem
-        {
-            std::string Name;
-            Task Action;
-            std::vector<std::pair<std::string, DataTransfer>> Transfers;
-            DAGExecutionLane Lane = DAGExecutionLane::Serial;
-        };
-
-        std::size_t pooledNodeCount = 0;
+        const std::size_t neededWorkers = std::min(maxWorkers, pooledNodeCount);
+        if (neededWorkers > 0 && (!m_Pool || m_Pool->Size() < neededWorkers || m_Pool->Size() > maxWorkers))
         {
-            std::lock_guard<std::recursive_mutex> lock(m_Mutex);
-            pooledNodeCount = static_cast<std::size_t>(std::count_if(
-                m_Nodes.begin(), m_Nodes.end(), [](const auto &entry)
-                {
-                    return entry.second.Lane == DAGExecutionLane::Parallel ||
-                           entry.second.Lane == DAGExecutionLane::Isolated ||
-                           entry.second.Lane == DAGExecutionLane::Root;
-                }));
+            m_Pool.reset();
+            m_Pool = std::make_unique<DAGWorkerPool>(neededWorkers);
         }
-        std::unique_ptr<TaskPool> pool;
-        if (pooledNodeCount > 0) pool = std::make_unique<TaskPool>(std::min(maxWorkers, pooledNodeCount));
 
-        auto prepareWork = [&](const std::string &name)
+        const auto prepareWork = [&](std::size_t index)
         {
-            WorkItem work;
             std::lock_guard<std::recursive_mutex> lock(m_Mutex);
-            auto &node = m_Nodes.at(name);
+            Node &node = *nodes[index].Entry;
             node.Status = DAGNodeStatus::Running;
             node.Message.clear();
-            work.Name = name;
-            work.Action = node.Action;
-            work.Lane = node.Lane;
-            for (const auto &link : m_DataLinks)
-                if (link.ToNode == name) work.Transfers.emplace_back(link.Label, link.Transfer);
-            return work;
+            --pending;
         };
 
-        auto runWork = [&](WorkItem work)
+        // Actions, lanes, and transfers cannot change while m_Executing is set, so only the status needs the lock.
+        const auto runWork = [&](std::size_t index)
         {
+            Node &node = *nodes[index].Entry;
+            const ScopedNodeThreads threads(nodes[index].GrantedThreads, node.Lane == DAGExecutionLane::Parallel);
+            // Serial callbacks may touch ROOT state, so they exclude ROOT nodes of other DAGs as well.
             std::unique_lock<std::recursive_mutex> rootLock(CascadeRootExecutionMutex(), std::defer_lock);
-            if (work.Lane == DAGExecutionLane::Root) rootLock.lock();
+            if (node.Lane == DAGExecutionLane::Root || node.Lane == DAGExecutionLane::Serial) rootLock.lock();
             try
             {
-                for (const auto &[label, transfer] : work.Transfers)
+                for (const auto &[label, transfer] : nodes[index].Transfers)
                 {
                     try
                     {
@@ -228,15 +454,14 @@ DAGRunResult DAGManager::Execute(bool failFast)
                         throw std::runtime_error("Data link '" + label + "' failed with an unknown exception");
                     }
                 }
-                work.Action();
+                node.Action();
                 std::lock_guard<std::recursive_mutex> lock(m_Mutex);
-                m_Nodes.at(work.Name).Status = DAGNodeStatus::Succeeded;
+                node.Status = DAGNodeStatus::Succeeded;
                 return true;
             }
             catch (const std::exception &error)
             {
                 std::lock_guard<std::recursive_mutex> lock(m_Mutex);
-                auto &node = m_Nodes.at(work.Name);
                 node.Status = DAGNodeStatus::Failed;
                 node.Message = error.what();
                 return false;
@@ -244,153 +469,132 @@ DAGRunResult DAGManager::Execute(bool failFast)
             catch (...)
             {
                 std::lock_guard<std::recursive_mutex> lock(m_Mutex);
-                auto &node = m_Nodes.at(work.Name);
                 node.Status = DAGNodeStatus::Failed;
                 node.Message = "Unknown task exception";
                 return false;
             }
         };
 
-        struct Completion
+        // The lambdas below require scheduleMutex.
+        const auto complete = [&](std::size_t index, bool succeeded)
         {
-            std::string Name;
-            DAGExecutionLane Lane = DAGExecutionLane::Serial;
-            bool Succeeded = false;
+            std::lock_guard<std::recursive_mutex> lock(m_Mutex);
+            if (!succeeded)
+            {
+                blockDescendants(index, nodes[index].Entry->Name);
+                if (failFast) stopDispatch = true;
+                return;
+            }
+            for (const std::size_t dependent : nodes[index].Dependents)
+                if (--nodes[dependent].Waiting == 0 && nodes[dependent].Entry->Status == DAGNodeStatus::Pending) makeReady(dependent);
         };
-        std::mutex completionMutex;
-        std::condition_variable completionReady;
-        std::deque<Completion> completions;
-        std::size_t active = 0;
-        bool rootActive = false;
-        bool stopDispatch = false;
-        std::atomic<bool> failureObserved{false};
-
-        auto dispatch = [&](WorkItem work)
+
+        std::function<void()> fill;
+        const auto dispatch = [&](std::size_t index)
         {
-            const std::string name = work.Name;
-            const DAGExecutionLane lane = work.Lane;
+            prepareWork(index);
             ++active;
-            if (lane == DAGExecutionLane::Root) rootActive = true;
-            pool->Submit(
-                [&, work = std::move(work), name, lane]() mutable
+            usedThreads += nodes[index].Threads;
+            usedMemory += nodes[index].MemoryMB;
+            if (nodes[index].Entry->Lane == DAGExecutionLane::Root) rootActive = true;
+            m_Pool->Submit(
+                [&, index]()
                 {
-                    const bool succeeded = runWork(std::move(work));
-                    if (!succeeded) failureObserved.store(true, std::memory_order_release);
-                    {
-                        std::lock_guard<std::mutex> lock(completionMutex);
-                        completions.push_back({name, lane, succeeded});
-                    }
-                    completionReady.notify_one();
+                    const bool succeeded = runWork(index);
+                    // Nothing in this frame is touched after the lock is released.
+                    std::lock_guard<std::mutex> lock(scheduleMutex);
+                    --active;
+                    usedThreads -= nodes[index].Threads;
+                    usedMemory -= nodes[index].MemoryMB;
+                    if (nodes[index].Entry->Lane == DAGExecutionLane::Root) rootActive = false;
+                    complete(index, succeeded);
+                    fill();
+                    if (active == 0 || serialNext != noSerialNode) wake.notify_one();
                 });
         };
 
-        while (true)
+        const auto handToSerialExecutor = [&](std::size_t index)
         {
-            std::vector<std::string> ready;
-            bool pending = false;
-            {
-                std::lock_guard<std::recursive_mutex> lock(m_Mutex);
-                for (const auto &name : order)
-                {
-                    auto &node = m_Nodes.at(name);
-                    if (node.Status != DAGNodeStatus::Pending) continue;
-                    pending = true;
-                    const auto failedDependency =
-                        std::find_if(node.Dependencies.begin(), node.Dependencies.end(),
-                                     [&](const std::string &dependency)
-                                     {
-                                         const auto status = m_Nodes.at(dependency).Status;
-                                         return status == DAGNodeStatus::Failed || status == DAGNodeStatus::Blocked;
-                                     });
-                    if (failedDependency != node.Dependencies.end())
-                    {
-                        node.Status = DAGNodeStatus::Blocked;
-                        node.Message = "Blocked by dependency: " + *failedDependency;
-                        continue;
-                    }
-                    const bool dependenciesComplete =
-                        std::all_of(node.Dependencies.begin(), node.Dependencies.end(),
-                                    [&](const std::string &dependency)
-                                    { return m_Nodes.at(dependency).Status == DAGNodeStatus::Succeeded; });
-                    if (dependenciesComplete) ready.push_back(name);
-                }
-            }
-
-            if (failFast && failureObserved.load(std::memory_order_acquire)) stopDispatch = true;
-            if (stopDispatch && active == 0) break;
-            if (!pending && active == 0) break;
+            usedThreads += nodes[index].Threads;
+            usedMemory += nodes[index].MemoryMB;
+            serialActive = true;
+            serialNext = index;
+        };
 
-            if (!stopDispatch)
+        // Ready nodes are visited in priority order. The Root and Serial lanes each run one node at a time and never
+        // overlap each other; everything else shares the pool. A node that does not fit the free threads and memory
+        // reserves its share, so the nodes after it only use capacity it does not need and it starts once enough running
+        // nodes finish.
+        fill = [&]()
+        {
+            if (stopDispatch) return;
+            std::vector<std::size_t> deferred;
+            std::size_t reservedThreads = 0;
+            std::size_t reservedMemory = 0;
+            bool exclusiveDeferred = false;
+            while (usedThreads + reservedThreads <= maxWorkers && (memoryBudget == 0 || usedMemory + reservedMemory <= memoryBudget))
             {
-                const auto serial = std::find_if(
-                    ready.begin(), ready.end(), [&](const std::string &name)
-                    {
-                        std::lock_guard<std::recursive_mutex> lock(m_Mutex);
-                        return m_Nodes.at(name).Lane == DAGExecutionLane::Serial;
-                    });
-                if (serial != ready.end())
-                {
-                    if (active == 0)
-                    {
-                        const bool succeeded = runWork(prepareWork(*serial));
-                        if (failFast && !succeeded)
-                        {
-                            std::lock_guard<std::recursive_mutex> lock(m_Mutex);
-                            MarkBlockedDescendants_(*serial);
-                            stopDispatch = true;
-                        }
-                        continue;
-                    }
-                }
+                const bool exclusiveFree = !rootActive && !serialActive && !exclusiveDeferred;
+                ReadyQueue *queue = nullptr;
+                for (ReadyQueue *candidate : {active < maxWorkers ? &readyPooled : nullptr, exclusiveFree ? &readyRoot : nullptr,
+                                              exclusiveFree ? &readySerial : nullptr})
+                    if (candidate && !candidate->empty() && (!queue || runsLater(queue->top(), candidate->top()))) queue = candidate;
+                if (!queue) break;
+                const std::size_t index = queue->top();
+                queue->pop();
+                const bool fits = usedThreads + reservedThreads + nodes[index].Threads <= maxWorkers &&
+                                  (memoryBudget == 0 || usedMemory + reservedMemory + nodes[index].MemoryMB <= memoryBudget);
+                if (fits && queue == &readySerial)
+                    handToSerialExecutor(index);
+                else if (fits)
+                    dispatch(index);
                 else
                 {
-                    for (const auto &name : ready)
-                    {
-                        if (active >= maxWorkers) break;
-                        DAGExecutionLane lane;
-                        {
-                            std::lock_guard<std::recursive_mutex> lock(m_Mutex);
-                            lane = m_Nodes.at(name).Lane;
-                        }
-                        if (lane == DAGExecutionLane::Root && rootActive) continue;
-                        dispatch(prepareWork(name));
-                    }
-                }
-            }
-
-            if (active == 0)
-            {
-                bool stillPending = false;
-                {
-                    std::lock_guard<std::recursive_mutex> lock(m_Mutex);
-                    stillPending = std::any_of(m_Nodes.begin(), m_Nodes.end(), [](const auto &entry)
-                                               { return entry.second.Status == DAGNodeStatus::Pending; });
+                    deferred.push_back(index);
+                    reservedThreads += nodes[index].Threads;
+                    reservedMemory += nodes[index].MemoryMB;
+                    exclusiveDeferred = exclusiveDeferred || queue != &readyPooled;
                 }
-                if (!stillPending || stopDispatch) break;
-                throw std::logic_error("DAG scheduler reached pending nodes without a runnable dependency set");
             }
+            for (const std::size_t index : deferred)
+                makeReady(index);
+        };
 
-            Completion completion;
-            {
-                std::unique_lock<std::mutex> lock(completionMutex);
-                completionReady.wait(lock, [&]() { return !completions.empty(); });
-                completion = std::move(completions.front());
-                completions.pop_front();
-            }
-            --active;
-            if (completion.Lane == DAGExecutionLane::Root) rootActive = false;
-            if (failFast && !completion.Succeeded)
+        std::unique_lock<std::mutex> lock(scheduleMutex);
+        fill();
+        while (true)
+        {
+            wake.wait(lock, [&]() { return active == 0 || serialNext != noSerialNode; });
+            if (serialNext != noSerialNode)
             {
-                std::lock_guard<std::recursive_mutex> lock(m_Mutex);
-                MarkBlockedDescendants_(completion.Name);
-                stopDispatch = true;
+                const std::size_t index = std::exchange(serialNext, noSerialNode);
+                // A node handed over before a fail-fast stop stays Pending, as undispatched nodes do.
+                const bool run = !stopDispatch;
+                if (run) prepareWork(index);
+                lock.unlock();
+                const bool succeeded = run && runWork(index);
+                lock.lock();
+                serialActive = false;
+                usedThreads -= nodes[index].Threads;
+                usedMemory -= nodes[index].MemoryMB;
+                if (run) complete(index, succeeded);
+                fill();
+                continue;
             }
+            if (pending == 0 || stopDispatch) break;
+            throw std::logic_error("DAG scheduler reached pending nodes without a runnable dependency set");
         }
-        std::lock_guard<std::recursive_mutex> lock(m_Mutex);
+        lock.unlock();
+        std::lock_guard<std::recursive_mutex> statusLock(m_Mutex);
         m_Executing = false;
     }
     catch (...)
     {
+        {
+            std::unique_lock<std::mutex> lock(scheduleMutex);
+            stopDispatch = true;
+            wake.wait(lock, [&]() { return active == 0; });
+        }
         std::lock_guard<std::recursive_mutex> lock(m_Mutex);
         for (auto &[_, node] : m_Nodes)
             if (node.Status == DAGNodeStatus::Running)
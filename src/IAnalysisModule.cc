@@ -215,6 +215,7 @@ RunResult IAnalysisModule::RunImpl_(bool externalPrepared)
             m_Impl->Context.RunId(), GetMetadata(), m_Impl->CodeVersionHash, m_Impl->SnapshotHash,
             m_Impl->Parameters.DumpJSON(), m_Impl->Context.OutputDirectory(), m_Impl->Context.CacheDirectory(),
             successful, outputs, provenancePath);
+        manifest.AnalysisJson = AnalysisRunStatistics();
         const auto stagedManifest = m_Impl->Context.StageOutput(provenancePath);
         ProvenanceRecorder::WriteModuleRun(manifest, stagedManifest);
         m_Impl->Context.Outputs().Commit();
@@ -452,6 +453,18 @@ std::string IAnalysisModule::AnalysisSnapshotState() const
     return state.dump();
 }
 
+std::string IAnalysisModule::AnalysisRunStatistics() const
+{
+    std::lock_guard<std::mutex> lock(m_Impl->ManagerMutex);
+    nlohmann::json statistics = nlohmann::json::array();
+    for (const auto &[name, manager] : m_Impl->Managers)
+    {
+        const auto managerStatistics = nlohmann::json::parse(manager->RunStatistics());
+        if (!managerStatistics.empty()) statistics.push_back({{"name", name}, {"statistics", managerStatistics}});
+    }
+    return statistics.empty() ? "" : statistics.dump();
+}
+
 ParamManager &IAnalysisModule::Parameters() { return m_Impl->Parameters; }
 
 const ParamManager &IAnalysisModule::Parameters() const { return m_Impl->Parameters; }
@@ -531,6 +544,7 @@ void IAnalysisModule::FinalizeProvenance_(const RunResult &result) noexcept
             m_Impl->Context.RunId(), GetMetadata(), m_Impl->CodeVersionHash, m_Impl->SnapshotHash,
             m_Impl->Parameters.DumpJSON(), m_Impl->Context.OutputDirectory(), m_Impl->Context.CacheDirectory(), result,
             {}, expectedPath);
+        manifest.AnalysisJson = AnalysisRunStatistics();
         ProvenanceRecorder::WriteModuleRun(manifest, expectedPath);
         ProvenanceRecorder::StoreModuleRun(manifest);
     }
@@ -585,6 +585,7 @@ std::string ModuleRunManifest::ToJSON(int indent) const
           {"cache_source_manifest", CacheSourceManifest.empty() ? json(nullptr) : json(CacheSourceManifest)}}},
         {"result", {{"status", ToString(Status)}, {"phase", ToString(Phase)}, {"message", Message}}},
         {"artifacts", {{"inputs", inputs}, {"outputs", outputs}}},
+        {"analysis", AnalysisJson.empty() ? json(nullptr) : json::parse(AnalysisJson)},
         {"manifest_path", ManifestPath}};
     return document.dump(indent);
 }
@@ -777,6 +778,7 @@ ModuleRunManifest ProvenanceRecorder::LoadModuleRun(const fs::path &path)
         manifest.Inputs.push_back(ArtifactFromJson(artifact));
     for (const auto &artifact : artifacts.value("outputs", json::array()))
         manifest.Outputs.push_back(ArtifactFromJson(artifact));
+    if (value.contains("analysis") && !value["analysis"].is_null()) manifest.AnalysisJson = value["analysis"].dump();
     manifest.ManifestPath = value.value("manifest_path", AbsoluteString(path));
     return manifest;
 }
@@ -904,6 +906,67 @@ std::optional<ModuleRunManifest> ProvenanceRecorder::FindLastModuleRun(const std
     return run == g_ModuleRuns.end() ? std::nullopt : std::optional<ModuleRunManifest>(run->second);
 }
 
+std::optional<double> ProvenanceRecorder::ModuleRunSeconds(const ModuleRunManifest &manifest)
+{
+    if (manifest.Status != ModuleStatus::Done && manifest.Status != ModuleStatus::Skipped) return std::nullopt;
+    // Timestamps are written by NowUTC: %Y-%m-%dT%H:%M:%S.ffffffZ.
+    const auto parse = [](const std::string &value) -> std::optional<double>
+    {
+        std::tm utc{};
+        std::istringstream input(value);
+        input >> std::get_time(&utc, "%Y-%m-%dT%H:%M:%S");
+        char dot = 0;
+        long micros = 0;
+        if (input.fail() || !(input >> dot >> micros) || dot != '.') return std::nullopt;
+        return static_cast<double>(timegm(&utc)) + static_cast<double>(micros) * 1e-6;
+    };
+    const auto started = parse(manifest.StartedAt);
+    const auto finished = parse(manifest.FinishedAt);
+    if (!started || !finished || *finished < *started) return std::nullopt;
+    return *finished - *started;
+}
+
+std::map<std::string, double> ProvenanceRecorder::HistoricalNodeSeconds(const fs::path &directory, std::size_t maxWorkflows)
+{
+    const fs::path root = directory.empty() ? fs::path(DefaultWorkflowManifestPath("workflow")).parent_path() : directory;
+    std::vector<std::pair<fs::file_time_type, fs::path>> workflows;
+    std::error_code error;
+    for (const auto &entry : fs::directory_iterator(root, error))
+    {
+        if (entry.path().extension() != ".json" || !entry.is_regular_file(error)) continue;
+        const auto modified = entry.last_write_time(error);
+        if (!error) workflows.emplace_back(modified, entry.path());
+    }
+    std::sort(workflows.begin(), workflows.end(), [](const auto &left, const auto &right) { return left.first > right.first; });
+    if (workflows.size() > maxWorkflows) workflows.resize(maxWorkflows);
+
+    std::map<std::string, double> seconds;
+    for (const auto &[_, path] : workflows)
+    {
+        try
+        {
+            if (fs::file_size(path) > kMaximumModuleManifestBytes) continue;
+            std::ifstream input(path);
+            json value;
+            input >> value;
+            if (value.value("schema", "") != "cascade.workflow-run") continue;
+            for (const auto &node : value.value("dag", json::object()).value("nodes", json::array()))
+            {
+                const std::string name = node.value("name", "");
+                if (name.empty() || seconds.count(name) || !node.contains("module_manifest") || !node["module_manifest"].is_string()) continue;
+                const fs::path manifest = node["module_manifest"].get<std::string>();
+                if (!fs::is_regular_file(manifest, error)) continue;
+                if (const auto duration = ModuleRunSeconds(LoadModuleRun(manifest))) seconds[name] = *duration;
+            }
+        }
+        catch (const std::exception &)
+        {
+            // A partially written or foreign manifest only costs this workflow's history.
+        }
+    }
+    return seconds;
+}
+
 std::string ProvenanceRecorder::SuccessfulModuleManifestPath(const fs::path &outputDirectory, const std::string &runId)
 {
     return AbsoluteString(outputDirectory / ".cascade" / "provenance" / "modules" / (runId + ".json"));
@@ -170,6 +170,7 @@ class _FakeController:
     def __init__(self):
         self.handles = {}
         self.nodes = []
+        self.resources = {}
         self.links = []
         self.fail_fast = None
         self.provenance = None
@@ -182,8 +183,9 @@ class _FakeController:
         self.handles[name] = (module, handle)
         return handle
 
-    def add_module_to_dag(self, name, dependencies, isolated=False):
+    def add_module_to_dag(self, name, dependencies, isolated=False, threads=1, memory_mb=0):
         self.nodes.append((name, dependencies, isolated))
+        self.resources[name] = (threads, memory_mb)
 
     def link_dag_parameter(self, source, source_param, target, target_param):
         self.links.append((source, source_param, target, target_param))
@@ -901,6 +903,8 @@ class CliTests(unittest.TestCase):
                     "name": "consumer",
                     "dependencies": ["producer"],
                     "isolated": True,
+                    "threads": 4,
+                    "memory_mb": 2048,
                 },
             ],
             "links": [
@@ -927,6 +931,7 @@ class CliTests(unittest.TestCase):
                     ("consumer", ["producer"], True),
                 ],
             )
+            self.assertEqual(controller.resources, {"producer": (1, 0), "consumer": (4, 2048)})
             self.assertEqual(
                 controller.links,
                 [("producer", "value", "consumer", "input_value")],
@@ -963,6 +968,19 @@ class CliTests(unittest.TestCase):
             with self.assertRaises(ValueError):
                 cli_execution.cmd_dag_run(args)
 
+    def test_dag_workflow_rejects_invalid_resources(self):
+        for value in (-1, 1.5, True):
+            workflow = {
+                "schema_version": 1,
+                "modules": [{"module": "Module", "name": "module", "threads": value}],
+            }
+            with tempfile.TemporaryDirectory() as directory:
+                path = pathlib.Path(directory) / "workflow.json"
+                path.write_text(json.dumps(workflow), encoding="utf-8")
+                args = types.SimpleNamespace(workflow=str(path), fail_fast=None, dot=None, json=False)
+                with self.assertRaises(TypeError):
+                    cli_execution.cmd_dag_run(args)
+
     def test_dag_validate_configures_without_execution(self):
         workflow = {
             "schema_version": 1,
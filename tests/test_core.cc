@@ -4,17 +4,26 @@
 #include "AnalysisModuleRegistry.hh"
 #include "CacheManager.hh"
 #include "DAGManager.hh"
+#include "ExecutionResources.hh"
 #include "Logger.hh"
 #include "ParamManager.hh"
 #include "PlotManager.hh"
 #include "PluginVerifier.hh"
 #include "PluginPaths.hh"
+#include "Provenance.hh"
 
+#include <TBranch.h>
 #include <TCanvas.h>
+#include <TEnv.h>
 #include <TFile.h>
 #include <TH1.h>
+#include <TH2.h>
+#include <TH3.h>
+#include <TProfile.h>
 #include <TTree.h>
+#include <TTreeFormula.h>
 #include <TROOT.h>
+#include <RVersion.h>
 #include <cassert>
 #include <algorithm>
 #include <atomic>
@@ -24,8 +33,14 @@
 #include <cstdlib>
 #include <filesystem>
 #include <fstream>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <nlohmann/json.hpp>
+#include <optional>
 #include <regex>
+#include <set>
 #include <stdexcept>
 #include <sstream>
 #include <string>
@@ -195,6 +210,37 @@ class BlockingModule final : public IAnalysisModule
     void Finalize() override {}
 };
 
+// Writes a tree "events" whose double branch holds value(index) for each entry.
+void WriteEventsFile(const std::filesystem::path &path, const std::string &branch = "x", int entries = 100,
+                     const std::function<double(int)> &value = [](int index) { return 0.1 * index; }, Long64_t autoFlush = 0)
+{
+    TFile output(path.c_str(), "RECREATE");
+    TTree tree("events", "events");
+    if (autoFlush > 0) tree.SetAutoFlush(autoFlush);
+    double current = 0.0;
+    tree.Branch(branch.c_str(), &current, (branch + "/D").c_str());
+    for (int index = 0; index < entries; ++index)
+    {
+        current = value(index);
+        tree.Fill();
+    }
+    tree.Write();
+}
+
+// Writes an input configuration reading "events" from the files, with each alias mapped to its branch.
+void WriteInputConfig(const std::filesystem::path &path, const std::vector<std::string> &files,
+                      const std::vector<std::pair<std::string, std::string>> &branches = {{"x", "x"}}, const std::string &extra = "")
+{
+    std::ofstream output(path);
+    output << "schema_version: 1\ninput:\n  files: [";
+    for (std::size_t index = 0; index < files.size(); ++index)
+        output << (index ? ", " : "") << files[index];
+    output << "]\n  tree: events\nbranches:\n";
+    for (const auto &[alias, branch] : branches)
+        output << "  " << alias << ":\n    name: " << branch << "\n";
+    output << extra;
+}
+
 void TestLifecycle()
 {
     LifecycleModule success;
@@ -1087,15 +1133,34 @@ void TestAnalysisConfigExpressions()
     AnalysisManager manager;
     assert(manager.PreflightInputConfig(inputConfig.string()).Valid());
     manager.LoadInputConfig(inputConfig.string());
+    // Whole words only, including inside quotes and member paths, exactly as the former regex rewrite did.
+    assert(manager.ExpandAliases("x*2 + x_1 + max(x,count) + xx + 2x + s.x + \"x\"") ==
+           "raw*2 + x_1 + max(raw,count) + xx + 2x + s.raw + \"raw\"");
     assert(manager.BuildChain());
     manager.RegisterCut("above_one", "x > 1");
     manager.EnableAllCuts();
     assert(manager.PreflightHistogramConfig(histogramConfig.string()).Valid());
+    const ConfigPreflightResult preflight = manager.PreflightConfigs(inputConfig.string(), "", histogramConfig.string());
+    assert(preflight.Valid() && preflight.Cuts.Errors.empty());
     manager.LoadHistogramConfig(histogramConfig.string());
+    const ValueHandle xHandle = manager.GetValueHandle("x");
+    const auto countHandle = manager.GetBranchHandle<int>("count");
+    bool mismatchedHandleRejected = false;
+    try
+    {
+        manager.GetBranchHandle<float>("count");
+    }
+    catch (const std::exception &)
+    {
+        mismatchedHandleRejected = true;
+    }
+    assert(mismatchedHandleRejected);
     for (Long64_t index = 0; index < manager.GetEntryCount(); ++index)
     {
         manager.LoadEvent(index);
         assert(manager.GetValue("count") == static_cast<double>(index + 1));
+        assert(*countHandle == static_cast<int>(index + 1));
+        assert(xHandle.Get() == manager.GetValue("x"));
         assert(manager.GetValue("accepted") == (index == 0 ? 0.0 : 1.0));
         if (index == 0)
             assert(!manager.PassesAllCuts());
@@ -1103,6 +1168,27 @@ void TestAnalysisConfigExpressions()
             assert(manager.PassesAllCuts());
         manager.FillHistograms(1.0);
     }
+    std::vector<Long64_t> selected;
+    assert(manager.SelectEntries(0, manager.GetEntryCount(), selected, 2) == 2);
+    assert((selected == std::vector<Long64_t>{1, 2}));
+
+    manager.RegisterCut("below_three", "x < 3");
+    manager.EnableAllCuts();
+    manager.EnableAdaptiveCutOrder(2);
+    for (int pass = 0; pass < 2; ++pass)
+        for (Long64_t index = 0; index < manager.GetEntryCount(); ++index)
+        {
+            manager.LoadEvent(index);
+            const bool expected = manager.PassesCut("above_one") && manager.PassesCut("below_three");
+            assert(manager.PassesAllCuts() == expected);
+            assert(manager.PassesCuts({"below_three", "above_one"}) == expected);
+        }
+    assert(manager.IsCutOrderLearned());
+    const auto cutStatistics = manager.GetCutStatistics();
+    assert(cutStatistics.size() == 2);
+    for (const auto &cut : cutStatistics)
+        assert(cut.Evaluations == 2);
+    assert(nlohmann::json::parse(manager.RunStatistics())["adaptive_cut_order"]["learned"].get<bool>());
     manager.WriteHistograms(histogramOutput.string());
 
     TFile input(histogramOutput.c_str(), "READ");
@@ -1111,6 +1197,45 @@ void TestAnalysisConfigExpressions()
     assert(histogram->GetEntries() == 3.0);
     assert(std::abs(histogram->GetMean() - 4.0) < 1e-9);
 
+    const auto bufferedConfig = temp / "buffered-histograms.yaml";
+    const auto bufferedOutput = temp / "buffered-histograms.root";
+    {
+        std::ifstream source(histogramConfig);
+        std::ofstream output(bufferedConfig);
+        output << "fill_buffer: 2\n" << source.rdbuf();
+    }
+    AnalysisManager buffered;
+    buffered.LoadInputConfig(inputConfig.string());
+    assert(buffered.BuildChain());
+    assert(buffered.PreflightHistogramConfig(bufferedConfig.string()).Valid());
+    buffered.LoadHistogramConfig(bufferedConfig.string());
+    assert(buffered.GetFillBufferSize() == 2);
+    for (Long64_t index = 0; index < buffered.GetEntryCount(); ++index)
+    {
+        buffered.LoadEvent(index);
+        buffered.FillHistograms(1.0);
+    }
+    buffered.WriteHistograms(bufferedOutput.string());
+    TFile bufferedInput(bufferedOutput.c_str(), "READ");
+    for (const char *name : {"hist_doubled_", "hist_weighted_"})
+    {
+        auto *expected = input.Get<TH1>(name);
+        auto *actual = bufferedInput.Get<TH1>(name);
+        assert(expected && actual);
+        assert(actual->GetEntries() == expected->GetEntries());
+        for (int bin = 0; bin <= expected->GetNbinsX() + 1; ++bin)
+        {
+            assert(actual->GetBinContent(bin) == expected->GetBinContent(bin));
+            assert(actual->GetBinError(bin) == expected->GetBinError(bin));
+        }
+        double expectedStats[4] = {};
+        double actualStats[4] = {};
+        expected->GetStats(expectedStats);
+        actual->GetStats(actualStats);
+        for (int index = 0; index < 4; ++index)
+            assert(actualStats[index] == expectedStats[index]);
+    }
+
     const auto invalidConfig = temp / "invalid-input.yaml";
     {
         std::ofstream output(invalidConfig);
@@ -1124,6 +1249,771 @@ void TestAnalysisConfigExpressions()
     assert(invalidResult.Errors.size() >= 3);
 }
 
+void TestPreflightConfigs()
+{
+    const auto temp = std::filesystem::temp_directory_path() / "cascade-preflight-configs";
+    std::filesystem::create_directories(temp);
+    const auto rawPath = temp / "raw.root";
+    const auto otherPath = temp / "other.root";
+    const auto rawConfig = temp / "raw.yaml";
+    const auto otherConfig = temp / "other.yaml";
+    const auto cutConfig = temp / "cuts.yaml";
+    const auto histogramConfig = temp / "histograms.yaml";
+    WriteEventsFile(rawPath, "raw");
+    WriteEventsFile(otherPath, "other");
+    WriteInputConfig(rawConfig, {rawPath.string()}, {{"x", "raw"}});
+    WriteInputConfig(otherConfig, {otherPath.string()}, {{"y", "other"}});
+    std::ofstream(cutConfig) << "schema_version: 1\ncuts:\n  high: x > 5\n";
+    std::ofstream(histogramConfig) << "schema_version: 1\nhistograms:\n  doubled:\n    expr: x * 2\n    bins: [20, 0, 20]\n";
+
+    // Expressions are checked against the given input's schema, not against the tree the manager has loaded.
+    AnalysisManager manager;
+    manager.LoadInputConfig(otherConfig.string());
+    assert(manager.BuildChain());
+    assert(!manager.PreflightConfigs("", cutConfig.string(), histogramConfig.string()).Valid());
+    assert(manager.PreflightConfigs(rawConfig.string(), cutConfig.string(), histogramConfig.string()).Valid());
+    const ConfigPreflightResult mismatched = manager.PreflightConfigs(otherConfig.string(), cutConfig.string(), histogramConfig.string());
+    assert(mismatched.Input.Valid() && !mismatched.Cuts.Valid() && !mismatched.Histograms.Valid());
+
+    // On the loaded input, enabling the cuts and filling the histograms take over the preflighted expressions.
+    manager.LoadInputConfig(rawConfig.string());
+    assert(manager.BuildChain());
+    assert(manager.PreflightConfigs(rawConfig.string(), cutConfig.string(), histogramConfig.string()).Valid());
+    manager.LoadCutConfig(cutConfig.string());
+    manager.LoadHistogramConfig(histogramConfig.string());
+    manager.EnableAllCuts();
+    for (Long64_t entry = 0; entry < manager.GetEntryCount(); ++entry)
+    {
+        manager.LoadEvent(entry);
+        if (manager.PassesAllCuts()) manager.FillHistograms(1.0);
+    }
+    assert(nlohmann::json::parse(manager.RunStatistics()).at("preflight").at("reused_expressions") >= 2);
+}
+
+void TestCompiledExpressions()
+{
+    double x = 3.0;
+    float y = 2.0F;
+    int n = 5;
+    bool flag = true;
+    const std::map<std::string, ValueHandle> inputs{{"x", ValueHandle(&x, BranchValueType::Double)},
+                                                    {"y", ValueHandle(&y, BranchValueType::Float)},
+                                                    {"n", ValueHandle(&n, BranchValueType::Int)},
+                                                    {"flag", ValueHandle(&flag, BranchValueType::Bool)}};
+    const auto resolve = [&inputs](const std::string &name) -> std::optional<ValueHandle>
+    {
+        const auto input = inputs.find(name);
+        if (input == inputs.end()) return std::nullopt;
+        return input->second;
+    };
+    const auto evaluate = [&resolve](const std::string &expression) { return CompiledExpression::Compile(expression, resolve).Evaluate(); };
+    assert(evaluate("x + y * 2") == 7.0);
+    assert(evaluate("-x^2") == -9.0);
+    assert(evaluate("x > 2 && y < 3") == 1.0);
+    assert(evaluate("!(x > 2) || flag") == 1.0);
+    assert(evaluate("n % 3") == 2.0);
+    assert(evaluate("TMath::Abs(-x) + sqrt(4)") == 5.0);
+    assert(evaluate("max(x, n) - min(1, 2)") == 4.0);
+    x = 10.0;
+    assert(evaluate("x / 4") == 2.5);
+    assert(CompiledExpression::Compile("2 * 3 + x", resolve).Inputs().size() == 1);
+    for (const char *unsupported : {"x[0]", "x & 1", "missing > 1", "x < y < n", "x^2^3", "foo(x)", "x >"})
+    {
+        bool rejected = false;
+        try
+        {
+            CompiledExpression::Compile(unsupported, resolve);
+        }
+        catch (const std::invalid_argument &)
+        {
+            rejected = true;
+        }
+        assert(rejected);
+    }
+
+    const auto cut = CompiledExpression::Compile("x * 2 > y && n != 0", resolve);
+    const std::vector<double> xs{0.0, 1.0, 2.0, 3.0};
+    const std::vector<double> ys{1.0, 1.0, 5.0, 1.0};
+    const std::vector<double> ns{1.0, 0.0, 1.0, 1.0};
+    double results[4] = {};
+    cut.EvaluateBlock({xs.data(), ys.data(), ns.data()}, 4, results);
+    assert(results[0] == 0.0 && results[1] == 0.0 && results[2] == 0.0 && results[3] == 1.0);
+
+    // Outside their domains the compiled operators return what TTreeFormula returns, event by event and per block.
+    const std::vector<double> edges{-800.0, -2.0, -0.5, 0.0, 0.5, 2.0, 800.0};
+    TTree tree("edges", "edges");
+    tree.SetDirectory(nullptr);
+    tree.Branch("x", &x, "x/D");
+    for (const double edge : edges)
+    {
+        x = edge;
+        tree.Fill();
+    }
+    const auto same = [](double compiled, double reference)
+    { return compiled == reference || std::fabs(compiled - reference) <= 1e-12 * std::fabs(reference); };
+    for (const char *expression : {"2 / x", "x / (x - x)", "sqrt(x)", "log(x)", "log10(x)", "exp(x)", "asin(x)", "acos(x)"})
+    {
+        const auto compiled = CompiledExpression::Compile(expression, resolve);
+        TTreeFormula reference("reference", expression, &tree);
+        std::vector<double> block(edges.size());
+        compiled.EvaluateBlock({edges.data()}, edges.size(), block.data());
+        for (Long64_t entry = 0; entry < static_cast<Long64_t>(edges.size()); ++entry)
+        {
+            tree.GetEntry(entry);
+            const double expected = reference.EvalInstance();
+            assert(std::isfinite(expected));
+            assert(same(compiled.Evaluate(), expected));
+            assert(same(block[entry], expected));
+        }
+    }
+}
+
+void TestClassicEventLoopThreads()
+{
+    const auto temp = std::filesystem::temp_directory_path() / "cascade-event-loop";
+    std::filesystem::create_directories(temp);
+    const auto inputPath = temp / "input.root";
+    const auto inputConfig = temp / "input.yaml";
+    WriteEventsFile(inputPath, "raw", 1000, [](int index) { return 0.25 * index; }, 100);
+    WriteInputConfig(inputConfig, {inputPath.string()}, {{"x", "raw"}});
+
+    std::vector<std::unique_ptr<TH1>> results;
+    for (const unsigned int threads : {1U, 4U})
+    {
+        AnalysisManager manager;
+        manager.LoadInputConfig(inputConfig.string());
+        assert(manager.BuildChain());
+        manager.RegisterCut("upper", "x >= 62.5");
+        manager.EnableAllCuts();
+        manager.EnableAdaptiveCutOrder(100);
+        manager.RegisterVariable("scaled");
+        manager.BookHistogram("scaled", {10, 0.0, 500.0});
+        std::atomic<Long64_t> visited{0};
+        const Long64_t processed = manager.RunEventLoop(
+            [&visited](AnalysisManager &worker, Long64_t)
+            {
+                ++visited;
+                *worker.GetVariablePointer("scaled") = 2.0 * worker.GetValue("x");
+                if (worker.PassesCuts({"upper"}) && worker.PassesAllCuts()) worker.FillHistograms(1.0);
+            },
+            threads);
+        assert(processed == 1000);
+        assert(visited.load() == 1000);
+        // Worker statistics reach this manager, and two cut queries in one event count as one decision.
+        const auto adaptive = nlohmann::json::parse(manager.RunStatistics()).at("adaptive_cut_order");
+        assert(adaptive.at("learned").get<bool>());
+        assert(adaptive.at("observed_events").get<Long64_t>() == (threads == 1 ? 100 : 400));
+        assert(adaptive.at("cuts").at(0).at("evaluations") == adaptive.at("observed_events"));
+        const auto path = temp / ("histograms-" + std::to_string(threads) + ".root");
+        manager.WriteHistograms(path.string());
+        TFile input(path.c_str(), "READ");
+        auto *histogram = input.Get<TH1>("hist_scaled_");
+        assert(histogram);
+        histogram->SetDirectory(nullptr);
+        results.emplace_back(histogram);
+    }
+    assert(results[0]->GetEntries() == 750.0);
+    assert(results[1]->GetEntries() == results[0]->GetEntries());
+    for (int bin = 0; bin <= results[0]->GetNbinsX() + 1; ++bin)
+        assert(results[1]->GetBinContent(bin) == results[0]->GetBinContent(bin));
+}
+
+void TestClassicCutflow()
+{
+    const auto temp = std::filesystem::temp_directory_path() / "cascade-cutflow";
+    std::filesystem::create_directories(temp);
+    const auto inputPath = temp / "input.root";
+    const auto inputConfig = temp / "input.yaml";
+    WriteEventsFile(inputPath, "raw", 1000, [](int index) { return 0.25 * index; }, 100);
+    WriteInputConfig(inputConfig, {inputPath.string()}, {{"x", "raw"}});
+
+    for (const unsigned int threads : {1U, 4U})
+    {
+        AnalysisManager manager;
+        manager.LoadInputConfig(inputConfig.string());
+        assert(manager.BuildChain());
+        // Stages follow registration order, not name order.
+        manager.RegisterCut("window", "x < 200");
+        manager.RegisterCut("upper", "x >= 62.5");
+        manager.EnableAllCuts();
+        manager.EnableCutflow();
+        std::atomic<Long64_t> selected{0};
+        manager.RunEventLoop([&selected](AnalysisManager &worker, Long64_t) { selected += worker.PassesAllCuts(2.0); }, threads);
+        assert(selected.load() == 550);
+
+        const Cutflow cutflow = manager.GetCutflow();
+        assert(cutflow.Total == 1000 && cutflow.TotalWeight == 2000.0);
+        assert(cutflow.Stages.size() == 2);
+        assert(cutflow.Stages[0].Name == "window" && cutflow.Stages[0].Passed == 800 && cutflow.Stages[0].Individual == 800);
+        assert(cutflow.Stages[1].Name == "upper" && cutflow.Stages[1].Passed == 550 && cutflow.Stages[1].Individual == 750);
+        assert(cutflow.Stages[1].PassedWeight == 1100.0 && cutflow.Stages[1].IndividualWeight == 1500.0);
+
+        const auto jsonPath = temp / ("cutflow-" + std::to_string(threads) + ".json");
+        manager.WriteCutflow(jsonPath.string());
+        std::ifstream jsonInput(jsonPath);
+        const auto document = nlohmann::json::parse(jsonInput);
+        assert(document.at("schema") == "cascade.cutflow");
+        assert(document.at("total").at("events") == 1000);
+        assert(document.at("stages").at(1).at("expression") == "x >= 62.5");
+        assert(document.at("stages").at(1).at("relative_efficiency") == 550.0 / 800.0);
+
+        const auto rootPath = temp / ("cutflow-" + std::to_string(threads) + ".root");
+        manager.WriteCutflow(rootPath.string());
+        TFile rootInput(rootPath.c_str(), "READ");
+        auto *histogram = rootInput.Get<TH1>("cutflow");
+        assert(histogram && histogram->GetNbinsX() == 3);
+        assert(std::string(histogram->GetXaxis()->GetBinLabel(3)) == "upper" && histogram->GetBinContent(3) == 550.0);
+        assert(rootInput.Get<TH1>("cutflow_individual_weighted")->GetBinContent(3) == 1500.0);
+
+        bool rejected = false;
+        try
+        {
+            manager.WriteCutflow((temp / "cutflow.txt").string());
+        }
+        catch (const std::invalid_argument &)
+        {
+            rejected = true;
+        }
+        assert(rejected);
+    }
+
+    // A cut named twice in the configuration is one stage.
+    const auto cutConfig = temp / "cuts.yaml";
+    std::ofstream(cutConfig) << "schema_version: 1\ncuts:\n  window: x < 200\n  window: x < 200\n";
+    AnalysisManager repeated;
+    repeated.LoadInputConfig(inputConfig.string());
+    assert(repeated.BuildChain());
+    repeated.LoadCutConfig(cutConfig.string());
+    repeated.EnableAllCuts();
+    repeated.EnableCutflow();
+    repeated.RegisterCut("window", "x < 200");
+    repeated.EnableAllCuts();
+    assert(repeated.GetCutflow().Stages.size() == 1);
+}
+
+void TestRdfCutflow()
+{
+    ROOT::DisableImplicitMT();
+    const auto temp = std::filesystem::temp_directory_path() / "cascade-rdf-cutflow";
+    std::filesystem::create_directories(temp);
+    const auto inputPath = temp / "input.root";
+    WriteEventsFile(inputPath);
+
+    std::atomic<int> evaluations{0};
+    AnalysisManager manager;
+    manager.InitRdfFromFile("events", inputPath.string());
+    manager.DefineRdfVariable(
+        "tracked",
+        [&](double value)
+        {
+            ++evaluations;
+            return value;
+        },
+        {"x"});
+    manager.EnableCutflow();
+    manager.ApplyRdfFilter("low", "tracked < 5");
+    manager.RegisterCut("central", "x >= 2.45");
+    manager.ApplyRdfFilter("central");
+    manager.ApplyRdfFilter("even", [](double x) { return std::lround(10 * x) % 2 == 0; }, {"x"}, "even");
+    manager.BookRdfHistogram1D("x", "", {10, 0, 10}, "x");
+    manager.WriteRdfHistograms((temp / "histograms.root").string());
+
+    // The report is booked with the histograms, so reading the cutflow runs no second event loop.
+    const Cutflow cutflow = manager.GetCutflow();
+    assert(evaluations.load() == 100);
+    assert(cutflow.Total == 100 && cutflow.Stages.size() == 3);
+    assert(cutflow.Stages[0].Name == "low" && cutflow.Stages[0].Passed == 50);
+    assert(cutflow.Stages[1].Name == "central" && cutflow.Stages[1].Passed == 25);
+    assert(cutflow.Stages[2].Name == "even" && cutflow.Stages[2].Passed == 12);
+    assert(manager.GetCutflow().Stages[2].Passed == 12 && evaluations.load() == 100);
+}
+
+void TestChainIndex()
+{
+    const auto temp = std::filesystem::temp_directory_path() / "cascade-chain-index";
+    std::filesystem::remove_all(temp);
+    std::filesystem::create_directories(temp);
+    const auto indexDirectory = temp / "index";
+    const auto inputConfig = temp / "input.yaml";
+    std::vector<std::string> files;
+    for (int file = 0; file < 2; ++file)
+    {
+        const auto path = temp / ("input-" + std::to_string(file) + ".root");
+        WriteEventsFile(path, "raw", 120 + 30 * file, [](int index) { return index; }, 50);
+        files.push_back(path.string());
+    }
+    WriteInputConfig(inputConfig, files, {{"x", "raw"}});
+
+    const auto countRecords = [&indexDirectory]()
+    {
+        std::size_t records = 0;
+        for (const auto &entry : std::filesystem::directory_iterator(indexDirectory))
+            records += entry.path().extension() == ".json";
+        return records;
+    };
+    for (int build = 0; build < 2; ++build)
+    {
+        AnalysisManager manager;
+        manager.SetChainIndexDirectory(indexDirectory.string());
+        manager.LoadInputConfig(inputConfig.string());
+        const Long64_t bytesBefore = TFile::GetFileBytesRead();
+        assert(manager.BuildChain());
+        assert(manager.GetEntryCount() == 270);
+        // The second build takes entry counts from the index and opens no input file.
+        if (build == 1) assert(TFile::GetFileBytesRead() == bytesBefore);
+        manager.LoadEvent(200);
+        assert(manager.GetValue("x") == 80.0);
+    }
+    assert(countRecords() == 2);
+
+    // Rewriting a file changes its identity, so it is scanned again under a new record.
+    WriteEventsFile(files[1], "raw", 10);
+    AnalysisManager manager;
+    manager.SetChainIndexDirectory(indexDirectory.string());
+    manager.LoadInputConfig(inputConfig.string());
+    assert(manager.BuildChain());
+    assert(manager.GetEntryCount() == 130);
+    assert(countRecords() == 3);
+}
+
+void TestSelectionCache()
+{
+    const auto temp = std::filesystem::temp_directory_path() / "cascade-selection-cache";
+    std::filesystem::remove_all(temp);
+    std::filesystem::create_directories(temp);
+    const auto cacheDirectory = temp / "selections";
+    const auto inputPath = temp / "input.root";
+    const auto inputConfig = temp / "input.yaml";
+    WriteEventsFile(inputPath, "raw", 1000, [](int index) { return index % 97; }, 100);
+    WriteInputConfig(inputConfig, {inputPath.string()}, {{"x", "raw"}});
+    const auto cacheFiles = [&cacheDirectory]()
+    {
+        std::size_t files = 0;
+        for (const auto &entry : std::filesystem::directory_iterator(cacheDirectory))
+            files += entry.path().extension() == ".sel";
+        return files;
+    };
+    const auto makeManager = [&](const std::string &cut)
+    {
+        auto manager = std::make_unique<AnalysisManager>();
+        manager->SetSelectionCacheDirectory(cacheDirectory.string());
+        manager->LoadInputConfig(inputConfig.string());
+        assert(manager->BuildChain());
+        manager->RegisterCut("tight", cut);
+        manager->EnableAllCuts();
+        return manager;
+    };
+
+    std::vector<Long64_t> expected;
+    for (Long64_t entry = 0; entry < 1000; ++entry)
+        if (entry % 97 >= 90) expected.push_back(entry);
+    const std::vector<Long64_t> first = makeManager("x >= 90")->GetSelectedEntries();
+    assert(first == expected);
+    assert(cacheFiles() == 1);
+    // An alias and its branch name expand to the same cut, so the stored list is reused.
+    const std::vector<Long64_t> second = makeManager("raw >= 90")->GetSelectedEntries();
+    assert(second == expected);
+    assert(cacheFiles() == 1);
+    assert(makeManager("x >= 95")->GetSelectedEntries().size() < expected.size());
+    assert(cacheFiles() == 2);
+
+    auto manager = makeManager("x >= 90");
+    std::atomic<Long64_t> visited{0};
+    std::atomic<bool> outside{false};
+    const Long64_t processed = manager->RunSelectedEventLoop(
+        [&](AnalysisManager &worker, Long64_t)
+        {
+            ++visited;
+            if (worker.GetValue("x") < 90) outside.store(true);
+        },
+        4);
+    assert(processed == static_cast<Long64_t>(expected.size()));
+    assert(visited.load() == processed && !outside.load());
+    // Progress counts loop positions, so a selection ending before the last entry still completes.
+    assert(manager->RunSelectedEventLoop([](AnalysisManager &, Long64_t) {}, 1) == processed);
+    assert(manager->GetProgress() == 1.0);
+}
+
+void TestInputReadOptimization()
+{
+    const auto temp = std::filesystem::temp_directory_path() / "cascade-input-reads";
+    std::filesystem::create_directories(temp);
+    const auto inputConfig = temp / "input.yaml";
+    std::vector<std::string> inputPaths;
+    for (int file = 0; file < 2; ++file)
+    {
+        inputPaths.push_back((temp / ("input" + std::to_string(file) + ".root")).string());
+        TFile output(inputPaths.back().c_str(), "RECREATE");
+        TTree tree("events", "events");
+        double raw = 0.0;
+        double quality = 0.0;
+        double unused = 0.0;
+        tree.Branch("raw", &raw, "raw/D");
+        tree.Branch("quality", &quality, "quality/D");
+        tree.Branch("unused", &unused, "unused/D");
+        for (int index = 100 * file; index < 100 * (file + 1); ++index)
+        {
+            raw = index;
+            quality = index % 4;
+            unused = -index;
+            tree.Fill();
+        }
+        tree.Write();
+    }
+    WriteInputConfig(inputConfig, inputPaths, {{"x", "raw"}});
+
+    AnalysisManager manager;
+    manager.LoadInputConfig(inputConfig.string());
+    TChain *chain = manager.BuildChain();
+    assert(chain);
+    // quality is read only through the cut expression, not through the input configuration.
+    manager.RegisterCut("good", "quality == 0 && x < 100");
+    manager.EnableAllCuts();
+    const int prefetching = gEnv->GetValue("TFile.AsyncPrefetching", 0);
+    manager.OptimizeInputReads();
+    assert(gEnv->GetValue("TFile.AsyncPrefetching", 0) == prefetching);
+    assert(chain->GetBranchStatus("raw") && chain->GetBranchStatus("quality") && !chain->GetBranchStatus("unused"));
+
+    Long64_t selected = 0;
+    InputReadStatistics firstFile;
+    for (Long64_t entry = 0; entry < manager.GetEntryCount(); ++entry)
+    {
+        manager.LoadEvent(entry);
+        selected += manager.PassesAllCuts();
+        if (entry == 99) firstFile = manager.GetInputReadStatistics();
+        // A plan applied mid-loop keeps the loaded entry.
+        if (entry == 150)
+        {
+            manager.OptimizeInputReads(0, true, {"unused"});
+            assert(chain->GetReadEntry() == 150 && chain->GetTreeNumber() == 1);
+        }
+    }
+    assert(selected == 25);
+    const InputReadStatistics reads = manager.GetInputReadStatistics();
+    assert(reads.ActiveBranches == 3 && reads.TotalBranches == 3);
+    assert(reads.CacheSize > 0 && firstFile.BytesRead > 0 && firstFile.CacheBytesRead > 0);
+    // The second file's reads add to the first file's instead of replacing them.
+    assert(reads.BytesRead > firstFile.BytesRead && reads.CacheBytesRead > firstFile.CacheBytesRead);
+    // Reads of other files do not count.
+    {
+        TFile other(inputPaths.front().c_str());
+        auto *tree = other.Get<TTree>("events");
+        for (Long64_t entry = 0; entry < tree->GetEntries(); ++entry)
+            tree->GetEntry(entry);
+    }
+    assert(manager.GetInputReadStatistics().BytesRead == reads.BytesRead);
+    assert(nlohmann::json::parse(manager.RunStatistics()).at("input_reads").at("active_branches") == 3);
+
+    bool rejected = false;
+    try
+    {
+        manager.OptimizeInputReads(0, false, {"missing"});
+    }
+    catch (const std::runtime_error &)
+    {
+        rejected = true;
+    }
+    assert(rejected);
+}
+
+void TestHistogramShapes()
+{
+    const auto temp = std::filesystem::temp_directory_path() / "cascade-histogram-shapes";
+    std::filesystem::create_directories(temp);
+    const auto inputPath = temp / "input.root";
+    const auto inputConfig = temp / "input.yaml";
+    const auto histogramConfig = temp / "histograms.yaml";
+    {
+        TFile output(inputPath.c_str(), "RECREATE");
+        TTree tree("events", "events");
+        double x = 0.0;
+        double y = 0.0;
+        tree.Branch("x", &x, "x/D");
+        tree.Branch("y", &y, "y/D");
+        for (int index = 0; index < 100; ++index)
+        {
+            x = 0.1 * index;
+            y = 2.0 * x;
+            tree.Fill();
+        }
+        tree.Write();
+    }
+    WriteInputConfig(inputConfig, {inputPath.string()}, {{"x", "x"}, {"y", "y"}});
+    {
+        std::ofstream output(histogramConfig);
+        output << "schema_version: 1\n"
+                  "histograms:\n"
+                  "  variable:\n"
+                  "    expr: x\n"
+                  "    edges: [0, 1, 5, 10]\n"
+                  "  map:\n"
+                  "    type: TH2D\n"
+                  "    expr: x\n"
+                  "    bins: [10, 0, 10]\n"
+                  "    y:\n"
+                  "      expr: y\n"
+                  "      edges: [0, 5, 20]\n"
+                  "  cube:\n"
+                  "    type: TH3D\n"
+                  "    expr: x\n"
+                  "    bins: [5, 0, 10]\n"
+                  "    y:\n"
+                  "      expr: y\n"
+                  "      bins: [4, 0, 20]\n"
+                  "    z:\n"
+                  "      expr: x + y\n"
+                  "      bins: [3, 0, 30]\n"
+                  "  profile:\n"
+                  "    type: TProfile\n"
+                  "    expr: x\n"
+                  "    bins: [2, 0, 10]\n"
+                  "    y:\n"
+                  "      expr: y\n";
+    }
+
+    const auto check = [](const std::filesystem::path &path)
+    {
+        TFile input(path.c_str(), "READ");
+        auto *variable = input.Get<TH1>("hist_variable_");
+        auto *map = input.Get<TH2>("hist_map_");
+        auto *cube = input.Get<TH3>("hist_cube_");
+        auto *profile = input.Get<TProfile>("hist_profile_");
+        assert(variable && map && cube && profile);
+        assert(variable->GetNbinsX() == 3 && variable->GetBinContent(2) == 40.0 && variable->GetBinContent(3) == 50.0);
+        assert(map->GetNbinsY() == 2 && map->GetEntries() == 100.0 && map->GetBinContent(map->FindBin(1.5, 3.0)) == 10.0);
+        assert(cube->GetEntries() == 100.0);
+        assert(std::abs(profile->GetBinContent(1) - 4.9) < 1e-9);
+    };
+
+    {
+        AnalysisManager manager;
+        manager.LoadInputConfig(inputConfig.string());
+        assert(manager.BuildChain());
+        assert(manager.PreflightHistogramConfig(histogramConfig.string()).Valid());
+        manager.LoadHistogramConfig(histogramConfig.string());
+        for (Long64_t entry = 0; entry < manager.GetEntryCount(); ++entry)
+        {
+            manager.LoadEvent(entry);
+            manager.FillHistograms(1.0);
+        }
+        manager.WriteHistograms((temp / "classic.root").string());
+        check(temp / "classic.root");
+        // The writer emits the same schema the loader reads.
+        manager.WriteHistogramConfig((temp / "written.yaml").string());
+        AnalysisManager reloaded;
+        reloaded.LoadInputConfig(inputConfig.string());
+        assert(reloaded.BuildChain());
+        assert(reloaded.PreflightHistogramConfig((temp / "written.yaml").string()).Valid());
+    }
+    {
+        AnalysisManager manager;
+        manager.InitRdfFromConfig(inputConfig.string());
+        manager.BookRdfHistogramsFromConfig(histogramConfig.string());
+        manager.WriteRdfHistograms((temp / "rdf.root").string());
+        check(temp / "rdf.root");
+    }
+
+    const std::vector<std::pair<std::string, std::string>> invalid{
+        {"type: TH2D\n    expr: x\n    bins: [10, 0, 10]\n", "histograms.bad.y must be a map"},
+        {"type: TProfile\n    expr: x\n    bins: [2, 0, 10]\n    y:\n      expr: y\n      bins: [2, 0, 1]\n", "is profiled"},
+        {"expr: x\n    edges: [0, 2, 1]\n", "strictly increasing"},
+        {"type: TH4D\n    expr: x\n    bins: [2, 0, 10]\n", "histograms.bad.type"},
+    };
+    AnalysisManager manager;
+    for (const auto &[entry, message] : invalid)
+    {
+        const auto path = temp / "invalid.yaml";
+        std::ofstream(path) << "schema_version: 1\nhistograms:\n  bad:\n    " << entry;
+        const auto result = manager.PreflightHistogramConfig(path.string());
+        assert(!result.Valid() && result.Errors.front().find(message) != std::string::npos);
+    }
+}
+
+void TestSystematicVariations()
+{
+    const auto temp = std::filesystem::temp_directory_path() / "cascade-variations";
+    std::filesystem::create_directories(temp);
+    const auto inputPath = temp / "input.root";
+    const auto inputConfig = temp / "input.yaml";
+    const auto cutConfig = temp / "cuts.yaml";
+    const auto histogramConfig = temp / "histograms.yaml";
+    {
+        TFile output(inputPath.c_str(), "RECREATE");
+        TTree tree("events", "events");
+        tree.SetAutoFlush(10);
+        double x = 0.0;
+        double w = 2.0;
+        tree.Branch("x", &x, "x/D");
+        tree.Branch("w", &w, "w/D");
+        for (int index = 0; index < 100; ++index)
+        {
+            x = 0.1 * index;
+            tree.Fill();
+        }
+        tree.Write();
+    }
+    WriteInputConfig(inputConfig, {inputPath.string()}, {{"x", "x"}, {"w", "w"}});
+    std::ofstream(cutConfig) << "schema_version: 1\n"
+                                "cuts:\n"
+                                "  low: x < 5\n"
+                                "variations:\n"
+                                "  shift_up:\n"
+                                "    columns:\n"
+                                "      x: x + 1\n";
+    std::ofstream(histogramConfig) << "schema_version: 1\n"
+                                      "variations:\n"
+                                      "  weight_up:\n"
+                                      "    weight: w\n"
+                                      "histograms:\n"
+                                      "  xh:\n"
+                                      "    expr: x\n"
+                                      "    bins: [10, 0, 10]\n";
+
+    // The shifted selection keeps x < 4 and fills x + 1; the weight variation keeps the nominal selection.
+    const auto check = [](const std::filesystem::path &path)
+    {
+        TFile input(path.c_str(), "READ");
+        auto *nominal = input.Get<TH1>("hist_xh_");
+        auto *shifted = input.Get<TH1>("hist_xh_shift_up");
+        auto *weighted = input.Get<TH1>("hist_xh_weight_up");
+        assert(nominal && shifted && weighted);
+        assert(nominal->GetEntries() == 50.0 && nominal->Integral() == 50.0);
+        assert(shifted->GetEntries() == 40.0 && shifted->GetBinContent(1) == 0.0 && shifted->GetBinContent(2) == 10.0);
+        assert(weighted->GetEntries() == 50.0 && weighted->Integral() == 100.0);
+    };
+
+    for (const unsigned int threads : {1U, 4U})
+    {
+        AnalysisManager manager;
+        manager.LoadInputConfig(inputConfig.string());
+        assert(manager.BuildChain());
+        assert(manager.PreflightConfigs("", cutConfig.string(), histogramConfig.string()).Valid());
+        manager.LoadCutConfig(cutConfig.string());
+        manager.LoadHistogramConfig(histogramConfig.string());
+        manager.EnableAllCuts();
+        assert((manager.ListVariations() == std::vector<std::string>{"shift_up", "weight_up"}));
+        manager.RunEventLoop([](AnalysisManager &worker, Long64_t) { worker.FillSelectedHistograms(1.0); }, threads);
+        const auto path = temp / ("classic-" + std::to_string(threads) + ".root");
+        manager.WriteHistograms(path.string());
+        check(path);
+        assert(nlohmann::json::parse(manager.SnapshotState()).at("variations").at("shift_up").at("cuts") == true);
+    }
+    {
+        AnalysisManager manager;
+        manager.InitRdfFromConfig(inputConfig.string());
+        manager.LoadCutConfig(cutConfig.string());
+        manager.ApplyAllRdfFilters();
+        manager.BookRdfHistogramsFromConfig(histogramConfig.string());
+        manager.WriteRdfHistograms((temp / "rdf.root").string());
+        check(temp / "rdf.root");
+    }
+
+    // An alias naming another branch: RDF must vary what the expanded cut and the compound expression read, as classic does.
+    const auto aliasInputConfig = temp / "alias-input.yaml";
+    const auto aliasCutConfig = temp / "alias-cuts.yaml";
+    const auto aliasHistogramConfig = temp / "alias-histograms.yaml";
+    WriteInputConfig(aliasInputConfig, {inputPath.string()}, {{"pt", "x"}, {"w", "w"}});
+    std::ofstream(aliasCutConfig) << "schema_version: 1\n"
+                                     "cuts:\n"
+                                     "  low: pt < 5\n"
+                                     "variations:\n"
+                                     "  shift_up:\n"
+                                     "    columns:\n"
+                                     "      pt: pt + 1\n";
+    std::ofstream(aliasHistogramConfig) << "schema_version: 1\n"
+                                           "variations:\n"
+                                           "  weight_up:\n"
+                                           "    weight: w\n"
+                                           "histograms:\n"
+                                           "  xh:\n"
+                                           "    expr: 2 * pt - pt\n"
+                                           "    bins: [10, 0, 10]\n";
+    {
+        AnalysisManager manager;
+        manager.LoadInputConfig(aliasInputConfig.string());
+        assert(manager.BuildChain());
+        manager.LoadCutConfig(aliasCutConfig.string());
+        manager.LoadHistogramConfig(aliasHistogramConfig.string());
+        manager.EnableAllCuts();
+        manager.RunEventLoop([](AnalysisManager &worker, Long64_t) { worker.FillSelectedHistograms(1.0); }, 1);
+        manager.WriteHistograms((temp / "alias-classic.root").string());
+    }
+    {
+        AnalysisManager manager;
+        manager.InitRdfFromConfig(aliasInputConfig.string());
+        manager.LoadCutConfig(aliasCutConfig.string());
+        manager.ApplyAllRdfFilters();
+        manager.BookRdfHistogramsFromConfig(aliasHistogramConfig.string());
+        manager.WriteRdfHistograms((temp / "alias-rdf.root").string());
+    }
+    check(temp / "alias-classic.root");
+    check(temp / "alias-rdf.root");
+    {
+        TFile classic((temp / "alias-classic.root").c_str(), "READ");
+        TFile rdf((temp / "alias-rdf.root").c_str(), "READ");
+        for (const char *name : {"hist_xh_", "hist_xh_shift_up", "hist_xh_weight_up"})
+        {
+            auto *expected = classic.Get<TH1>(name);
+            auto *actual = rdf.Get<TH1>(name);
+            assert(expected && actual);
+            for (int bin = 0; bin <= expected->GetNbinsX() + 1; ++bin)
+                assert(expected->GetBinContent(bin) == actual->GetBinContent(bin));
+        }
+    }
+
+    // Shifting x down moves x in [5, 6) into the varied selection. The selected-entry list keeps those events, so the
+    // shifted histogram filled over it matches a full loop, and a list stored without the variation is not reused.
+    const auto downCutConfig = temp / "down-cuts.yaml";
+    std::ofstream(downCutConfig) << "schema_version: 1\n"
+                                    "cuts:\n"
+                                    "  low: x < 5\n"
+                                    "variations:\n"
+                                    "  shift_down:\n"
+                                    "    columns:\n"
+                                    "      x: x - 1\n";
+    const auto selectionCache = temp / "selections";
+    std::filesystem::remove_all(selectionCache);
+    {
+        AnalysisManager manager;
+        manager.SetSelectionCacheDirectory(selectionCache.string());
+        manager.LoadInputConfig(inputConfig.string());
+        assert(manager.BuildChain());
+        manager.RegisterCut("low", "x < 5");
+        manager.EnableAllCuts();
+        assert(manager.GetSelectedEntries().size() == 50);
+    }
+    for (const bool selected : {false, true})
+    {
+        AnalysisManager manager;
+        manager.SetSelectionCacheDirectory(selectionCache.string());
+        manager.LoadInputConfig(inputConfig.string());
+        assert(manager.BuildChain());
+        manager.LoadCutConfig(downCutConfig.string());
+        manager.LoadHistogramConfig(histogramConfig.string());
+        manager.EnableAllCuts();
+        const auto fill = [](AnalysisManager &worker, Long64_t) { worker.FillSelectedHistograms(1.0); };
+        if (selected)
+        {
+            assert(manager.GetSelectedEntries().size() == 60);
+            manager.RunSelectedEventLoop(fill, 4);
+        }
+        else
+            manager.RunEventLoop(fill, 4);
+        const auto path = temp / (selected ? "down-selected.root" : "down-full.root");
+        manager.WriteHistograms(path.string());
+        TFile input(path.c_str(), "READ");
+        assert(input.Get<TH1>("hist_xh_")->GetEntries() == 50.0);
+        assert(input.Get<TH1>("hist_xh_shift_down")->GetEntries() == 60.0);
+        assert(input.Get<TH1>("hist_xh_shift_down")->GetBinContent(5) == 10.0);
+    }
+
+    AnalysisManager manager;
+    const auto path = temp / "invalid.yaml";
+    std::ofstream(path) << "schema_version: 1\nvariations:\n  up:\n    scale: 2\nhistograms:\n  xh:\n    expr: x\n    bins: [10, 0, 10]\n";
+    const auto result = manager.PreflightHistogramConfig(path.string());
+    assert(!result.Valid() && result.Errors.front().find("variations.up.scale") != std::string::npos);
+}
+
 void TestBorrowedRootObjectsRemainAlive()
 {
     TTree tree("borrowed_tree", "borrowed_tree");
@@ -1226,18 +2116,7 @@ void TestRdfSnapshotRunsOneEventLoop()
     std::filesystem::create_directories(temp);
     const auto inputPath = temp / "input.root";
     const auto outputPath = temp / "output.root";
-    {
-        TFile output(inputPath.c_str(), "RECREATE");
-        TTree tree("events", "events");
-        double raw = 0.0;
-        tree.Branch("raw", &raw, "raw/D");
-        for (const double value : {1.0, 2.0, 3.0})
-        {
-            raw = value;
-            tree.Fill();
-        }
-        tree.Write();
-    }
+    WriteEventsFile(inputPath, "raw", 3, [](int index) { return index + 1.0; });
 
     std::atomic<int> evaluations{0};
     AnalysisManager manager;
@@ -1267,6 +2146,305 @@ void TestRdfSnapshotRunsOneEventLoop()
     assert(forkTree->GetEntries() == 3);
 }
 
+void TestRdfRegions()
+{
+    ROOT::DisableImplicitMT();
+    const auto temp = std::filesystem::temp_directory_path() / "cascade-rdf-regions";
+    std::filesystem::create_directories(temp);
+    const auto inputPath = temp / "input.root";
+    const auto outputPath = temp / "regions.root";
+    WriteEventsFile(inputPath, "raw");
+
+    // Every region reads the same input pass: the tracked column is evaluated once per entry.
+    std::atomic<int> evaluations{0};
+    AnalysisManager manager;
+    manager.InitRdfFromFile("events", inputPath.string());
+    manager.DefineRdfVariable(
+        "x",
+        [&](double value)
+        {
+            ++evaluations;
+            return value;
+        },
+        {"raw"});
+    manager.RegisterCut("low", "x < 5");
+    manager.RegisterCut("high", "x >= 5");
+    manager.RegisterCut("central", "x >= 2.5 && x < 7.5");
+    manager.BookRdfHistogram1D("early", "", {10, 0, 10}, "x");
+    // A compound expression defines its column on the main lineage before the regions branch off it.
+    manager.BookRdfHistogram1D("doubled", "", {20, 0, 20}, "x * 2");
+    manager.DefineRegions({{"signal", {"low", "central"}}, {"control", {"high"}}});
+    manager.BookRdfHistogram1D("late", "", {10, 0, 10}, "x");
+    assert((manager.ListRegions() == std::vector<std::string>{"control", "signal"}));
+    manager.WriteRdfHistograms(outputPath.string());
+    assert(evaluations.load() == 100);
+
+    TFile input(outputPath.c_str(), "READ");
+    for (const char *name : {"hist_early_", "hist_doubled_", "hist_late_"})
+    {
+        assert(input.Get<TH1>(name)->GetEntries() == 100.0);
+        assert(input.Get<TH1>((std::string("signal/") + name).c_str())->GetEntries() == 25.0);
+        assert(input.Get<TH1>((std::string("control/") + name).c_str())->GetEntries() == 50.0);
+    }
+
+    bool rejected = false;
+    try
+    {
+        manager.DefineRegions({{"missing", {"unknown"}}});
+    }
+    catch (const std::runtime_error &)
+    {
+        rejected = true;
+    }
+    assert(rejected && manager.ListRegions().size() == 2);
+}
+
+void TestRdfSharedHistogramExpressions()
+{
+    ROOT::DisableImplicitMT();
+    const auto temp = std::filesystem::temp_directory_path() / "cascade-rdf-shared-expressions";
+    std::filesystem::create_directories(temp);
+    const auto inputPath = temp / "input.root";
+    const auto outputPath = temp / "histograms.root";
+    WriteEventsFile(inputPath);
+
+    AnalysisManager manager;
+    manager.InitRdfFromFile("events", inputPath.string());
+    for (const char *prefix : {"a", "b", "c"})
+        manager.BookRdfHistogram1D("doubled", prefix, {20, 0, 20}, "2 * x");
+    manager.BookRdfHistogram1D("shifted", "", {20, 0, 20}, "x + 1");
+
+    // One internal column per distinct expansion: "2 * x" for the three doubled histograms and "x + 1" for the last.
+    const auto defined = manager.GetDefinedVarNames();
+    assert(std::count_if(defined.begin(), defined.end(), [](const std::string &name) { return name.rfind("__cascade_", 0) == 0; }) == 2);
+    manager.WriteRdfHistograms(outputPath.string());
+
+    TFile input(outputPath.c_str(), "READ");
+    for (const char *name : {"hist_doubled_a", "hist_doubled_b", "hist_doubled_c"})
+        assert(input.Get<TH1>(name)->GetEntries() == 100.0 && std::abs(input.Get<TH1>(name)->GetMean() - 9.9) < 1e-9);
+    assert(input.Get<TH1>("hist_shifted_")->GetEntries() == 100.0);
+}
+
+void TestRdfRNTupleInputAndSnapshot()
+{
+#if ROOT_VERSION_CODE >= ROOT_VERSION(6, 36, 0)
+    ROOT::DisableImplicitMT();
+    const auto temp = std::filesystem::temp_directory_path() / "cascade-rdf-rntuple";
+    std::filesystem::create_directories(temp);
+    const auto treePath = temp / "tree.root";
+    const auto ntuplePath = temp / "ntuple.root";
+    const auto inputConfig = temp / "input.yaml";
+    WriteEventsFile(treePath);
+    {
+        AnalysisManager manager;
+        manager.InitRdfFromFile("events", treePath.string());
+        manager.WriteRdfSnapshot("events", ntuplePath.string(), TreeOpt::Om::Append, DataFormat::RNTuple);
+    }
+    std::ofstream(inputConfig) << "schema_version: 1\n"
+                                  "input:\n"
+                                  "  files: ["
+                               << ntuplePath.string()
+                               << "]\n"
+                                  "  ntuple: events\n"
+                                  "branches:\n"
+                                  "  xx:\n"
+                                  "    name: x\n";
+
+    AnalysisManager fromFile;
+    fromFile.InitRdfFromFile("events", ntuplePath.string());
+    assert(fromFile.GetInputFormat() == DataFormat::RNTuple);
+    assert(fromFile.GetEntryCount() == 100);
+
+    AnalysisManager fromConfig;
+    assert(fromConfig.PreflightInputConfig(inputConfig.string()).Valid());
+    fromConfig.InitRdfFromConfig(inputConfig.string());
+    fromConfig.RegisterCut("low", "xx < 5");
+    fromConfig.ApplyRdfFilter("low");
+    fromConfig.BookRdfHistogram1D("xx", "", {10, 0, 10}, "xx");
+    fromConfig.WriteRdfHistograms((temp / "histograms.root").string());
+    TFile histograms((temp / "histograms.root").c_str(), "READ");
+    assert(histograms.Get<TH1>("hist_xx_")->GetEntries() == 50.0);
+    assert(nlohmann::json::parse(fromConfig.SnapshotState()).at("format") == "rntuple");
+    assert(nlohmann::json::parse(fromFile.SnapshotState()).at("format") == "rntuple");
+
+    // Classic event loops need a TTree.
+    AnalysisManager classic;
+    classic.LoadInputConfig(inputConfig.string());
+    bool rejected = false;
+    try
+    {
+        classic.BuildChain();
+    }
+    catch (const std::runtime_error &)
+    {
+        rejected = true;
+    }
+    assert(rejected);
+#endif
+}
+
+void TestOutputSettings()
+{
+    ROOT::DisableImplicitMT();
+    const auto temp = std::filesystem::temp_directory_path() / "cascade-output-settings";
+    std::filesystem::create_directories(temp);
+    const auto inputPath = temp / "input.root";
+    const auto inputConfig = temp / "input.yaml";
+    const auto badConfig = temp / "bad.yaml";
+    WriteEventsFile(inputPath, "raw", 100, [](int index) { return index; });
+    WriteInputConfig(inputConfig, {inputPath.string()}, {{"raw", "raw"}},
+                     "output:\n  compression: zstd\n  compression_level: 3\n  auto_flush: 40\n  basket_size: 16384\n");
+    WriteInputConfig(badConfig, {inputPath.string()}, {{"raw", "raw"}}, "output:\n  compression: brotli\n  basket_size: 0\n");
+
+    AnalysisManager manager;
+    assert(manager.PreflightInputConfig(inputConfig.string()).Valid());
+    assert(manager.PreflightInputConfig(badConfig.string()).Errors.size() == 2);
+    manager.LoadInputConfig(inputConfig.string());
+    const OutputSettings &settings = manager.GetOutputSettings();
+    assert(settings.Algorithm == "zstd" && settings.Level == 3 && settings.AutoFlush == 40 && settings.BasketSize == 16384);
+    assert(settings.CompressionSettings() == 503);
+
+    // Classic tree output takes the auto-flush and basket size at creation and the compression when written.
+    manager.BuildChain();
+    manager.RegisterTree("skim");
+    manager.RegisterVariable("doubled");
+    assert(manager.AttachBranch("skim", "doubled", TreeOpt::Om::Recreate));
+    manager.WriteTrees((temp / "skim.root").string());
+    {
+        TFile skim((temp / "skim.root").c_str(), "READ");
+        auto *tree = skim.Get<TTree>("skim");
+        assert(tree && tree->GetAutoFlush() == 40);
+        assert(tree->GetBranch("doubled")->GetBasketSize() == 16384);
+        assert(tree->GetBranch("doubled")->GetCompressionAlgorithm() == ROOT::RCompressionSetting::EAlgorithm::kZSTD);
+    }
+
+    // A per-call setting overrides the manager's for that snapshot only.
+    AnalysisManager rdf;
+    rdf.InitRdfFromConfig(inputConfig.string());
+    OutputSettings lz4;
+    lz4.Algorithm = "lz4";
+    rdf.WriteRdfSnapshot("events", (temp / "lz4.root").string(), TreeOpt::Om::Append, DataFormat::TTree, lz4);
+    rdf.WriteRdfSnapshot("events", (temp / "zstd.root").string(), TreeOpt::Om::Append);
+    TFile lz4Output((temp / "lz4.root").c_str(), "READ");
+    assert(lz4Output.GetCompressionSettings() == 404);
+    TFile zstdOutput((temp / "zstd.root").c_str(), "READ");
+    assert(zstdOutput.GetCompressionSettings() == 503);
+    assert(zstdOutput.Get<TTree>("events")->GetEntries() == 100);
+
+    bool rejected = false;
+    try
+    {
+        OutputSettings unknown;
+        unknown.Algorithm = "brotli";
+        manager.SetOutputSettings(unknown);
+    }
+    catch (const std::invalid_argument &)
+    {
+        rejected = true;
+    }
+    assert(rejected);
+    // Snapshots take the auto-flush value as an int, so a wider one is rejected rather than truncated.
+    std::vector<std::string> errors;
+    assert(!OutputSettings::FromYaml(YAML::Load("auto_flush: 4294967336"), errors) && !errors.empty());
+}
+
+void TestRdfExpressionCache()
+{
+    ROOT::DisableImplicitMT();
+    const auto temp = std::filesystem::temp_directory_path() / "cascade-rdf-expression-cache";
+    std::filesystem::remove_all(temp);
+    std::filesystem::create_directories(temp);
+    const auto inputPath = temp / "input.root";
+    WriteEventsFile(inputPath);
+
+    // The first run interprets and compiles the expressions; the second finds all of them in the cached library.
+    const auto run = [&](const std::string &outputName)
+    {
+        AnalysisManager manager;
+        manager.SetRdfExpressionCacheDirectory((temp / "cache").string());
+        manager.InitRdfFromFile("events", inputPath.string());
+        manager.DefineRdfVariable("x2", "x * x");
+        manager.ApplyRdfFilter("low", "x2 < 25");
+        manager.BookRdfHistogram1D("shifted", "", {10, 0, 10}, "x + 1");
+        manager.WriteRdfHistograms((temp / outputName).string());
+        return manager.SaveRdfExpressionCache();
+    };
+    assert(run("first.root") == 3);
+    assert(run("second.root") == 0);
+
+    // The published library comes with a manifest of its three keys, which is all a later run reads until it needs one.
+    std::size_t manifests = 0;
+    for (const auto &release : std::filesystem::directory_iterator(temp / "cache"))
+        for (const auto &entry : std::filesystem::directory_iterator(release.path()))
+        {
+            if (entry.path().extension() != ".keys") continue;
+            assert(std::filesystem::exists(std::filesystem::path(entry.path()).replace_extension(".so")));
+            std::ifstream manifest(entry.path());
+            std::size_t keys = 0;
+            for (std::string key; std::getline(manifest, key);)
+                keys += key.size() == 64;
+            assert(keys == 3);
+            ++manifests;
+        }
+    assert(manifests == 1);
+
+    TFile first((temp / "first.root").c_str(), "READ");
+    TFile second((temp / "second.root").c_str(), "READ");
+    assert(first.Get<TH1>("hist_shifted_")->GetEntries() == 50.0);
+    assert(second.Get<TH1>("hist_shifted_")->GetEntries() == 50.0);
+    assert(first.Get<TH1>("hist_shifted_")->GetMean() == second.Get<TH1>("hist_shifted_")->GetMean());
+}
+
+void TestRdfLambdaLibrary()
+{
+    ROOT::DisableImplicitMT();
+    const auto temp = std::filesystem::temp_directory_path() / "cascade-rdf-lambda-library";
+    std::filesystem::create_directories(temp);
+    const auto inputPath = temp / "input.root";
+    const auto cutConfig = temp / "cuts.yaml";
+    const auto missingConfig = temp / "missing.yaml";
+    const auto writtenConfig = temp / "written.yaml";
+    const auto outputPath = temp / "histograms.root";
+    WriteEventsFile(inputPath);
+    std::ofstream(cutConfig) << "schema_version: 1\n"
+                                "cuts:\n"
+                                "  low: --lambda:test_x_below_5\n"
+                                "  central: x > 2.05\n";
+    std::ofstream(missingConfig) << "schema_version: 1\n"
+                                    "cuts:\n"
+                                    "  low: --lambda:test_not_registered\n";
+
+    LambdaManager::Library().RegisterFilter("test_x_below_5", [](double x) { return x < 5; }, {"x"});
+    LambdaManager::Library().RegisterDefine("test_x_squared", [](double x) { return x * x; }, {"x"});
+
+    AnalysisManager manager;
+    manager.InitRdfFromFile("events", inputPath.string());
+    assert(manager.PreflightCutConfig(cutConfig.string()).Valid());
+    assert(!manager.PreflightCutConfig(missingConfig.string()).Valid());
+    manager.DefineRdfVariable("x2", "--lambda:test_x_squared");
+    manager.LoadCutConfig(cutConfig.string());
+    manager.ApplyRdfFilters({"low", "central"});
+    manager.BookRdfHistogram1D("x2", "", {25, 0, 25}, "x2");
+    manager.WriteRdfHistograms(outputPath.string());
+    manager.WriteCutConfig(writtenConfig.string());
+
+    // The string cut keeps x >= 2.1 and the compiled filter keeps x < 5; the compiled define fills x * x.
+    TFile input(outputPath.c_str(), "READ");
+    assert(input.Get<TH1>("hist_x2_")->GetEntries() == 29.0 && input.Get<TH1>("hist_x2_")->GetMean() > 4.41);
+    assert(YAML::LoadFile(writtenConfig.string())["cuts"]["low"].as<std::string>() == "--lambda:test_x_below_5");
+
+    bool rejected = false;
+    try
+    {
+        manager.DefineRdfVariable("x3", "--lambda:test_x_below_5");
+    }
+    catch (const std::runtime_error &)
+    {
+        rejected = true;
+    }
+    assert(rejected);
+}
+
 void TestDagValidationAndReset()
 {
     ParamManager source;
@@ -1453,6 +2631,307 @@ void TestDagExecutionLanes()
     unsetenv("CASCADE_DAG_MAX_WORKERS");
 }
 
+void TestDagIncrementalScheduling()
+{
+    setenv("CASCADE_DAG_MAX_WORKERS", "4", 1);
+    // Every node checks that its dependencies finished before it started, across all lanes.
+    constexpr int nodeCount = 2000;
+    std::vector<std::atomic<bool>> finished(nodeCount);
+    std::atomic<bool> orderViolated{false};
+    DAGManager dag;
+    for (int index = 0; index < nodeCount; ++index)
+    {
+        std::vector<std::string> dependencies;
+        if (index >= 10) dependencies.push_back(std::to_string(index - 10));
+        if (index >= 10 && index / 3 != index - 10) dependencies.push_back(std::to_string(index / 3));
+        const auto lane = index % 97 == 0 ? DAGExecutionLane::Serial : (index % 13 == 0 ? DAGExecutionLane::Root : DAGExecutionLane::Parallel);
+        dag.AddNode(
+            std::to_string(index), dependencies,
+            [&, index, dependencies]()
+            {
+                for (const auto &dependency : dependencies)
+                    if (!finished[std::stoi(dependency)].load()) orderViolated.store(true);
+                finished[index].store(true);
+            },
+            lane);
+    }
+    assert(dag.Execute().Succeeded());
+    assert(!orderViolated.load());
+
+    // Without fail-fast a failure blocks its descendants transitively and everything else still runs.
+    DAGManager partial;
+    std::atomic<int> executed{0};
+    partial.AddNode("bad", {}, []() { throw std::runtime_error("bad"); }, DAGExecutionLane::Parallel);
+    partial.AddNode("child", {"bad", "good"}, [&]() { ++executed; }, DAGExecutionLane::Parallel);
+    partial.AddNode("grandchild", {"child"}, [&]() { ++executed; });
+    partial.AddNode("good", {}, [&]() { ++executed; }, DAGExecutionLane::Parallel);
+    partial.AddNode("after-good", {"good"}, [&]() { ++executed; }, DAGExecutionLane::Root);
+    assert(partial.Execute(false).Failed());
+    assert(executed.load() == 2);
+    for (const auto &node : partial.GetNodeResults())
+    {
+        if (node.Name == "child") assert(node.Blocked() && node.Message == "Blocked by dependency: bad");
+        if (node.Name == "grandchild") assert(node.Blocked() && node.Message == "Blocked by dependency: child");
+    }
+    unsetenv("CASCADE_DAG_MAX_WORKERS");
+}
+
+void TestDagWorkerPoolReuse()
+{
+    setenv("CASCADE_DAG_MAX_WORKERS", "2", 1);
+    std::mutex threadsMutex;
+    std::set<std::thread::id> threads;
+    std::atomic<int> running{0};
+    std::atomic<int> maximumRunning{0};
+    DAGManager dag;
+    for (int index = 0; index < 8; ++index)
+        dag.AddNode(
+            "node" + std::to_string(index), index < 4 ? std::vector<std::string>{} : std::vector<std::string>{"node" + std::to_string(index - 4)},
+            [&]()
+            {
+                const int now = running.fetch_add(1) + 1;
+                int observed = maximumRunning.load();
+                while (now > observed && !maximumRunning.compare_exchange_weak(observed, now))
+                {
+                }
+                {
+                    std::lock_guard<std::mutex> lock(threadsMutex);
+                    threads.insert(std::this_thread::get_id());
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(5));
+                running.fetch_sub(1);
+            },
+            DAGExecutionLane::Parallel);
+    assert(dag.Execute().Succeeded());
+    const std::set<std::thread::id> firstRun = threads;
+    assert(firstRun.size() <= 2);
+
+    // The same workers serve later runs of the DAG.
+    dag.Reset();
+    assert(dag.Execute().Succeeded());
+    assert(threads == firstRun);
+    assert(maximumRunning.load() <= 2);
+
+    // A tighter bound is honoured on the next run even though the pool already exists.
+    setenv("CASCADE_DAG_MAX_WORKERS", "1", 1);
+    maximumRunning.store(0);
+    dag.Reset();
+    assert(dag.Execute().Succeeded());
+    assert(maximumRunning.load() == 1);
+    unsetenv("CASCADE_DAG_MAX_WORKERS");
+}
+
+void TestDagCriticalPathPriority()
+{
+    setenv("CASCADE_DAG_MAX_WORKERS", "1", 1);
+    std::mutex orderMutex;
+    std::vector<std::string> order;
+    DAGManager dag;
+    const auto record = [&](const std::string &name)
+    {
+        return [&, name]()
+        {
+            std::lock_guard<std::mutex> lock(orderMutex);
+            order.push_back(name);
+        };
+    };
+    for (int index = 0; index < 3; ++index)
+        dag.AddNode("short" + std::to_string(index), {}, record("short" + std::to_string(index)), DAGExecutionLane::Parallel);
+    dag.AddNode("tail0", {}, record("tail0"), DAGExecutionLane::Parallel);
+    dag.AddNode("tail1", {"tail0"}, record("tail1"), DAGExecutionLane::Parallel);
+    dag.AddNode("tail2", {"tail1"}, record("tail2"), DAGExecutionLane::Parallel);
+
+    // Without recorded durations ready nodes start in topological order.
+    assert(dag.Execute().Succeeded());
+    assert(order.front() == "short0");
+
+    // The long chain starts first once its durations are known; unknown nodes count as the mean.
+    for (const auto &name : {"tail0", "tail1", "tail2"})
+        dag.SetExpectedDuration(name, 30.0);
+    dag.SetExpectedDuration("short0", 1.0);
+    order.clear();
+    dag.Reset();
+    assert(dag.Execute().Succeeded());
+    assert(order.front() == "tail0");
+    assert(std::find(order.begin(), order.end(), "tail1") < std::find(order.begin(), order.end(), "short0"));
+    unsetenv("CASCADE_DAG_MAX_WORKERS");
+
+    bool rejected = false;
+    try
+    {
+        dag.SetExpectedDuration("tail0", -1.0);
+    }
+    catch (const std::invalid_argument &)
+    {
+        rejected = true;
+    }
+    assert(rejected);
+    rejected = false;
+    try
+    {
+        dag.SetExpectedDuration("missing", 1.0);
+    }
+    catch (const std::runtime_error &)
+    {
+        rejected = true;
+    }
+    assert(rejected);
+
+    ModuleRunManifest manifest;
+    manifest.Status = ModuleStatus::Done;
+    manifest.StartedAt = "2026-01-01T23:59:58.250000Z";
+    manifest.FinishedAt = "2026-01-02T00:00:01.000000Z";
+    const auto seconds = ProvenanceRecorder::ModuleRunSeconds(manifest);
+    assert(seconds && std::abs(*seconds - 2.75) < 1e-6);
+    manifest.Status = ModuleStatus::Failed;
+    assert(!ProvenanceRecorder::ModuleRunSeconds(manifest));
+}
+
+void TestDagResourcePacking()
+{
+    setenv("CASCADE_DAG_MAX_WORKERS", "4", 1);
+    setenv("CASCADE_DAG_MEMORY_MB", "1000", 1);
+    std::mutex usageMutex;
+    std::size_t threadsInUse = 0;
+    std::size_t memoryInUse = 0;
+    std::size_t maximumThreads = 0;
+    std::size_t maximumMemory = 0;
+    std::map<std::string, unsigned int> granted;
+    DAGManager dag;
+    // Usage is tracked with the shares the scheduler holds: requests above a budget are capped at it.
+    const auto add = [&](const std::string &name, unsigned int threads, std::size_t memory)
+    {
+        const std::size_t heldThreads = std::min(threads, 4U);
+        dag.AddNode(
+            name, {},
+            [&, name, heldThreads, memory]()
+            {
+                {
+                    std::lock_guard<std::mutex> lock(usageMutex);
+                    threadsInUse += heldThreads;
+                    memoryInUse += memory;
+                    maximumThreads = std::max(maximumThreads, threadsInUse);
+                    maximumMemory = std::max(maximumMemory, memoryInUse);
+                    granted[name] = CascadeNodeThreads();
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(5));
+                std::lock_guard<std::mutex> lock(usageMutex);
+                threadsInUse -= heldThreads;
+                memoryInUse -= memory;
+            },
+            DAGExecutionLane::Parallel);
+        dag.SetNodeResources(name, {threads, memory});
+    };
+    add("wide", 8, 0);
+    for (int index = 0; index < 4; ++index)
+        add("narrow" + std::to_string(index), 1, 0);
+    add("large0", 1, 600);
+    add("large1", 1, 600);
+    add("cached", 0, 0);
+    assert(dag.Execute().Succeeded());
+    assert(maximumThreads <= 4);
+    assert(maximumMemory <= 1000);
+    assert(granted.at("wide") == 4);
+    assert(granted.at("narrow0") == 1);
+    assert(granted.at("cached") == 1);
+    assert(CascadeNodeThreads() == 0);
+
+    // Parallel-lane nodes run beside others that share ROOT's thread pool, so they may not resize it.
+    bool parallelRejected = false;
+    DAGManager lanes;
+    lanes.AddNode(
+        "parallel", {},
+        [&]()
+        {
+            try
+            {
+                AnalysisManager().EnableMT(1);
+            }
+            catch (const std::runtime_error &)
+            {
+                parallelRejected = true;
+            }
+        },
+        DAGExecutionLane::Parallel);
+    assert(lanes.Execute().Succeeded() && parallelRejected && !CascadeParallelNode());
+
+    bool rejected = false;
+    try
+    {
+        dag.SetNodeResources("missing", {});
+    }
+    catch (const std::runtime_error &)
+    {
+        rejected = true;
+    }
+    assert(rejected);
+    unsetenv("CASCADE_DAG_MEMORY_MB");
+    unsetenv("CASCADE_DAG_MAX_WORKERS");
+}
+
+void TestDagSerialExecutor()
+{
+    setenv("CASCADE_DAG_MAX_WORKERS", "2", 1);
+    const auto waitFor = [](const std::atomic<bool> &flag)
+    {
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+        while (!flag.load() && std::chrono::steady_clock::now() < deadline) std::this_thread::yield();
+        return flag.load();
+    };
+    std::atomic<bool> serialStarted{false};
+    std::atomic<bool> pooledStarted{false};
+    std::atomic<bool> serialSawPooled{false};
+    std::atomic<bool> pooledSawSerial{false};
+    std::atomic<int> serialRunning{0};
+    std::atomic<int> rootRunning{0};
+    std::atomic<bool> exclusiveOverlap{false};
+    const auto exclusive = [&](std::atomic<int> &own, const std::atomic<int> &other)
+    {
+        if (own.fetch_add(1) != 0 || other.load() != 0) exclusiveOverlap.store(true);
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        own.fetch_sub(1);
+    };
+
+    // A serial node and a pooled node wait for each other, so the run only succeeds quickly if they overlap.
+    DAGManager dag;
+    dag.AddNode(
+        "bookkeeping", {},
+        [&]()
+        {
+            serialStarted.store(true);
+            serialSawPooled.store(waitFor(pooledStarted));
+            exclusive(serialRunning, rootRunning);
+        });
+    dag.AddNode(
+        "pooled", {},
+        [&]()
+        {
+            pooledStarted.store(true);
+            pooledSawSerial.store(waitFor(serialStarted));
+        },
+        DAGExecutionLane::Parallel);
+    for (int index = 0; index < 3; ++index)
+    {
+        dag.AddNode("serial" + std::to_string(index), {"bookkeeping"}, [&]() { exclusive(serialRunning, rootRunning); });
+        dag.AddNode("root" + std::to_string(index), {"pooled"}, [&]() { exclusive(rootRunning, serialRunning); }, DAGExecutionLane::Root);
+    }
+    assert(dag.Execute().Succeeded());
+    assert(serialSawPooled.load());
+    assert(pooledSawSerial.load());
+    assert(!exclusiveOverlap.load());
+
+    // Fail-fast stops the serial executor like the pool: later serial nodes stay Pending.
+    DAGManager failing;
+    failing.AddNode("bad", {}, []() { throw std::runtime_error("bad"); }, DAGExecutionLane::Parallel);
+    failing.AddNode("first", {}, []() { std::this_thread::sleep_for(std::chrono::milliseconds(20)); });
+    failing.AddNode("second", {"first"}, []() {});
+    const auto result = failing.Execute();
+    assert(result.Failed());
+    for (const auto &node : result.Nodes)
+        if (node.Name == "second") assert(node.Status == DAGNodeStatus::Pending);
+    unsetenv("CASCADE_DAG_MAX_WORKERS");
+}
+
 void TestPluginTrustPolicy()
 {
     const std::string className = "CascadeVerifiedPolicyModule";
@@ -1706,11 +3185,32 @@ int main()
     TestLoggerContract();
     TestParamRoundTrip();
     TestAnalysisConfigExpressions();
+    TestPreflightConfigs();
+    TestCompiledExpressions();
+    TestClassicEventLoopThreads();
+    TestClassicCutflow();
+    TestRdfCutflow();
+    TestChainIndex();
+    TestSelectionCache();
+    TestInputReadOptimization();
+    TestHistogramShapes();
+    TestSystematicVariations();
     TestBorrowedRootObjectsRemainAlive();
     TestPlotDoesNotMutateInputs();
     TestRdfSnapshotRunsOneEventLoop();
+    TestRdfRegions();
+    TestRdfSharedHistogramExpressions();
+    TestRdfLambdaLibrary();
+    TestRdfExpressionCache();
+    TestRdfRNTupleInputAndSnapshot();
+    TestOutputSettings();
     TestDagValidationAndReset();
     TestDagExecutionLanes();
+    TestDagIncrementalScheduling();
+    TestDagWorkerPoolReuse();
+    TestDagCriticalPathPriority();
+    TestDagResourcePacking();
+    TestDagSerialExecutor();
     std::filesystem::remove_all(runtimeRoot);
     return 0;
 }
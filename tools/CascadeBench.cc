@@ -0,0 +1,727 @@
+#include "AnalysisManager.hh"
+#include "DAGManager.hh"
+#include "Logger.hh"
+
+#include <RVersion.h>
+#include <TFile.h>
+#include <TH1D.h>
+#include <TLorentzVector.h>
+#include <TRandom3.h>
+#include <TTree.h>
+#include <TTreeFormula.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <memory>
+#include <random>
+#include <regex>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+namespace
+{
+using Clock = std::chrono::steady_clock;
+
+struct BenchOptions
+{
+    Long64_t Events = 200000;
+    int Histograms = 60;
+    std::filesystem::path WorkDirectory = std::filesystem::temp_directory_path() / "cascade-bench";
+};
+
+double SecondsSince(Clock::time_point start) { return std::chrono::duration<double>(Clock::now() - start).count(); }
+
+void PrintRate(const std::string &label, Long64_t events, double seconds, double reference = 0.0)
+{
+    const double rate = seconds > 0.0 ? static_cast<double>(events) / seconds : 0.0;
+    std::cout << "  " << std::left << std::setw(28) << label << std::right << std::setw(14) << std::fixed << std::setprecision(0)
+              << rate << " events/s";
+    if (reference > 0.0) std::cout << "  (" << std::setprecision(2) << reference / seconds << "x)";
+    std::cout << '\n';
+}
+
+// The toy sample mixes every supported scalar type so that value dispatch is exercised the same way as in real ntuples.
+std::filesystem::path WriteToySample(const BenchOptions &options)
+{
+    std::filesystem::create_directories(options.WorkDirectory);
+    const auto path = options.WorkDirectory / "toy-events.root";
+    TFile output(path.c_str(), "RECREATE");
+    if (output.IsZombie()) throw std::runtime_error("cascade-bench: cannot create toy sample: " + path.string());
+    TTree tree("events", "events");
+    float pt = 0.0F;
+    float eta = 0.0F;
+    float phi = 0.0F;
+    double mass = 0.0;
+    int nJets = 0;
+    unsigned int lumi = 0;
+    Long64_t event = 0;
+    bool trigger = false;
+    tree.Branch("pt", &pt, "pt/F");
+    tree.Branch("eta", &eta, "eta/F");
+    tree.Branch("phi", &phi, "phi/F");
+    tree.Branch("mass", &mass, "mass/D");
+    tree.Branch("n_jets", &nJets, "n_jets/I");
+    tree.Branch("lumi", &lumi, "lumi/i");
+    tree.Branch("event", &event, "event/L");
+    tree.Branch("trigger", &trigger, "trigger/O");
+
+    std::mt19937_64 generator(20260101);
+    std::exponential_distribution<float> ptDistribution(1.0F / 30.0F);
+    std::normal_distribution<float> etaDistribution(0.0F, 1.5F);
+    std::uniform_real_distribution<float> phiDistribution(-3.14159F, 3.14159F);
+    std::normal_distribution<double> massDistribution(91.2, 8.0);
+    std::poisson_distribution<int> jetDistribution(2.5);
+    for (Long64_t index = 0; index < options.Events; ++index)
+    {
+        pt = ptDistribution(generator);
+        eta = etaDistribution(generator);
+        phi = phiDistribution(generator);
+        mass = massDistribution(generator);
+        nJets = jetDistribution(generator);
+        lumi = static_cast<unsigned int>(index / 1000);
+        event = index;
+        trigger = pt > 20.0F;
+        tree.Fill();
+    }
+    tree.Write();
+    output.Close();
+    return path;
+}
+
+// The toy dimuon plugin's sample: its generator at the default parameters, with the same "Events" branches. The plugin
+// is built and installed separately, so the bench writes the sample itself rather than running the module.
+std::filesystem::path WriteDimuonSample(const BenchOptions &options)
+{
+    constexpr double muonMass = 0.1056583755;
+    constexpr double pi = 3.14159265358979323846;
+    constexpr double poleMass = 91.1876;
+    constexpr double naturalWidth = 2.4952;
+    constexpr double minimumMass = 60.0;
+    constexpr double maximumMass = 120.0;
+    constexpr double backgroundSlope = 0.025;
+    constexpr double momentumResolution = 0.012;
+    std::filesystem::create_directories(options.WorkDirectory);
+    const auto path = options.WorkDirectory / "toy-dimuons.root";
+    TFile output(path.c_str(), "RECREATE");
+    if (output.IsZombie()) throw std::runtime_error("cascade-bench: cannot create dimuon sample: " + path.string());
+    TTree tree("Events", "Toy dimuon candidates");
+    int event = 0;
+    int mu1Charge = -1;
+    int mu2Charge = 1;
+    bool isSignal = false;
+    double weight = 1.0;
+    double generatedMass = 0.0;
+    double mu1Pt = 0.0;
+    double mu1Eta = 0.0;
+    double mu1Phi = 0.0;
+    double mu2Pt = 0.0;
+    double mu2Eta = 0.0;
+    double mu2Phi = 0.0;
+    tree.Branch("event", &event);
+    tree.Branch("is_signal", &isSignal);
+    tree.Branch("weight", &weight);
+    tree.Branch("generated_mass", &generatedMass);
+    tree.Branch("mu1_pt", &mu1Pt);
+    tree.Branch("mu1_eta", &mu1Eta);
+    tree.Branch("mu1_phi", &mu1Phi);
+    tree.Branch("mu1_charge", &mu1Charge);
+    tree.Branch("mu2_pt", &mu2Pt);
+    tree.Branch("mu2_eta", &mu2Eta);
+    tree.Branch("mu2_phi", &mu2Phi);
+    tree.Branch("mu2_charge", &mu2Charge);
+
+    TRandom3 random(42);
+    for (event = 0; event < options.Events; ++event)
+    {
+        isSignal = random.Uniform() < 0.65;
+        if (isSignal)
+        {
+            do
+                generatedMass = random.BreitWigner(poleMass, naturalWidth);
+            while (generatedMass < minimumMass || generatedMass > maximumMass);
+        }
+        else
+            generatedMass = minimumMass - std::log(1.0 - random.Uniform() * (1.0 - std::exp(-backgroundSlope * (maximumMass - minimumMass)))) /
+                                              backgroundSlope;
+
+        const double momentum = std::sqrt(std::max(0.0, generatedMass * generatedMass / 4.0 - muonMass * muonMass));
+        const double cosine = random.Uniform(-1.0, 1.0);
+        const double sine = std::sqrt(std::max(0.0, 1.0 - cosine * cosine));
+        const double decayPhi = random.Uniform(-pi, pi);
+        TLorentzVector muon1(momentum * sine * std::cos(decayPhi), momentum * sine * std::sin(decayPhi), momentum * cosine, generatedMass / 2.0);
+        TLorentzVector muon2(-muon1.Px(), -muon1.Py(), -muon1.Pz(), generatedMass / 2.0);
+
+        const double pairPt = std::min(random.Exp(18.0), 120.0);
+        const double pairPhi = random.Uniform(-pi, pi);
+        double pairRapidity = 0.0;
+        do
+            pairRapidity = random.Gaus(0.0, 1.15);
+        while (std::abs(pairRapidity) > 2.2);
+        const double transverseMass = std::sqrt(generatedMass * generatedMass + pairPt * pairPt);
+        const TLorentzVector pair(pairPt * std::cos(pairPhi), pairPt * std::sin(pairPhi), transverseMass * std::sinh(pairRapidity),
+                                  transverseMass * std::cosh(pairRapidity));
+        muon1.Boost(pair.BoostVector());
+        muon2.Boost(pair.BoostVector());
+        const double smear1 = std::max(0.1, random.Gaus(1.0, momentumResolution));
+        const double smear2 = std::max(0.1, random.Gaus(1.0, momentumResolution));
+        muon1.SetPtEtaPhiM(muon1.Pt() * smear1, muon1.Eta(), muon1.Phi(), muonMass);
+        muon2.SetPtEtaPhiM(muon2.Pt() * smear2, muon2.Eta(), muon2.Phi(), muonMass);
+
+        mu1Charge = random.Uniform() < 0.5 ? -1 : 1;
+        mu2Charge = -mu1Charge;
+        mu1Pt = muon1.Pt();
+        mu1Eta = muon1.Eta();
+        mu1Phi = muon1.Phi();
+        mu2Pt = muon2.Pt();
+        mu2Eta = muon2.Eta();
+        mu2Phi = muon2.Phi();
+        tree.Fill();
+    }
+    tree.Write();
+    output.Close();
+    return path;
+}
+
+std::filesystem::path WriteToyInputConfig(const BenchOptions &options, const std::filesystem::path &sample)
+{
+    const auto path = options.WorkDirectory / "toy-input.yaml";
+    std::ofstream output(path);
+    output << "schema_version: 1\n"
+              "input:\n"
+              "  files: ["
+           << sample.string()
+           << "]\n"
+              "  tree: events\n"
+              "branches:\n";
+    for (const auto &[alias, name, type] : std::vector<std::tuple<std::string, std::string, std::string>>{
+             {"pt", "pt", "Float_t"},
+             {"eta", "eta", "Float_t"},
+             {"phi", "phi", "Float_t"},
+             {"mass", "mass", "Double_t"},
+             {"njets", "n_jets", "Int_t"},
+             {"lumi", "lumi", "UInt_t"},
+             {"event", "event", "Long64_t"},
+             {"trigger", "trigger", "Bool_t"}})
+        output << "  " << alias << ":\n    name: " << name << "\n    type: " << type << '\n';
+    if (!output) throw std::runtime_error("cascade-bench: cannot write input config: " + path.string());
+    return path;
+}
+
+// Two thirds of the booked histograms read plain aliases, the rest go through tree formulas.
+std::filesystem::path WriteToyHistogramConfig(const BenchOptions &options)
+{
+    static const std::vector<std::pair<std::string, std::string>> expressions{
+        {"pt", "[50, 0, 250]"},           {"eta", "[50, -5, 5]"},          {"phi", "[32, -3.2, 3.2]"},
+        {"mass", "[60, 60, 120]"},        {"njets", "[10, 0, 10]"},        {"pt * cosh(eta)", "[50, 0, 1000]"},
+        {"lumi", "[200, 0, 200]"},        {"trigger", "[2, 0, 2]"},        {"mass * mass / 1000", "[50, 0, 20]"},
+    };
+    const auto path = options.WorkDirectory / "toy-histograms.yaml";
+    std::ofstream output(path);
+    output << "schema_version: 1\nhistograms:\n";
+    for (int index = 0; index < options.Histograms; ++index)
+    {
+        const auto &[expression, bins] = expressions[static_cast<std::size_t>(index) % expressions.size()];
+        output << "  h" << index << ":\n    expr: " << expression << "\n    bins: " << bins << '\n';
+    }
+    if (!output) throw std::runtime_error("cascade-bench: cannot write histogram config: " + path.string());
+    return path;
+}
+
+TChain *PrepareManager(AnalysisManager &manager, const std::filesystem::path &inputConfig, const std::filesystem::path &histogramConfig)
+{
+    manager.LoadInputConfig(inputConfig.string());
+    TChain *chain = manager.BuildChain();
+    if (!chain) throw std::runtime_error("cascade-bench: toy chain cannot be built");
+    manager.LoadHistogramConfig(histogramConfig.string());
+    return chain;
+}
+
+int BenchFillPlan(const BenchOptions &options)
+{
+    const auto sample = WriteToySample(options);
+    const auto inputConfig = WriteToyInputConfig(options, sample);
+    const auto histogramConfig = WriteToyHistogramConfig(options);
+    std::cout << "fill-plan: " << options.Events << " events, " << options.Histograms << " histograms\n";
+
+    double loadOnly = 0.0;
+    {
+        AnalysisManager manager;
+        PrepareManager(manager, inputConfig, histogramConfig);
+        const auto start = Clock::now();
+        for (Long64_t index = 0; index < options.Events; ++index)
+            manager.LoadEvent(index);
+        loadOnly = SecondsSince(start);
+        PrintRate("event loading only", options.Events, loadOnly);
+    }
+
+    // Reference: the per-event algorithm FillHistograms used before the fill plan, i.e. copy the expression out of the
+    // nested maps, probe the branch tables by name, and look the lazily created formula up again for every histogram.
+    double stringDispatch = 0.0;
+    {
+        AnalysisManager manager;
+        TChain *chain = PrepareManager(manager, inputConfig, histogramConfig);
+        const YAML::Node histograms = YAML::LoadFile(histogramConfig.string())["histograms"];
+        const std::set<std::string> aliases{"pt", "eta", "phi", "mass", "njets", "lumi", "event", "trigger"};
+        std::map<std::string, std::map<std::string, std::string>> expressions;
+        std::map<std::string, std::map<std::string, std::unique_ptr<TH1D>>> data;
+        std::map<std::string, std::map<std::string, std::unique_ptr<TTreeFormula>>> formulas;
+        for (const auto &entry : histograms)
+        {
+            const std::string alias = entry.first.as<std::string>();
+            expressions[alias][""] = entry.second["expr"].as<std::string>();
+            data[alias][""] = std::make_unique<TH1D>(("reference_" + alias).c_str(), "", 50, 0.0, 100.0);
+            data[alias][""]->SetDirectory(nullptr);
+        }
+        const auto start = Clock::now();
+        for (Long64_t index = 0; index < options.Events; ++index)
+        {
+            manager.LoadEvent(index);
+            for (const auto &[alias, inmap] : data)
+                for (const auto &[prefix, hist] : inmap)
+                {
+                    const std::string expression = expressions.count(alias) && expressions.at(alias).count(prefix)
+                                                       ? expressions.at(alias).at(prefix)
+                                                       : alias;
+                    double value = 0.0;
+                    if (aliases.count(expression))
+                        value = manager.GetValue(expression);
+                    else
+                    {
+                        auto &formula = formulas[alias][prefix];
+                        if (!formula) formula = std::make_unique<TTreeFormula>(("reference_" + alias).c_str(), expression.c_str(), chain);
+                        value = formula->EvalInstance();
+                    }
+                    hist->Fill(value, 1.0);
+                }
+        }
+        stringDispatch = SecondsSince(start);
+        PrintRate("string-keyed dispatch", options.Events, stringDispatch);
+    }
+
+    {
+        AnalysisManager manager;
+        PrepareManager(manager, inputConfig, histogramConfig);
+        const auto start = Clock::now();
+        for (Long64_t index = 0; index < options.Events; ++index)
+        {
+            manager.LoadEvent(index);
+            manager.FillHistograms(1.0);
+        }
+        const double seconds = SecondsSince(start);
+        PrintRate("compiled fill plan", options.Events, seconds, stringDispatch);
+        const double fillOnlyBefore = stringDispatch - loadOnly;
+        const double fillOnlyAfter = seconds - loadOnly;
+        if (fillOnlyBefore > 0.0 && fillOnlyAfter > 0.0)
+            std::cout << "  fill cost per event: " << std::setprecision(1) << 1e9 * fillOnlyBefore / static_cast<double>(options.Events)
+                      << " ns -> " << 1e9 * fillOnlyAfter / static_cast<double>(options.Events) << " ns\n";
+    }
+
+    {
+        AnalysisManager manager;
+        PrepareManager(manager, inputConfig, histogramConfig);
+        manager.SetFillBufferSize(4096);
+        const auto start = Clock::now();
+        for (Long64_t index = 0; index < options.Events; ++index)
+        {
+            manager.LoadEvent(index);
+            manager.FillHistograms(1.0);
+        }
+        manager.FlushHistograms();
+        PrintRate("buffered fill plan (4096)", options.Events, SecondsSince(start), stringDispatch);
+    }
+    return 0;
+}
+
+// Thirty cuts of the shape real selections use: thresholds, windows, and a few derived kinematic quantities.
+std::vector<std::pair<std::string, std::string>> ToyCuts()
+{
+    std::vector<std::pair<std::string, std::string>> cuts;
+    for (int index = 0; index < 10; ++index)
+    {
+        const std::string suffix = std::to_string(index);
+        cuts.emplace_back("pt_" + suffix, "pt > " + std::to_string(index) + " * 0.5");
+        cuts.emplace_back("window_" + suffix, "abs(mass - 91.2) < " + std::to_string(30 + index) + " && abs(eta) < 4.5");
+        cuts.emplace_back("kinematic_" + suffix, "pt * cosh(eta) > " + std::to_string(index) + " || njets >= 0");
+    }
+    return cuts;
+}
+
+int BenchCuts(const BenchOptions &options)
+{
+    const auto sample = WriteToySample(options);
+    const auto inputConfig = WriteToyInputConfig(options, sample);
+    const auto cuts = ToyCuts();
+    std::cout << "cuts: " << options.Events << " events, " << cuts.size() << " cuts\n";
+
+    const auto prepare = [&](AnalysisManager &manager)
+    {
+        manager.LoadInputConfig(inputConfig.string());
+        TChain *chain = manager.BuildChain();
+        if (!chain) throw std::runtime_error("cascade-bench: toy chain cannot be built");
+        for (const auto &[name, expression] : cuts)
+            manager.RegisterCut(name, expression);
+        manager.EnableAllCuts();
+        return chain;
+    };
+
+    Long64_t reference = 0;
+    double formulaSeconds = 0.0;
+    {
+        AnalysisManager manager;
+        TChain *chain = prepare(manager);
+        std::vector<std::unique_ptr<TTreeFormula>> formulas;
+        const std::map<std::string, std::string> aliases{{"njets", "n_jets"}};
+        for (const auto &[name, expression] : cuts)
+        {
+            std::string expanded = expression;
+            for (const auto &[alias, branch] : aliases)
+                for (std::size_t position = expanded.find(alias); position != std::string::npos; position = expanded.find(alias))
+                    expanded.replace(position, alias.size(), branch);
+            formulas.push_back(std::make_unique<TTreeFormula>(("reference_" + name).c_str(), expanded.c_str(), chain));
+        }
+        const auto start = Clock::now();
+        for (Long64_t index = 0; index < options.Events; ++index)
+        {
+            manager.LoadEvent(index);
+            reference += std::all_of(formulas.begin(), formulas.end(), [](const auto &formula) { return formula->EvalInstance() != 0.0; });
+        }
+        formulaSeconds = SecondsSince(start);
+        PrintRate("TTreeFormula", options.Events, formulaSeconds);
+    }
+    {
+        AnalysisManager manager;
+        prepare(manager);
+        Long64_t passed = 0;
+        const auto start = Clock::now();
+        for (Long64_t index = 0; index < options.Events; ++index)
+        {
+            manager.LoadEvent(index);
+            passed += manager.PassesAllCuts();
+        }
+        PrintRate("compiled PassesAllCuts", options.Events, SecondsSince(start), formulaSeconds);
+        if (passed != reference) throw std::runtime_error("cascade-bench: compiled cuts disagree with TTreeFormula");
+    }
+    {
+        AnalysisManager manager;
+        prepare(manager);
+        std::vector<Long64_t> selected;
+        const auto start = Clock::now();
+        const Long64_t passed = manager.SelectEntries(0, options.Events, selected);
+        PrintRate("compiled SelectEntries", options.Events, SecondsSince(start), formulaSeconds);
+        if (passed != reference) throw std::runtime_error("cascade-bench: block selection disagrees with TTreeFormula");
+    }
+    return 0;
+}
+
+// A wide ntuple configuration: the toy branches under their usual aliases plus numbered aliases of the same branches.
+std::map<std::string, std::string> WriteWideInputConfig(const BenchOptions &options, const std::filesystem::path &sample, int aliases)
+{
+    static const std::vector<std::string> branches{"pt", "eta", "phi", "mass", "n_jets", "lumi", "event", "trigger"};
+    std::map<std::string, std::string> table{{"pt", "pt"},     {"eta", "eta"},   {"phi", "phi"},     {"mass", "mass"},
+                                             {"njets", "n_jets"}, {"lumi", "lumi"}, {"event", "event"}, {"trigger", "trigger"}};
+    for (int index = 0; static_cast<int>(table.size()) < aliases; ++index)
+        table.emplace("jet" + std::to_string(index) + "_" + branches[static_cast<std::size_t>(index) % branches.size()],
+                      branches[static_cast<std::size_t>(index) % branches.size()]);
+    const auto path = options.WorkDirectory / "toy-wide-input.yaml";
+    std::ofstream output(path);
+    output << "schema_version: 1\ninput:\n  files: [" << sample.string() << "]\n  tree: events\nbranches:\n";
+    for (const auto &[alias, name] : table)
+        output << "  " << alias << ":\n    name: " << name << '\n';
+    if (!output) throw std::runtime_error("cascade-bench: cannot write input config: " + path.string());
+    return table;
+}
+
+int BenchAliases(const BenchOptions &options)
+{
+    constexpr int ALIASES = 500;
+    constexpr int EXPRESSIONS = 2000;
+    BenchOptions sampleOptions = options;
+    sampleOptions.Events = std::min<Long64_t>(options.Events, 1000);
+    const auto sample = WriteToySample(sampleOptions);
+    const auto table = WriteWideInputConfig(options, sample, ALIASES);
+    const std::vector<std::string> aliases = [&table]
+    {
+        std::vector<std::string> names;
+        for (const auto &[alias, _] : table)
+            names.push_back(alias);
+        return names;
+    }();
+
+    std::mt19937_64 generator(20260102);
+    std::uniform_int_distribution<std::size_t> pick(0, aliases.size() - 1);
+    std::vector<std::string> expressions;
+    for (int index = 0; index < EXPRESSIONS; ++index)
+        expressions.push_back(aliases[pick(generator)] + " > 20 && abs(" + aliases[pick(generator)] + " - " + aliases[pick(generator)] +
+                              ") < 2.5 || sqrt(" + aliases[pick(generator)] + " * " + aliases[pick(generator)] + ") > 1e3");
+    std::cout << "aliases: " << table.size() << " aliases, " << expressions.size() << " expressions\n";
+
+    const auto print = [](const std::string &label, double seconds, double reference = 0.0)
+    {
+        std::cout << "  " << std::left << std::setw(28) << label << std::right << std::setw(14) << std::fixed << std::setprecision(2)
+                  << 1e6 * seconds / EXPRESSIONS << " us/expression";
+        if (reference > 0.0) std::cout << "  (" << reference / seconds << "x)";
+        std::cout << '\n';
+    };
+
+    // Reference: the per-alias regex replacement ExpandAliases_ used before the precompiled alias table.
+    std::vector<std::string> reference;
+    const auto regexStart = Clock::now();
+    for (const auto &expression : expressions)
+    {
+        std::string result = expression;
+        for (const auto &[alias, name] : table)
+            result = std::regex_replace(result, std::regex("\\b" + alias + "\\b"), name);
+        reference.push_back(std::move(result));
+    }
+    const double regexSeconds = SecondsSince(regexStart);
+    print("regex per alias", regexSeconds);
+
+    AnalysisManager manager;
+    const auto loadStart = Clock::now();
+    manager.LoadInputConfig((options.WorkDirectory / "toy-wide-input.yaml").string());
+    std::cout << "  input config load            " << std::setprecision(1) << 1e3 * SecondsSince(loadStart) << " ms\n";
+    std::vector<std::string> rewritten;
+    const auto tableStart = Clock::now();
+    for (const auto &expression : expressions)
+        rewritten.push_back(manager.ExpandAliases(expression));
+    print("precompiled alias table", SecondsSince(tableStart), regexSeconds);
+    if (rewritten != reference) throw std::runtime_error("cascade-bench: alias table output differs from the regex rewrite");
+    return 0;
+}
+
+// Scheduling cost of no-op nodes in a sample-expansion shaped graph: 100 independent chains, each node depending on
+// the node 100 positions before it.
+int BenchDag(const BenchOptions &)
+{
+    constexpr int nodeCount = 10000;
+    constexpr int chains = 100;
+    std::cout << "dag: " << nodeCount << " no-op nodes in " << chains << " chains\n";
+    for (const auto &[label, lane] : std::vector<std::pair<std::string, DAGExecutionLane>>{{"parallel lane", DAGExecutionLane::Parallel},
+                                                                                          {"serial lane", DAGExecutionLane::Serial}})
+    {
+        DAGManager dag;
+        for (int index = 0; index < nodeCount; ++index)
+        {
+            std::vector<std::string> dependencies;
+            if (index >= chains) dependencies.push_back(std::to_string(index - chains));
+            dag.AddNode(std::to_string(index), dependencies, []() {}, lane);
+        }
+        const auto start = Clock::now();
+        if (!dag.Execute().Succeeded()) throw std::runtime_error("cascade-bench: no-op DAG failed");
+        const double seconds = SecondsSince(start);
+        std::cout << "  " << std::left << std::setw(28) << label << std::right << std::setw(14) << std::fixed << std::setprecision(2)
+                  << seconds * 1e6 / nodeCount << " us/node\n";
+    }
+
+    // A 300-node workflow on four workers whose 60-node chain sorts after 240 independent nodes: topological dispatch
+    // starts the chain last, critical-path dispatch starts it first.
+    constexpr int workflowNodes = 300;
+    constexpr int chainNodes = 60;
+    constexpr auto nodeTime = std::chrono::milliseconds(2);
+    const char *configuredWorkers = std::getenv("CASCADE_DAG_MAX_WORKERS");
+    const std::string previousWorkers = configuredWorkers ? configuredWorkers : "";
+    setenv("CASCADE_DAG_MAX_WORKERS", "4", 1);
+    std::cout << "dag: " << workflowNodes << " nodes of " << nodeTime.count() << " ms with a " << chainNodes << "-node chain, 4 workers\n";
+    for (const bool knownDurations : {false, true})
+    {
+        DAGManager dag;
+        for (int index = 0; index < workflowNodes; ++index)
+        {
+            const bool chained = index >= workflowNodes - chainNodes;
+            const std::string name = (chained ? "tail-" : "leaf-") + std::to_string(1000 + index);
+            std::vector<std::string> dependencies;
+            if (chained && index > workflowNodes - chainNodes) dependencies.push_back("tail-" + std::to_string(999 + index));
+            dag.AddNode(name, dependencies, [nodeTime]() { std::this_thread::sleep_for(nodeTime); }, DAGExecutionLane::Parallel);
+            if (knownDurations) dag.SetExpectedDuration(name, std::chrono::duration<double>(nodeTime).count());
+        }
+        const auto start = Clock::now();
+        if (!dag.Execute().Succeeded()) throw std::runtime_error("cascade-bench: workflow DAG failed");
+        const double seconds = SecondsSince(start);
+        std::cout << "  " << std::left << std::setw(28) << (knownDurations ? "critical-path order" : "topological order") << std::right
+                  << std::setw(14) << std::fixed << std::setprecision(2) << seconds * 1e3 << " ms makespan\n";
+    }
+
+    // Serial bookkeeping nodes that each follow one pooled node used to drain the pool before running.
+    constexpr int pooledNodes = 200;
+    constexpr int bookkeepingNodes = 20;
+    std::cout << "dag: " << pooledNodes << " pooled and " << bookkeepingNodes << " serial nodes of " << nodeTime.count() << " ms, 4 workers\n";
+    {
+        DAGManager dag;
+        for (int index = 0; index < pooledNodes; ++index)
+            dag.AddNode("pooled-" + std::to_string(index), {}, [nodeTime]() { std::this_thread::sleep_for(nodeTime); }, DAGExecutionLane::Parallel);
+        for (int index = 0; index < bookkeepingNodes; ++index)
+            dag.AddNode("bookkeeping-" + std::to_string(index), {"pooled-" + std::to_string(index * pooledNodes / bookkeepingNodes)},
+                        [nodeTime]() { std::this_thread::sleep_for(nodeTime); });
+        const auto start = Clock::now();
+        if (!dag.Execute().Succeeded()) throw std::runtime_error("cascade-bench: serial DAG failed");
+        const double seconds = SecondsSince(start);
+        std::cout << "  " << std::left << std::setw(28) << "serial beside pool" << std::right << std::setw(14) << std::fixed << std::setprecision(2)
+                  << seconds * 1e3 << " ms makespan\n";
+    }
+    if (configuredWorkers)
+        setenv("CASCADE_DAG_MAX_WORKERS", previousWorkers.c_str(), 1);
+    else
+        unsetenv("CASCADE_DAG_MAX_WORKERS");
+    return 0;
+}
+
+// Seconds to fill one RDF histogram per column from the named dataset in path, excluding dataframe construction.
+double TimeRdfRead(const BenchOptions &options, const std::filesystem::path &path, const std::string &name = "events",
+                   const std::vector<std::string> &columns = {"pt", "eta", "phi", "mass", "n_jets", "lumi", "event", "trigger"})
+{
+    AnalysisManager manager;
+    manager.InitRdfFromFile(name, path.string());
+    for (const auto &column : columns)
+        manager.BookRdfHistogram1D(column, "", {50, 0, 100}, column);
+    const auto start = Clock::now();
+    manager.WriteRdfHistograms((options.WorkDirectory / "toy-read-histograms.root").string());
+    return SecondsSince(start);
+}
+
+// Snapshots the toy sample with each compression algorithm at its default level, then reads every column back.
+int BenchCompression(const BenchOptions &options)
+{
+    const auto sample = WriteToySample(options);
+    std::cout << "compression: " << options.Events << " events\n";
+    double referenceWrite = 0.0;
+    double referenceRead = 0.0;
+    for (const char *algorithm : {"zlib", "lz4", "zstd"})
+    {
+        const auto path = options.WorkDirectory / (std::string("toy-events-") + algorithm + ".root");
+        OutputSettings settings;
+        settings.Algorithm = algorithm;
+        AnalysisManager manager;
+        manager.InitRdfFromFile("events", sample.string());
+        const auto start = Clock::now();
+        manager.WriteRdfSnapshot("events", path.string(), TreeOpt::Om::Append, DataFormat::TTree, settings);
+        const double writeSeconds = SecondsSince(start);
+        const double readSeconds = TimeRdfRead(options, path);
+        std::cout << "  " << algorithm << ": " << std::filesystem::file_size(path) / 1024 << " KiB\n";
+        PrintRate(std::string(algorithm) + " write", options.Events, writeSeconds, referenceWrite);
+        PrintRate(std::string(algorithm) + " read", options.Events, readSeconds, referenceRead);
+        if (referenceWrite == 0.0)
+        {
+            referenceWrite = writeSeconds;
+            referenceRead = readSeconds;
+        }
+    }
+    return 0;
+}
+
+// Reads the toy dimuon sample as a TTree and as an RNTuple snapshot of it, filling the same histograms through RDF. One
+// untimed pass warms the page cache for both files; the timed rounds then alternate which format goes first and the best
+// round of each is reported.
+int BenchRNTuple(const BenchOptions &options)
+{
+#if ROOT_VERSION_CODE >= ROOT_VERSION(6, 36, 0)
+    const auto sample = WriteDimuonSample(options);
+    const auto ntuple = options.WorkDirectory / "toy-dimuons-rntuple.root";
+    {
+        AnalysisManager manager;
+        manager.InitRdfFromFile("Events", sample.string());
+        manager.WriteRdfSnapshot("Events", ntuple.string(), TreeOpt::Om::Append, DataFormat::RNTuple);
+    }
+    std::cout << "rntuple: " << options.Events << " toy dimuon events, TTree " << std::filesystem::file_size(sample) / 1024
+              << " KiB, RNTuple " << std::filesystem::file_size(ntuple) / 1024 << " KiB\n";
+
+    const std::vector<std::string> columns{"event",  "is_signal", "weight", "generated_mass", "mu1_pt",  "mu1_eta",
+                                           "mu1_phi", "mu1_charge", "mu2_pt", "mu2_eta",        "mu2_phi", "mu2_charge"};
+    const auto read = [&](const std::filesystem::path &path) { return TimeRdfRead(options, path, "Events", columns); };
+    read(sample);
+    read(ntuple);
+    double treeSeconds = std::numeric_limits<double>::max();
+    double ntupleSeconds = std::numeric_limits<double>::max();
+    for (int round = 0; round < 4; ++round)
+    {
+        if (round % 2 == 0) treeSeconds = std::min(treeSeconds, read(sample));
+        ntupleSeconds = std::min(ntupleSeconds, read(ntuple));
+        if (round % 2 == 1) treeSeconds = std::min(treeSeconds, read(sample));
+    }
+    PrintRate("TTree read", options.Events, treeSeconds);
+    PrintRate("RNTuple read", options.Events, ntupleSeconds, treeSeconds);
+    return 0;
+#else
+    (void)options;
+    std::cerr << "cascade-bench: rntuple needs ROOT 6.36 or newer\n";
+    return 1;
+#endif
+}
+
+const std::map<std::string, std::function<int(const BenchOptions &)>> &Benchmarks()
+{
+    static const std::map<std::string, std::function<int(const BenchOptions &)>> benchmarks{
+        {"aliases", BenchAliases},
+        {"compression", BenchCompression},
+        {"cuts", BenchCuts},
+        {"dag", BenchDag},
+        {"fill-plan", BenchFillPlan},
+        {"rntuple", BenchRNTuple},
+    };
+    return benchmarks;
+}
+
+int Usage(int status)
+{
+    std::ostream &output = status == 0 ? std::cout : std::cerr;
+    output << "Usage: cascade-bench <benchmark> [--events N] [--histograms N] [--workdir PATH]\n\nBenchmarks:\n";
+    for (const auto &[name, _] : Benchmarks())
+        output << "  " << name << '\n';
+    return status;
+}
+
+long long ParsePositive(const std::string &option, const char *value)
+{
+    char *end = nullptr;
+    const long long parsed = std::strtoll(value, &end, 10);
+    if (end == value || *end != '\0' || parsed <= 0) throw std::invalid_argument("cascade-bench: " + option + " must be a positive integer");
+    return parsed;
+}
+} // namespace
+
+int main(int argc, char **argv)
+{
+    if (argc < 2) return Usage(2);
+    const std::string name = argv[1];
+    if (name == "-h" || name == "--help") return Usage(0);
+    const auto benchmark = Benchmarks().find(name);
+    if (benchmark == Benchmarks().end()) return Usage(2);
+
+    try
+    {
+        BenchOptions options;
+        for (int index = 2; index < argc; ++index)
+        {
+            const std::string option = argv[index];
+            if (index + 1 >= argc) return Usage(2);
+            const char *value = argv[++index];
+            if (option == "--events")
+                options.Events = ParsePositive(option, value);
+            else if (option == "--histograms")
+                options.Histograms = static_cast<int>(ParsePositive(option, value));
+            else if (option == "--workdir")
+                options.WorkDirectory = value;
+            else
+                return Usage(2);
+        }
+        logger::Logger::Get().SetLogLevel(logger::LogLevel::WARN);
+        return benchmark->second(options);
+    }
+    catch (const std::exception &error)
+    {
+        std::cerr << error.what() << '\n';
+        return 1;
+    }
+}
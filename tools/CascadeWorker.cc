@@ -1,4 +1,5 @@
 #include "AMCM.hh"
+#include "ExecutionResources.hh"
 #include "IsolatedWorker.hh"
 
 #include <algorithm>
@@ -139,6 +140,8 @@ int main(int argc, char **argv)
         module->SetCacheDirectory(request.at("cache_directory").get<std::string>());
         module->SetOutputDirectory(request.at("output_directory").get<std::string>());
         module->SetParamsFromJSON(request.at("params").dump());
+        // The threads the parent's DAG granted this node; 0 when the module runs outside a DAG.
+        CascadeNodeThreads() = request.value("threads", 0U);
         module->PrepareExternalRunWithId(request.at("run_id").get<std::string>());
         result = module->RunPreparedExternal();
     }